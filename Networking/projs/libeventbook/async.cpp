@@ -0,0 +1,123 @@
+#include "async.h"
+#include "iostats.h"
+#include "net.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+AsyncSocket::AsyncSocket(Reactor& reactor, int fd) : reactor_(reactor) {
+    if (fd >= 0) attach(fd);
+}
+
+void AsyncSocket::attach(int fd) {
+    fd_ = fd;
+    eof_ = false;
+    reactor_.add(fd_, EPOLLIN | EPOLLOUT | EPOLLRDHUP, this);
+}
+
+void AsyncSocket::close() {
+    if (fd_ < 0) return;
+    reactor_.remove(fd_, this);
+    ::close(fd_);
+    ++net::syscalls;
+    fd_ = -1;
+}
+
+// Finishes both sides and takes both handles before resuming either: the
+// first coroutine to run may destroy this socket, or end the other
+// operation's wait, so nothing but the two local handles is touched after.
+void AsyncSocket::resume(Op* r, Op* w) {
+    const std::coroutine_handle<> reader = r ? r->handle : nullptr;
+    const std::coroutine_handle<> writer = w ? w->handle : nullptr;
+    if (reader) reader.resume();
+    if (writer) writer.resume();
+}
+
+void AsyncSocket::onEvents(uint32_t events) {
+    Op* r = nullptr;
+    Op* w = nullptr;
+    if (reader_ && (events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) && reader_->attempt())
+        r = std::exchange(reader_, nullptr);
+    if (writer_ && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) && writer_->attempt())
+        w = std::exchange(writer_, nullptr);
+    resume(r, w);
+}
+
+void AsyncSocket::cancel() {
+    Op* r = std::exchange(reader_, nullptr);
+    Op* w = std::exchange(writer_, nullptr);
+    if (r) r->cancelled = true;
+    if (w) w->cancelled = true;
+    resume(r, w);
+}
+
+bool AsyncSocket::ReadOp::attempt() {
+    if (s_.eof_) {
+        result_ = 0;
+        return true;
+    }
+    bool eof;
+    const ssize_t n = in_.readFrom(s_.fd_, eof);
+    if (n < 0) {
+        result_ = -errno;
+        return true;
+    }
+    // data and the end of stream can arrive together; report the data now
+    // and the end on the next read
+    s_.eof_ = eof;
+    result_ = n;
+    return n > 0 || eof;
+}
+
+bool AsyncSocket::WriteOp::attempt() {
+    while (!data_.empty()) {
+        const ssize_t n = ::send(s_.fd_, data_.data(), data_.size(), MSG_NOSIGNAL);
+        ++net::syscalls;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return false;
+            result_ = -errno;
+            return true;
+        }
+        data_.remove_prefix(static_cast<size_t>(n));
+    }
+    result_ = 0;
+    return true;
+}
+
+bool AsyncSocket::ConnectOp::await_ready() {
+    s_.close();
+    try {
+        s_.attach(net::connectTcp(to_));
+    } catch (const std::system_error& e) {
+        result_ = -e.code().value();
+        return true;
+    }
+    return false; // writable once the handshake is done
+}
+
+bool AsyncSocket::ConnectOp::attempt() {
+    result_ = -net::connectError(s_.fd_);
+    if (result_ == 0) net::setNoDelay(s_.fd_);
+    return true;
+}
+
+bool AsyncSocket::AcceptOp::attempt() {
+    for (;;) {
+        const int fd = ::accept4(s_.fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        ++net::syscalls;
+        if (fd >= 0) {
+            net::setNoDelay(fd);
+            result_ = fd;
+            return true;
+        }
+        if (errno == EINTR || errno == ECONNABORTED) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return false;
+        result_ = -errno;
+        return true;
+    }
+}
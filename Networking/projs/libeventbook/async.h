@@ -0,0 +1,183 @@
+#pragma once
+
+// Awaitable sockets and timers for Task coroutines on a Reactor.
+//
+// An AsyncSocket is registered once, edge-triggered, like a Connection.
+// Each operation first tries its syscall; only on EAGAIN does the
+// coroutine suspend, and the socket finishes the operation itself when
+// epoll reports readiness before resuming it. One read-side (read,
+// accept) and one write-side (write, connect) operation may be pending at
+// a time, and the socket must outlive them. Results follow the syscalls:
+// a negative errno on failure.
+//
+// A coroutine must not be destroyed while it waits, so tasks on sockets
+// are spawn()ed and run to the end; timeouts cancel() the socket instead.
+
+#include "buffer.h"
+#include "reactor.h"
+
+#include <netinet/in.h>
+#include <sys/types.h>
+
+#include <cerrno>
+#include <coroutine>
+#include <string_view>
+
+class AsyncSocket final : public EventHandler {
+    struct Op;
+
+public:
+    class ReadOp;
+    class WriteOp;
+    class ConnectOp;
+    class AcceptOp;
+
+    // takes ownership of fd, a non-blocking socket (or none, to connect())
+    explicit AsyncSocket(Reactor& reactor, int fd = -1);
+    ~AsyncSocket() { close(); }
+    AsyncSocket(const AsyncSocket&) = delete;
+    AsyncSocket& operator=(const AsyncSocket&) = delete;
+
+    // appends what the socket has to in: bytes read, 0 at end of stream
+    ReadOp read(Buffer& in);
+    // writes all of data (which must stay valid): 0 when done
+    WriteOp write(std::string_view data);
+    // opens a socket and connects it: 0 once connected
+    ConnectOp connect(const sockaddr_in& to);
+    // on a listening socket: the next connection's fd
+    AcceptOp accept();
+
+    // completes pending operations with -ECANCELED, e.g. on a timeout
+    void cancel();
+    void close();
+
+    int fd() const { return fd_; }
+    Reactor& reactor() { return reactor_; }
+
+    void onEvents(uint32_t events) override;
+
+private:
+    struct Op {
+        std::coroutine_handle<> handle;
+        bool cancelled = false;
+
+        // retries the operation; true once it has finished
+        virtual bool attempt() = 0;
+
+    protected:
+        ~Op() = default;
+    };
+
+    void attach(int fd);
+    static void resume(Op* r, Op* w);
+
+    Reactor& reactor_;
+    int fd_ = -1;
+    bool eof_ = false;
+    Op* reader_ = nullptr;
+    Op* writer_ = nullptr;
+
+public:
+    class ReadOp : Op {
+    public:
+        ReadOp(AsyncSocket& s, Buffer& in) : s_(s), in_(in) {}
+        bool await_ready() { return attempt(); }
+        void await_suspend(std::coroutine_handle<> h) {
+            handle = h;
+            s_.reader_ = this;
+        }
+        ssize_t await_resume() const { return cancelled ? -ECANCELED : result_; }
+
+    private:
+        bool attempt() override;
+        AsyncSocket& s_;
+        Buffer& in_;
+        ssize_t result_ = 0;
+    };
+
+    class WriteOp : Op {
+    public:
+        WriteOp(AsyncSocket& s, std::string_view data) : s_(s), data_(data) {}
+        bool await_ready() { return attempt(); }
+        void await_suspend(std::coroutine_handle<> h) {
+            handle = h;
+            s_.writer_ = this;
+        }
+        int await_resume() const { return cancelled ? -ECANCELED : result_; }
+
+    private:
+        bool attempt() override;
+        AsyncSocket& s_;
+        std::string_view data_;
+        int result_ = 0;
+    };
+
+    class ConnectOp : Op {
+    public:
+        ConnectOp(AsyncSocket& s, const sockaddr_in& to) : s_(s), to_(to) {}
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> h) {
+            handle = h;
+            s_.writer_ = this;
+        }
+        int await_resume() const { return cancelled ? -ECANCELED : result_; }
+
+    private:
+        bool attempt() override;
+        AsyncSocket& s_;
+        sockaddr_in to_;
+        int result_ = 0;
+    };
+
+    class AcceptOp : Op {
+    public:
+        explicit AcceptOp(AsyncSocket& s) : s_(s) {}
+        bool await_ready() { return attempt(); }
+        void await_suspend(std::coroutine_handle<> h) {
+            handle = h;
+            s_.reader_ = this;
+        }
+        int await_resume() const { return cancelled ? -ECANCELED : result_; }
+
+    private:
+        bool attempt() override;
+        AsyncSocket& s_;
+        int result_ = -1;
+    };
+};
+
+inline AsyncSocket::ReadOp AsyncSocket::read(Buffer& in) { return {*this, in}; }
+inline AsyncSocket::WriteOp AsyncSocket::write(std::string_view data) { return {*this, data}; }
+inline AsyncSocket::ConnectOp AsyncSocket::connect(const sockaddr_in& to) { return {*this, to}; }
+inline AsyncSocket::AcceptOp AsyncSocket::accept() { return AcceptOp(*this); }
+
+// co_await sleepFor(reactor, d) resumes the coroutine from a reactor timer
+class SleepOp {
+public:
+    SleepOp(Reactor& reactor, Reactor::Clock::duration d) : reactor_(reactor), d_(d) {}
+    bool await_ready() const { return d_ <= Reactor::Clock::duration::zero(); }
+    void await_suspend(std::coroutine_handle<> h) {
+        reactor_.runAfter(d_, [h] { h.resume(); });
+    }
+    void await_resume() const {}
+
+private:
+    Reactor& reactor_;
+    Reactor::Clock::duration d_;
+};
+
+inline SleepOp sleepFor(Reactor& reactor, Reactor::Clock::duration d) { return {reactor, d}; }
+
+// cancels the socket's pending operations if still alive after d
+class Deadline {
+public:
+    Deadline(AsyncSocket& s, Reactor::Clock::duration d)
+        : reactor_(s.reactor()), id_(reactor_.runAfter(d, [&s] { s.cancel(); })) {}
+    ~Deadline() { reactor_.cancel(id_); }
+    Deadline(const Deadline&) = delete;
+    Deadline& operator=(const Deadline&) = delete;
+
+private:
+    Reactor& reactor_;
+    Reactor::TimerId id_;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+// Growable byte buffer for non-blocking sockets: data is appended at the
+// write end and consumed from the read end, and the space in front is
+// reclaimed by sliding the readable bytes back instead of reallocating.
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "iostats.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+class Buffer {
+public:
+    explicit Buffer(size_t initial = 4096) : data_(initial) {}
+
+    size_t readable() const { return write_ - read_; }
+    bool empty() const { return read_ == write_; }
+    const char* peek() const { return data_.data() + read_; }
+    std::string_view view() const { return {peek(), readable()}; }
+
+    void consume(size_t n) {
+        read_ += std::min(n, readable());
+        if (read_ == write_) read_ = write_ = 0;
+    }
+
+    void clear() { read_ = write_ = 0; }
+
+    void append(const void* p, size_t n) {
+        ensureWritable(n);
+        std::memcpy(data_.data() + write_, p, n);
+        write_ += n;
+    }
+
+    void append(std::string_view s) { append(s.data(), s.size()); }
+
+    // Reads until the socket would block, as edge-triggered readiness
+    // requires. Returns the bytes read, or -1 with errno set on an error
+    // before any data; eof is set when the peer has finished sending.
+    ssize_t readFrom(int fd, bool& eof) {
+        ssize_t total = 0;
+        eof = false;
+        for (;;) {
+            // spill into a stack buffer so one readv drains a burst without
+            // growing data_ up front
+            char extra[65536];
+            ensureWritable(1024);
+            const size_t room = data_.size() - write_;
+            iovec iov[2] = {{data_.data() + write_, room}, {extra, sizeof(extra)}};
+            const ssize_t n = ::readv(fd, iov, 2);
+            ++net::syscalls;
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return total;
+                return total > 0 ? total : -1;
+            }
+            if (n == 0) {
+                eof = true;
+                return total;
+            }
+            if (static_cast<size_t>(n) <= room) {
+                write_ += n;
+            } else {
+                write_ = data_.size();
+                append(extra, n - room);
+            }
+            total += n;
+        }
+    }
+
+    // Writes as much as the socket takes. Returns bytes written or -1 with
+    // errno set (EAGAIN is not an error).
+    ssize_t writeTo(int fd) {
+        ssize_t total = 0;
+        while (!empty()) {
+            const ssize_t n = ::send(fd, peek(), readable(), MSG_NOSIGNAL);
+            ++net::syscalls;
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return -1;
+            }
+            consume(n);
+            total += n;
+        }
+        return total;
+    }
+
+private:
+    void ensureWritable(size_t n) {
+        if (data_.size() - write_ >= n) return;
+        if (read_ > 0 && data_.size() - readable() >= n) {
+            std::memmove(data_.data(), peek(), readable());
+            write_ -= read_;
+            read_ = 0;
+            if (data_.size() - write_ >= n) return;
+        }
+        data_.resize(std::max(data_.size() * 2, write_ + n));
+    }
+
+    std::vector<char> data_;
+    size_t read_ = 0;
+    size_t write_ = 0;
+};
@@ -0,0 +1,112 @@
+// HTTP client written as coroutines: each connection is one Task that
+// connects, then sends `count` requests one after another on keep-alive,
+// as straight-line code with a timeout around every step. All connections
+// share one reactor thread, and so does the lookup of the host name.
+//
+//   g++ -std=c++20 -O2 co_fetch.cpp async.cpp resolver.cpp reactor.cpp net.cpp -o co_fetch
+//   ./co_fetch [host] [port] [path] [connections] [requests per connection]
+
+#include "async.h"
+#include "http.h"
+#include "net.h"
+#include "resolver.h"
+#include "task.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+struct Totals {
+    int running = 0;
+    int failed = 0;
+    uint64_t responses = 0;
+    uint64_t bytes = 0;
+};
+
+// reads until in holds one whole response; its size, or <= 0 on error or EOF
+Task<ssize_t> readResponse(AsyncSocket& sock, Buffer& in) {
+    for (;;) {
+        if (const auto head = http::parseHead(in.view())) {
+            const size_t size = head->headBytes + head->contentLength;
+            if (in.readable() >= size) co_return static_cast<ssize_t>(size);
+        }
+        const ssize_t n = co_await sock.read(in);
+        if (n <= 0) co_return n;
+    }
+}
+
+Task<> fetch(Reactor& reactor, sockaddr_in to, const std::string& request, int count, Totals& totals) {
+    AsyncSocket sock(reactor);
+    int err;
+    {
+        Deadline deadline(sock, 3s);
+        err = co_await sock.connect(to);
+    }
+    for (int i = 0; err == 0 && i < count; ++i) {
+        Deadline deadline(sock, 5s);
+        err = co_await sock.write(request);
+        if (err < 0) break;
+        Buffer in;
+        const ssize_t size = co_await readResponse(sock, in);
+        if (size <= 0) {
+            err = size < 0 ? static_cast<int>(size) : -ECONNRESET;
+            break;
+        }
+        ++totals.responses;
+        totals.bytes += static_cast<uint64_t>(size);
+    }
+    if (err < 0) {
+        ++totals.failed;
+        std::fprintf(stderr, "connection failed: %s\n", std::strerror(-err));
+    }
+    if (--totals.running == 0) reactor.stop();
+}
+
+Task<> start(Reactor& reactor, Resolver& resolver, const std::string& host, uint16_t port,
+             const std::string& request, int connections, int count, Totals& totals) {
+    const Resolution r = co_await resolver.resolve(host);
+    if (r.status != ResolveStatus::Ok) {
+        std::fprintf(stderr, "%s: %s\n", host.c_str(), toString(r.status));
+        totals.failed = connections;
+        reactor.stop();
+        co_return;
+    }
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(port);
+    to.sin_addr = r.addresses.front();
+    totals.running = connections;
+    for (int i = 0; i < connections; ++i) spawn(fetch(reactor, to, request, count, totals));
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+    const uint16_t port = static_cast<uint16_t>(argc > 2 ? std::atoi(argv[2]) : 8080);
+    const std::string request =
+        "GET " + std::string(argc > 3 ? argv[3] : "/") + " HTTP/1.1\r\nHost: " + host + "\r\n\r\n";
+    const int connections = argc > 4 ? std::atoi(argv[4]) : 10;
+    const int count = argc > 5 ? std::atoi(argv[5]) : 1000;
+    net::raiseFdLimit();
+
+    Reactor reactor;
+    Resolver resolver(reactor);
+    Totals totals;
+    const auto begin = Reactor::Clock::now();
+    spawn(start(reactor, resolver, host, port, request, connections, count, totals));
+    if (connections > 0) reactor.run();
+    const double secs = std::chrono::duration<double>(Reactor::Clock::now() - begin).count();
+
+    std::printf("%llu responses (%llu bytes) in %.2f s = %.0f req/s, %d of %d connections failed\n",
+                static_cast<unsigned long long>(totals.responses), static_cast<unsigned long long>(totals.bytes), secs,
+                static_cast<double>(totals.responses) / secs, totals.failed, connections);
+    return totals.failed > 0;
+}
@@ -0,0 +1,152 @@
+// HTTP/1.1 server written as coroutines: one spawn()ed Task per connection
+// reads, answers and writes in order, like a thread-per-connection server,
+// but every connection of a thread shares one epoll reactor. With more
+// than one thread, each runs its own reactor on its own SO_REUSEPORT
+// listening socket.
+//
+// Heap allocations are counted (operator new is replaced below) and
+// printed per request: with keep-alive clients it settles at 0, as the
+// per-request task frames are recycled by FramePool.
+//
+//   g++ -std=c++20 -O2 co_http_server.cpp async.cpp reactor.cpp net.cpp -o co_http_server
+//   ./co_http_server [port] [threads] [idle seconds]
+
+#include "async.h"
+#include "net.h"
+#include "protocols.h"
+#include "task.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> heapAllocations{0};
+std::atomic<uint64_t> requests{0};
+
+} // namespace
+
+void* operator new(size_t n) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+using Clock = Reactor::Clock;
+using namespace std::chrono_literals;
+
+// Cancels the socket once nothing has arrived for `idle`. Like
+// http_server's Session, requests only bump lastActive and the timer
+// re-arms itself when it fires early.
+class IdleTimer {
+public:
+    IdleTimer(AsyncSocket& s, Clock::duration idle) : s_(s), idle_(idle), lastActive_(s.reactor().now()) { arm(); }
+    ~IdleTimer() { s_.reactor().cancel(id_); }
+
+    void touch() { lastActive_ = s_.reactor().now(); }
+
+private:
+    void arm() {
+        id_ = s_.reactor().runAt(lastActive_ + idle_, [this] {
+            if (s_.reactor().now() - lastActive_ >= idle_)
+                s_.cancel();
+            else
+                arm();
+        });
+    }
+
+    AsyncSocket& s_;
+    Clock::duration idle_;
+    Clock::time_point lastActive_;
+    Reactor::TimerId id_;
+};
+
+// answers the complete requests in `in`; false once the connection is done
+Task<bool> respond(AsyncSocket& sock, Buffer& in, Buffer& out) {
+    Exchange ex{out};
+    in.consume(serveHttp(in.view(), ex));
+    requests.fetch_add(ex.responses, std::memory_order_relaxed);
+    if (!out.empty()) {
+        if (co_await sock.write(out.view()) < 0) co_return false;
+        out.clear();
+    }
+    co_return !ex.close;
+}
+
+Task<> session(Reactor& reactor, int fd, Clock::duration idle) {
+    AsyncSocket sock(reactor, fd);
+    IdleTimer timer(sock, idle);
+    Buffer in, out;
+    while (co_await sock.read(in) > 0) {
+        timer.touch();
+        if (!co_await respond(sock, in, out)) break;
+    }
+}
+
+Task<> acceptLoop(AsyncSocket& listener, Clock::duration idle) {
+    for (;;) {
+        const int fd = co_await listener.accept();
+        if (fd >= 0) {
+            spawn(session(listener.reactor(), fd, idle));
+        } else if (fd == -EMFILE || fd == -ENFILE) {
+            // the backlog stays queued; try again once some connections closed
+            co_await sleepFor(listener.reactor(), 100ms);
+        } else {
+            std::fprintf(stderr, "accept: %s\n", std::strerror(-fd));
+            co_return;
+        }
+    }
+}
+
+Task<> report(Reactor& reactor) {
+    uint64_t lastRequests = 0, lastAllocations = 0;
+    for (;;) {
+        co_await sleepFor(reactor, 1s);
+        const uint64_t reqs = requests.load() - lastRequests, allocs = heapAllocations.load() - lastAllocations;
+        if (reqs > 0)
+            std::printf("%10llu req/s  %7.4f heap allocations/req  frames: %llu new, %llu recycled\n",
+                        static_cast<unsigned long long>(reqs), static_cast<double>(allocs) / static_cast<double>(reqs),
+                        static_cast<unsigned long long>(FramePool::fresh()),
+                        static_cast<unsigned long long>(FramePool::reused()));
+        std::fflush(stdout);
+        lastRequests += reqs;
+        lastAllocations += allocs;
+    }
+}
+
+void runLoop(uint16_t port, bool reusePort, Clock::duration idle, bool reporter) {
+    Reactor reactor;
+    AsyncSocket listener(reactor, net::listenTcp("0.0.0.0", port, 4096, reusePort));
+    spawn(acceptLoop(listener, idle));
+    if (reporter) spawn(report(reactor));
+    reactor.run();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const uint16_t port = static_cast<uint16_t>(argc > 1 ? std::atoi(argv[1]) : 8080);
+    const int threads = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1;
+    const std::chrono::seconds idle(argc > 3 ? std::atoi(argv[3]) : 30);
+    std::printf("coroutine http server on port %u, %d thread(s), fd limit %ld\n", port, threads, net::raiseFdLimit());
+    std::fflush(stdout);
+
+    std::vector<std::thread> others;
+    for (int i = 1; i < threads; ++i) others.emplace_back(runLoop, port, true, idle, false);
+    runLoop(port, threads > 1, idle, true);
+    for (std::thread& t : others) t.join();
+    return 0;
+}
@@ -0,0 +1,206 @@
+// Stub DNS server for trying out the resolver: answers A queries over UDP
+// from records given on the command line and logs every query, so cache
+// hits show up as queries that never arrive.
+//
+//   g++ -std=c++20 -O2 dns_stub.cpp -o dns_stub
+//   ./dns_stub [port] [record...]
+//
+// A record is name=VALUE[/ttl] (ttl defaults to 60) with VALUE one of
+//   1.2.3.4,5.6.7.8   A records
+//   cname:other.name  an alias, followed if other.name is a record too
+//   nodata            the name exists but has no A record
+//   servfail          SERVFAIL
+//   drop              no reply at all, to exercise timeouts
+// Other names get NXDOMAIN, with an SOA giving a negative TTL of 30 s.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Record {
+    std::vector<in_addr> addresses;
+    std::string cname;
+    std::string special; // nodata, servfail, drop
+    uint32_t ttl = 60;
+};
+
+std::map<std::string, Record> records;
+
+std::string lower(std::string s) {
+    for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+void put16(std::string& out, uint16_t v) {
+    out += static_cast<char>(v >> 8);
+    out += static_cast<char>(v & 0xff);
+}
+
+void put32(std::string& out, uint32_t v) {
+    put16(out, static_cast<uint16_t>(v >> 16));
+    put16(out, static_cast<uint16_t>(v & 0xffff));
+}
+
+void putName(std::string& out, const std::string& name) {
+    size_t start = 0;
+    while (start < name.size()) {
+        size_t dot = name.find('.', start);
+        if (dot == std::string::npos) dot = name.size();
+        out += static_cast<char>(dot - start);
+        out += name.substr(start, dot - start);
+        start = dot + 1;
+    }
+    out += '\0';
+}
+
+void putRecord(std::string& out, const std::string& owner, uint16_t type, uint32_t ttl, const std::string& data) {
+    putName(out, owner);
+    put16(out, type);
+    put16(out, 1);
+    put32(out, ttl);
+    put16(out, static_cast<uint16_t>(data.size()));
+    out += data;
+}
+
+bool parseRecord(const std::string& arg) {
+    const size_t eq = arg.find('=');
+    if (eq == std::string::npos) return false;
+    Record rec;
+    std::string value = arg.substr(eq + 1);
+    if (const size_t slash = value.find('/'); slash != std::string::npos) {
+        rec.ttl = static_cast<uint32_t>(std::strtoul(value.c_str() + slash + 1, nullptr, 10));
+        value.resize(slash);
+    }
+    if (value.rfind("cname:", 0) == 0) {
+        rec.cname = lower(value.substr(6));
+    } else if (value == "nodata" || value == "servfail" || value == "drop") {
+        rec.special = value;
+    } else {
+        for (size_t start = 0; start <= value.size();) {
+            size_t comma = value.find(',', start);
+            if (comma == std::string::npos) comma = value.size();
+            in_addr a{};
+            if (::inet_pton(AF_INET, value.substr(start, comma - start).c_str(), &a) != 1) return false;
+            rec.addresses.push_back(a);
+            start = comma + 1;
+        }
+    }
+    records[lower(arg.substr(0, eq))] = rec;
+    return true;
+}
+
+// the reply to query, or "" for none
+std::string answer(const std::string& query, std::string& name) {
+    if (query.size() < 12) return {};
+    size_t pos = 12;
+    name.clear();
+    while (pos < query.size() && query[pos] != 0) {
+        const size_t len = static_cast<uint8_t>(query[pos]);
+        if (len > 63 || pos + 1 + len > query.size()) return {};
+        if (!name.empty()) name += '.';
+        name += lower(query.substr(pos + 1, len));
+        pos += 1 + len;
+    }
+    if (pos + 5 > query.size()) return {};
+    const size_t questionEnd = pos + 5;
+    const uint16_t type = static_cast<uint16_t>(static_cast<uint8_t>(query[pos + 1]) << 8 | static_cast<uint8_t>(query[pos + 2]));
+
+    std::string answers;
+    uint16_t count = 0, authority = 0, rcode = 0;
+    std::string owner = name;
+    for (int hops = 0; hops < 8; ++hops) {
+        const auto it = records.find(owner);
+        if (it == records.end()) {
+            if (hops == 0) rcode = 3;
+            break;
+        }
+        const Record& rec = it->second;
+        if (rec.special == "drop") return {};
+        if (rec.special == "servfail") rcode = 2;
+        if (!rec.cname.empty()) {
+            std::string target;
+            putName(target, rec.cname);
+            putRecord(answers, owner, 5, rec.ttl, target);
+            ++count;
+            owner = rec.cname;
+            continue;
+        }
+        if (type == 1)
+            for (const in_addr& a : rec.addresses) {
+                putRecord(answers, owner, 1, rec.ttl, std::string(reinterpret_cast<const char*>(&a), 4));
+                ++count;
+            }
+        break;
+    }
+    if (rcode == 3 || (rcode == 0 && count == 0)) { // NXDOMAIN or NODATA
+        // SOA for negative caching: mname rname serial refresh retry expire minimum
+        std::string soa;
+        putName(soa, "ns.stub");
+        putName(soa, "admin.stub");
+        for (uint32_t v : {1u, 3600u, 600u, 86400u, 30u}) put32(soa, v);
+        putRecord(answers, "stub", 6, 60, soa);
+        authority = 1;
+    }
+
+    std::string reply = query.substr(0, questionEnd);
+    reply[2] = static_cast<char>(0x80 | (query[2] & 0x01)); // QR, echo RD
+    reply[3] = static_cast<char>(0x80 | rcode);              // RA
+    reply[6] = static_cast<char>(count >> 8);
+    reply[7] = static_cast<char>(count & 0xff);
+    reply[8] = 0;
+    reply[9] = static_cast<char>(authority);
+    reply[10] = reply[11] = 0;
+    return reply + answers;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const uint16_t port = static_cast<uint16_t>(argc > 1 ? std::atoi(argv[1]) : 5353);
+    for (int i = 2; i < argc; ++i)
+        if (!parseRecord(argv[i])) {
+            std::fprintf(stderr, "bad record %s\n", argv[i]);
+            return 1;
+        }
+
+    const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::perror("bind");
+        return 1;
+    }
+    std::printf("dns stub on 127.0.0.1:%u, %zu records\n", port, records.size());
+    std::fflush(stdout);
+
+    uint64_t queries = 0;
+    for (;;) {
+        char buf[512];
+        sockaddr_in from{};
+        socklen_t fromLen = sizeof(from);
+        const ssize_t n = ::recvfrom(fd, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&from), &fromLen);
+        if (n < 0) continue;
+        std::string name;
+        const std::string reply = answer(std::string(buf, static_cast<size_t>(n)), name);
+        std::printf("query %llu: %s%s\n", static_cast<unsigned long long>(++queries), name.c_str(),
+                    reply.empty() ? " (dropped)" : "");
+        std::fflush(stdout);
+        if (!reply.empty())
+            ::sendto(fd, reply.data(), reply.size(), 0, reinterpret_cast<sockaddr*>(&from), fromLen);
+    }
+}
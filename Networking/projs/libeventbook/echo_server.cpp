@@ -0,0 +1,27 @@
+// Echo server on the epoll reactor: whatever a client sends comes back.
+//
+//   g++ -std=c++20 -O2 echo_server.cpp reactor.cpp tcp.cpp net.cpp -o echo_server
+//   ./echo_server [port]
+
+#include "net.h"
+#include "reactor.h"
+#include "tcp.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char **argv)
+{
+    const uint16_t port = static_cast<uint16_t>(argc > 1 ? std::atoi(argv[1]) : 9000);
+    std::printf("echo server on port %u, fd limit %ld\n", port, net::raiseFdLimit());
+
+    Reactor reactor;
+    TcpServer server(reactor, net::listenTcp("0.0.0.0", port), [](Connection& conn) {
+        conn.setOnData([](Connection& c) {
+            c.send(c.input().view());
+            c.input().clear();
+        });
+    });
+    reactor.run();
+    return 0;
+}
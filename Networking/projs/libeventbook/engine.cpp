@@ -0,0 +1,296 @@
+#include "engine.h"
+#include "iostats.h"
+#include "net.h"
+#include "reactor.h"
+#include "tcp.h"
+#include "uring.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Reporter {
+    uint64_t requests = 0;
+    uint64_t lastRequests = 0, lastSyscalls = 0;
+    Clock::time_point last = Clock::now();
+
+    void tick(const char* extra = "") {
+        const Clock::time_point now = Clock::now();
+        const uint64_t reqs = requests - lastRequests, calls = net::syscalls - lastSyscalls;
+        const double secs = std::chrono::duration<double>(now - last).count();
+        if (reqs > 0)
+            std::printf("%10.0f req/s  %6.3f syscalls/req%s\n", static_cast<double>(reqs) / secs,
+                        static_cast<double>(calls) / static_cast<double>(reqs), extra);
+        std::fflush(stdout);
+        lastRequests = requests;
+        lastSyscalls = net::syscalls;
+        last = now;
+    }
+};
+
+} // namespace
+
+void serveEpoll(int listenFd, Protocol protocol) {
+    Reactor reactor;
+    Reporter reporter;
+    TcpServer server(reactor, listenFd, [&](Connection& conn) {
+        conn.setOnData([&](Connection& c) {
+            Exchange ex{c.output()};
+            c.input().consume(protocol(c.input().view(), ex));
+            reporter.requests += ex.responses;
+            c.flush();
+            if (ex.close) c.closeAfterWrite();
+        });
+    });
+    std::function<void()> tick = [&] {
+        reporter.tick();
+        reactor.runAfter(std::chrono::seconds(1), tick);
+    };
+    reactor.runAfter(std::chrono::seconds(1), tick);
+    reactor.run();
+}
+
+namespace {
+
+class UringServer {
+public:
+    UringServer(int listenFd, Protocol protocol, const EngineOptions& options)
+        : opts_(options), protocol_(protocol), listenFd_(listenFd), ring_(4096),
+          recv_(ring_, 0, options.recvBuffers, options.recvBufferSize),
+          slabMem_(options.sendSlabs * options.slabSize) {
+        zeroCopy_ = opts_.zeroCopy && ring_.hasOp(IORING_OP_SEND_ZC);
+        // registering pins the pages; without it sends still work, just
+        // without IORING_RECVSEND_FIXED_BUF
+        fixed_ = !slabMem_.empty() && ring_.registerBuffer(slabMem_.data(), slabMem_.size());
+        for (unsigned i = options.sendSlabs; i-- > 0;) freeSlabs_.push_back(static_cast<int>(i));
+        std::printf("io_uring engine: zero-copy sends %s (>= %zu bytes), registered send buffers %s\n",
+                    zeroCopy_ ? "on" : "off", opts_.zeroCopyMin, fixed_ ? "on" : "off");
+    }
+
+    void run() {
+        armAccept();
+        armTimer();
+        for (;;) {
+            ring_.submit(true);
+            ring_.drain([this](const io_uring_cqe& cqe) { complete(cqe); });
+        }
+    }
+
+private:
+    enum Kind : uint64_t { kAccept = 1, kRecv = 2, kSend = 3, kTimer = 4 };
+
+    struct Conn {
+        explicit Conn(int fd) : fd(fd) {}
+        int fd;
+        Buffer in{0}, out{0}, spill{0}; // spill holds a send that did not fit a slab
+        const char* sendPtr = nullptr;
+        size_t sendLen = 0;
+        int slab = -1;
+        bool sending = false, closing = false, closed = false;
+        unsigned notifs = 0;   // SEND_ZC buffers the kernel still holds
+        unsigned inflight = 0; // recv and send SQEs without their final CQE
+    };
+
+    static uint64_t tag(Conn* c, Kind kind) { return reinterpret_cast<uint64_t>(c) | kind; }
+
+    void armAccept() {
+        io_uring_sqe* s = ring_.sqe();
+        s->opcode = IORING_OP_ACCEPT;
+        s->fd = listenFd_;
+        s->ioprio = IORING_ACCEPT_MULTISHOT;
+        s->accept_flags = SOCK_CLOEXEC;
+        s->user_data = kAccept;
+    }
+
+    void armTimer() {
+        timeout_.tv_sec = 1;
+        io_uring_sqe* s = ring_.sqe();
+        s->opcode = IORING_OP_TIMEOUT;
+        s->fd = -1;
+        s->addr = reinterpret_cast<uint64_t>(&timeout_);
+        s->len = 1;
+        s->user_data = kTimer;
+    }
+
+    void armRecv(Conn* c) {
+        io_uring_sqe* s = ring_.sqe();
+        s->opcode = IORING_OP_RECV;
+        s->fd = c->fd;
+        s->ioprio = IORING_RECV_MULTISHOT;
+        s->flags = IOSQE_BUFFER_SELECT;
+        s->buf_group = recv_.group();
+        s->user_data = tag(c, kRecv);
+        ++c->inflight;
+    }
+
+    void complete(const io_uring_cqe& cqe) {
+        Conn* c = reinterpret_cast<Conn*>(cqe.user_data & ~uint64_t{7});
+        switch (static_cast<Kind>(cqe.user_data & 7)) {
+        case kAccept: onAccept(cqe); break;
+        case kRecv: onRecv(c, cqe); break;
+        case kSend: onSend(c, cqe); break;
+        case kTimer:
+            reporter_.tick();
+            armTimer();
+            break;
+        }
+    }
+
+    void onAccept(const io_uring_cqe& cqe) {
+        if (cqe.res >= 0) {
+            net::setNoDelay(cqe.res);
+            armRecv(new Conn(cqe.res));
+        }
+        if (!(cqe.flags & IORING_CQE_F_MORE)) armAccept(); // e.g. after EMFILE
+    }
+
+    void onRecv(Conn* c, const io_uring_cqe& cqe) {
+        const bool more = cqe.flags & IORING_CQE_F_MORE;
+        if (cqe.res > 0) {
+            const uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            onInput(c, recv_.buffer(bid), static_cast<size_t>(cqe.res));
+            recv_.recycle(bid);
+        } else if (cqe.res == 0 && !c->closed) {
+            // the peer is done sending: finish writing, then close
+            c->closing = true;
+            flush(c);
+        } else if (cqe.res != -ENOBUFS) {
+            close(c);
+        }
+        if (!more) {
+            --c->inflight;
+            // a recv stops after ENOBUFS or when its CQ side overflowed
+            if (cqe.res != 0 && !c->closed) armRecv(c);
+        }
+        maybeFree(c);
+    }
+
+    void onInput(Conn* c, const char* data, size_t n) {
+        if (c->closed || c->closing) return;
+        Exchange ex{c->out};
+        if (c->in.empty()) {
+            // parse straight out of the provided buffer; keep only a partial request
+            const size_t used = protocol_({data, n}, ex);
+            if (used < n) c->in.append(data + used, n - used);
+        } else {
+            c->in.append(data, n);
+            c->in.consume(protocol_(c->in.view(), ex));
+        }
+        reporter_.requests += ex.responses;
+        if (ex.close) c->closing = true;
+        flush(c);
+    }
+
+    // starts sending c->out unless a send (or its zero-copy buffer) is in flight
+    void flush(Conn* c) {
+        if (c->closed || c->sending || c->notifs) return;
+        if (c->out.empty()) {
+            if (c->closing) close(c);
+            return;
+        }
+        const size_t len = c->out.readable();
+        if (len <= opts_.slabSize && !freeSlabs_.empty()) {
+            c->slab = freeSlabs_.back();
+            freeSlabs_.pop_back();
+            char* p = slabMem_.data() + static_cast<size_t>(c->slab) * opts_.slabSize;
+            std::memcpy(p, c->out.peek(), len);
+            c->sendPtr = p;
+            c->out.clear();
+        } else {
+            std::swap(c->spill, c->out);
+            c->sendPtr = c->spill.peek();
+        }
+        c->sendLen = len;
+        c->sending = true;
+        submitSend(c);
+    }
+
+    void submitSend(Conn* c) {
+        const bool zc = zeroCopy_ && c->sendLen >= opts_.zeroCopyMin;
+        io_uring_sqe* s = ring_.sqe();
+        s->opcode = zc ? IORING_OP_SEND_ZC : IORING_OP_SEND;
+        s->fd = c->fd;
+        s->addr = reinterpret_cast<uint64_t>(c->sendPtr);
+        s->len = static_cast<uint32_t>(c->sendLen);
+        s->msg_flags = MSG_NOSIGNAL;
+        if (zc && fixed_ && c->slab >= 0) {
+            s->ioprio = IORING_RECVSEND_FIXED_BUF;
+            s->buf_index = 0;
+        }
+        s->user_data = tag(c, kSend);
+        ++c->inflight;
+    }
+
+    void onSend(Conn* c, const io_uring_cqe& cqe) {
+        if (cqe.flags & IORING_CQE_F_NOTIF) {
+            --c->notifs; // the kernel is done with a zero-copy buffer
+        } else {
+            --c->inflight;
+            if (cqe.flags & IORING_CQE_F_MORE) ++c->notifs;
+            if (cqe.res < 0) {
+                c->sending = false;
+                close(c);
+            } else {
+                c->sendPtr += cqe.res;
+                c->sendLen -= static_cast<size_t>(cqe.res);
+                if (c->sendLen > 0 && !c->closed)
+                    submitSend(c);
+                else
+                    c->sending = false;
+            }
+        }
+        if (!c->sending && c->notifs == 0) {
+            if (c->slab >= 0) {
+                freeSlabs_.push_back(c->slab);
+                c->slab = -1;
+            }
+            c->spill.clear();
+            flush(c);
+        }
+        maybeFree(c);
+    }
+
+    // the fd goes now; the Conn once no CQE can refer to it any more.
+    // shutdown ends the multishot recv, which would otherwise keep the
+    // socket open through its file reference
+    void close(Conn* c) {
+        if (c->closed) return;
+        c->closed = true;
+        ::shutdown(c->fd, SHUT_RDWR);
+        ::close(c->fd);
+        net::syscalls += 2;
+    }
+
+    void maybeFree(Conn* c) {
+        if (!c->closed || c->inflight || c->notifs) return;
+        if (c->slab >= 0) freeSlabs_.push_back(c->slab);
+        delete c;
+    }
+
+    EngineOptions opts_;
+    Protocol protocol_;
+    int listenFd_;
+    Uring ring_;
+    BufferRing recv_;
+    std::vector<char> slabMem_;
+    std::vector<int> freeSlabs_;
+    bool zeroCopy_ = false;
+    bool fixed_ = false;
+    __kernel_timespec timeout_{};
+    Reporter reporter_;
+};
+
+} // namespace
+
+void serveUring(int listenFd, Protocol protocol, const EngineOptions& options) {
+    UringServer(listenFd, protocol, options).run();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// Two ways to run a Protocol server on one thread:
+//
+//   serveEpoll  readiness based: the Reactor and TcpServer from tcp.h, a
+//               readv/send per wakeup per connection
+//   serveUring  completion based: one multishot accept, one multishot
+//               recv per connection drawing from a provided buffer ring,
+//               sends from registered buffers (SEND_ZC for large ones), and
+//               every SQE of a loop iteration submitted by one io_uring_enter
+//
+// Both print requests/sec and system calls per request once a second
+// while there is traffic.
+
+#include "protocols.h"
+
+#include <cstddef>
+
+struct EngineOptions {
+    bool zeroCopy = true;
+    size_t zeroCopyMin = 16 * 1024; // smaller responses are copied by the kernel
+    unsigned sendSlabs = 256;       // registered send buffers
+    size_t slabSize = 128 * 1024;
+    unsigned recvBuffers = 4096;    // provided receive buffers, a power of two
+    unsigned recvBufferSize = 4096;
+};
+
+void serveEpoll(int listenFd, Protocol protocol);
+void serveUring(int listenFd, Protocol protocol, const EngineOptions& options);
@@ -0,0 +1,77 @@
+#pragma once
+
+// Recycling allocator for coroutine frames. A given coroutine's frame has
+// the same size every time, so freed frames go onto per-thread free lists
+// by size class and are handed out again: once a server has warmed up,
+// starting a connection or request handler does not touch the heap.
+// Frames above kMaxPooled bytes, and frees beyond kMaxFree per class
+// (after a burst of connections), go to operator new/delete.
+//
+// Per thread, so a loop per core needs no locking; a frame freed on
+// another thread simply joins that thread's lists.
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+class FramePool {
+public:
+    static constexpr size_t kGranule = 64;
+    static constexpr size_t kMaxPooled = 4096;
+    static constexpr uint32_t kMaxFree = 16384;
+
+    static void* allocate(size_t n) {
+        if (n > kMaxPooled) return ::operator new(n);
+        Lists& l = lists();
+        const size_t c = sizeClass(n);
+        if (Node* node = l.head[c]) {
+            l.head[c] = node->next;
+            --l.count[c];
+            ++l.reused;
+            return node;
+        }
+        ++l.fresh;
+        return ::operator new((c + 1) * kGranule);
+    }
+
+    static void deallocate(void* p, size_t n) noexcept {
+        if (n > kMaxPooled) return ::operator delete(p);
+        Lists& l = lists();
+        const size_t c = sizeClass(n);
+        if (l.count[c] == kMaxFree) return ::operator delete(p);
+        Node* node = static_cast<Node*>(p);
+        node->next = l.head[c];
+        l.head[c] = node;
+        ++l.count[c];
+    }
+
+    // frames this thread took from the heap, and from the free lists
+    static uint64_t fresh() { return lists().fresh; }
+    static uint64_t reused() { return lists().reused; }
+
+private:
+    struct Node {
+        Node* next;
+    };
+
+    static constexpr size_t kClasses = kMaxPooled / kGranule;
+
+    struct Lists {
+        Node* head[kClasses] = {};
+        uint32_t count[kClasses] = {};
+        uint64_t fresh = 0, reused = 0;
+
+        ~Lists() {
+            for (Node* node : head)
+                while (node) ::operator delete(std::exchange(node, node->next));
+        }
+    };
+
+    static size_t sizeClass(size_t n) { return n == 0 ? 0 : (n - 1) / kGranule; }
+
+    static Lists& lists() {
+        static thread_local Lists l;
+        return l;
+    }
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+// Just enough HTTP/1.1 message framing for the examples: finds the end of
+// a request or response head and reads Content-Length and Connection.
+// No chunked bodies.
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace http {
+
+struct Head {
+    std::string_view startLine; // "GET / HTTP/1.1" or "HTTP/1.1 200 OK"
+    size_t headBytes;           // including the blank line
+    size_t contentLength = 0;
+    bool keepAlive;
+};
+
+inline bool equalsNoCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if ((a[i] | 0x20) != (b[i] | 0x20)) return false;
+    return true;
+}
+
+inline std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// the head at the start of data, or nullopt if it has not all arrived
+inline std::optional<Head> parseHead(std::string_view data) {
+    const size_t end = data.find("\r\n\r\n");
+    if (end == std::string_view::npos) return std::nullopt;
+    Head head;
+    head.headBytes = end + 4;
+    std::string_view lines = data.substr(0, end + 2);
+    size_t eol = lines.find("\r\n");
+    head.startLine = lines.substr(0, eol);
+    // HTTP/1.1 keeps the connection open unless told otherwise, 1.0 closes it
+    head.keepAlive = head.startLine.find("HTTP/1.0") == std::string_view::npos;
+    lines.remove_prefix(eol + 2);
+    while (!lines.empty()) {
+        eol = lines.find("\r\n");
+        const std::string_view line = lines.substr(0, eol);
+        lines.remove_prefix(eol + 2);
+        const size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        const std::string_view name = line.substr(0, colon);
+        const std::string_view value = trim(line.substr(colon + 1));
+        if (equalsNoCase(name, "content-length")) {
+            size_t n = 0;
+            for (char c : value) {
+                if (c < '0' || c > '9') break;
+                n = n * 10 + static_cast<size_t>(c - '0');
+            }
+            head.contentLength = n;
+        } else if (equalsNoCase(name, "connection")) {
+            head.keepAlive = !equalsNoCase(value, "close") && (head.keepAlive || equalsNoCase(value, "keep-alive"));
+        }
+    }
+    return head;
+}
+
+} // namespace http
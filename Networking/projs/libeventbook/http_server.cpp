@@ -0,0 +1,67 @@
+// HTTP/1.1 server on the epoll reactor with keep-alive and pipelining
+// (the protocol itself is serveHttp in protocols.h). Connections idle
+// for longer than the timeout are closed by a reactor timer.
+//
+//   g++ -std=c++20 -O2 http_server.cpp reactor.cpp tcp.cpp net.cpp -o http_server
+//   ./http_server [port] [idle seconds]
+
+#include "net.h"
+#include "protocols.h"
+#include "reactor.h"
+#include "tcp.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+namespace {
+
+// One timer per connection. Requests only bump lastActive; when the timer
+// fires early it re-arms for the rest of the idle period, so keep-alive
+// traffic does not touch the timer map.
+struct Session {
+    Reactor::TimerId timer;
+    Reactor::Clock::time_point lastActive;
+};
+
+void armIdleTimer(Connection& conn, const std::shared_ptr<Session>& session, Reactor::Clock::duration idle) {
+    Reactor& reactor = conn.reactor();
+    Connection* c = &conn;
+    session->timer = reactor.runAt(session->lastActive + idle, [c, session, idle] {
+        if (c->reactor().now() - session->lastActive >= idle)
+            c->close();
+        else
+            armIdleTimer(*c, session, idle);
+    });
+}
+
+// answers every complete request in the input buffer
+void serve(Connection& conn) {
+    Exchange ex{conn.output()};
+    conn.input().consume(serveHttp(conn.input().view(), ex));
+    conn.flush();
+    if (ex.close) conn.closeAfterWrite();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const uint16_t port = static_cast<uint16_t>(argc > 1 ? std::atoi(argv[1]) : 8080);
+    const std::chrono::seconds idle(argc > 2 ? std::atoi(argv[2]) : 30);
+    std::printf("http server on port %u, fd limit %ld\n", port, net::raiseFdLimit());
+
+    Reactor reactor;
+    TcpServer server(reactor, net::listenTcp("0.0.0.0", port), [&](Connection& conn) {
+        auto session = std::make_shared<Session>(Session{{}, reactor.now()});
+        armIdleTimer(conn, session, idle);
+        conn.setOnData([session](Connection& c) {
+            session->lastActive = c.reactor().now();
+            serve(c);
+        });
+        conn.setOnClose([session](Connection& c) { c.reactor().cancel(session->timer); });
+    });
+    reactor.run();
+    return 0;
+}
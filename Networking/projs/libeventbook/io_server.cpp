@@ -0,0 +1,42 @@
+// Echo or HTTP server on either I/O engine, for comparing them: io_uring
+// when the kernel supports it (Linux 6.0+), epoll otherwise or on request.
+//
+//   g++ -std=c++20 -O2 io_server.cpp engine.cpp uring.cpp reactor.cpp tcp.cpp net.cpp -o io_server
+//   ./io_server [http|echo] [port] [uring|epoll] [zero-copy threshold, 0 = off]
+//
+// Drive it with loadgen; GET /big returns 64 KiB, which is what zero-copy
+// sends are for.
+
+#include "engine.h"
+#include "net.h"
+#include "uring.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char **argv)
+{
+    const bool http = argc <= 1 || std::strcmp(argv[1], "echo") != 0;
+    const uint16_t port = static_cast<uint16_t>(argc > 2 ? std::atoi(argv[2]) : http ? 8080 : 9000);
+    const bool wantUring = argc <= 3 || std::strcmp(argv[3], "epoll") != 0;
+    EngineOptions options;
+    if (argc > 4) {
+        options.zeroCopyMin = std::strtoull(argv[4], nullptr, 10);
+        options.zeroCopy = options.zeroCopyMin > 0;
+    }
+
+    net::raiseFdLimit();
+    const int fd = net::listenTcp("0.0.0.0", port);
+    const Protocol protocol = http ? serveHttp : serveEcho;
+    if (wantUring && Uring::supported()) {
+        std::printf("%s on port %u, io_uring\n", http ? "http" : "echo", port);
+        serveUring(fd, protocol, options);
+    } else {
+        std::printf("%s on port %u, epoll%s\n", http ? "http" : "echo", port,
+                    wantUring ? " (io_uring not available)" : "");
+        std::fflush(stdout);
+        serveEpoll(fd, protocol);
+    }
+    return 0;
+}
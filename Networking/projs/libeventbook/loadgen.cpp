@@ -0,0 +1,155 @@
+// Closed-loop load generator on the epoll reactor: opens N keep-alive
+// connections, each with one request in flight at a time, and reports
+// requests/sec and latency percentiles over the measurement window.
+//
+//   g++ -std=c++20 -O2 loadgen.cpp reactor.cpp tcp.cpp net.cpp -o loadgen
+//   ./loadgen [http|echo] [host] [port] [connections] [seconds] [path]
+//
+// The connect phase is not measured: the window opens once every
+// connection is up (or has failed). For tens of thousands of connections
+// on loopback, raise `ulimit -n` for both sides.
+
+#include "http.h"
+#include "net.h"
+#include "reactor.h"
+#include "tcp.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = Reactor::Clock;
+
+constexpr std::string_view kEchoMessage = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+
+struct Stats {
+    bool measuring = false;
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    std::vector<uint32_t> latencyUs;
+};
+
+struct Client {
+    bool http;
+    const std::string* request;
+    Stats* stats;
+    Clock::time_point sent;
+    bool connected = false;
+
+    void sendRequest(Connection& conn) {
+        sent = Clock::now();
+        conn.send(http ? std::string_view(*request) : kEchoMessage);
+    }
+
+    // true once the whole response to the outstanding request is in
+    bool responseComplete(Buffer& in) {
+        if (!http) {
+            if (in.readable() < kEchoMessage.size()) return false;
+            in.consume(kEchoMessage.size());
+            return true;
+        }
+        const auto head = http::parseHead(in.view());
+        if (!head || in.readable() < head->headBytes + head->contentLength) return false;
+        in.consume(head->headBytes + head->contentLength);
+        return true;
+    }
+
+    void onData(Connection& conn) {
+        while (responseComplete(conn.input())) {
+            if (stats->measuring) {
+                ++stats->requests;
+                const auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - sent).count();
+                stats->latencyUs.push_back(static_cast<uint32_t>(us));
+            }
+            sendRequest(conn);
+        }
+    }
+};
+
+double percentile(std::vector<uint32_t>& v, double p) {
+    if (v.empty()) return 0;
+    const size_t k = std::min(v.size() - 1, static_cast<size_t>(p * static_cast<double>(v.size())));
+    std::nth_element(v.begin(), v.begin() + static_cast<ptrdiff_t>(k), v.end());
+    return v[k];
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const bool http = argc <= 1 || std::strcmp(argv[1], "echo") != 0;
+    const std::string host = argc > 2 ? argv[2] : "127.0.0.1";
+    const uint16_t port = static_cast<uint16_t>(argc > 3 ? std::atoi(argv[3]) : http ? 8080 : 9000);
+    const int connections = argc > 4 ? std::atoi(argv[4]) : 1000;
+    const int seconds = argc > 5 ? std::atoi(argv[5]) : 5;
+    const std::string request = "GET " + std::string(argc > 6 ? argv[6] : "/") + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    if (connections <= 0) {
+        // nothing would ever connect and start the measuring window
+        std::fprintf(stderr, "connections must be at least 1\n");
+        return 1;
+    }
+    const long limit = net::raiseFdLimit();
+    if (connections + 16 > limit) std::printf("warning: fd limit %ld is below %d connections\n", limit, connections);
+
+    Reactor reactor;
+    Stats stats;
+    stats.latencyUs.reserve(1 << 20);
+    std::vector<Client> clients(connections, Client{http, &request, &stats, {}, false});
+    const sockaddr_in to = net::makeAddress(host, port);
+
+    int pending = connections, failed = 0;
+    bool finished = false;
+    const auto connectStart = Clock::now();
+    Clock::time_point windowStart;
+    auto startWindow = [&] {
+        windowStart = Clock::now();
+        std::printf("%d connected, %d failed in %.2f s; measuring for %d s\n", connections - failed, failed,
+                    std::chrono::duration<double>(windowStart - connectStart).count(), seconds);
+        stats.measuring = true;
+        reactor.runAfter(std::chrono::seconds(seconds), [&] { reactor.stop(); });
+    };
+
+    // open connections, so they can be closed (and freed) at the end
+    std::vector<Connection*> open(connections);
+    for (int i = 0; i < connections; ++i) {
+        Connection* conn = Connection::connect(reactor, to);
+        open[i] = conn;
+        Client* cl = &clients[i];
+        conn->setOnConnect([cl, &pending, &startWindow](Connection& c) {
+            cl->connected = true;
+            cl->sendRequest(c);
+            if (--pending == 0) startWindow();
+        });
+        conn->setOnData([cl](Connection& c) { cl->onData(c); });
+        conn->setOnClose([&, i, cl](Connection&) {
+            open[i] = nullptr;
+            if (finished) return;
+            if (!cl->connected) {
+                ++failed;
+                if (--pending == 0) startWindow();
+            } else {
+                ++stats.errors;
+            }
+        });
+    }
+    reactor.run();
+    const double elapsed = std::chrono::duration<double>(Clock::now() - windowStart).count();
+    finished = true;
+    for (Connection* conn : open)
+        if (conn) conn->close();
+
+    std::printf("%s: %llu requests in %.2f s = %.0f req/s, %llu connection errors\n", http ? "http" : "echo",
+                static_cast<unsigned long long>(stats.requests), elapsed, static_cast<double>(stats.requests) / elapsed,
+                static_cast<unsigned long long>(stats.errors));
+    std::printf("latency us: p50 %.0f  p90 %.0f  p99 %.0f  p99.9 %.0f  max %.0f\n", percentile(stats.latencyUs, 0.5),
+                percentile(stats.latencyUs, 0.9), percentile(stats.latencyUs, 0.99),
+                percentile(stats.latencyUs, 0.999), percentile(stats.latencyUs, 1.0));
+    std::printf("epoll_wait calls: %llu\n", static_cast<unsigned long long>(reactor.waits()));
+    return 0;
+}
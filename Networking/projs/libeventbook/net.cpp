@@ -0,0 +1,83 @@
+#include "net.h"
+#include "iostats.h"
+
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace net {
+
+namespace {
+
+[[noreturn]] void fail(const char* what) { throw std::system_error(errno, std::generic_category(), what); }
+
+int tcpSocket() {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) fail("socket");
+    return fd;
+}
+
+} // namespace
+
+sockaddr_in makeAddress(const std::string& addr, uint16_t port) {
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    if (::inet_pton(AF_INET, addr.c_str(), &sa.sin_addr) != 1)
+        throw std::system_error(EINVAL, std::generic_category(), "bad IPv4 address " + addr);
+    return sa;
+}
+
+int listenTcp(const std::string& addr, uint16_t port, int backlog, bool reusePort) {
+    const sockaddr_in sa = makeAddress(addr, port);
+    const int fd = tcpSocket();
+    const int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (reusePort) ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&sa), sizeof(sa)) < 0 || ::listen(fd, backlog) < 0) {
+        const int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "bind/listen");
+    }
+    return fd;
+}
+
+int connectTcp(const sockaddr_in& to) {
+    const int fd = tcpSocket();
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) < 0 && errno != EINPROGRESS) {
+        const int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "connect");
+    }
+    return fd;
+}
+
+int connectError(int fd) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) return errno;
+    return err;
+}
+
+void setNoDelay(int fd) {
+    const int on = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    ++net::syscalls;
+}
+
+long raiseFdLimit() {
+    rlimit rl{};
+    if (::getrlimit(RLIMIT_NOFILE, &rl) < 0) fail("getrlimit");
+    if (rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    return static_cast<long>(rl.rlim_cur);
+}
+
+} // namespace net
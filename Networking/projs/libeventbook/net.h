@@ -0,0 +1,31 @@
+#pragma once
+
+// Socket setup shared by the examples. Every socket is non-blocking and
+// close-on-exec; failures throw std::system_error.
+
+#include <netinet/in.h>
+
+#include <cstdint>
+#include <string>
+
+namespace net {
+
+// bound and listening on addr:port (addr in dotted form, "0.0.0.0" for any);
+// with reusePort, each thread can have its own listening socket on the
+// same port and the kernel spreads new connections across them
+int listenTcp(const std::string& addr, uint16_t port, int backlog = 4096, bool reusePort = false);
+
+sockaddr_in makeAddress(const std::string& addr, uint16_t port);
+
+// starts a non-blocking connect; the socket turns writable when it completes
+int connectTcp(const sockaddr_in& to);
+
+// the error a non-blocking connect finished with, 0 on success
+int connectError(int fd);
+
+void setNoDelay(int fd);
+
+// raises the open-file soft limit to the hard limit, returns the new limit
+long raiseFdLimit();
+
+} // namespace net
@@ -0,0 +1,84 @@
+#pragma once
+
+// The request/response protocols the servers speak, written against
+// bytes in and a Buffer out so the epoll and io_uring engines can both
+// drive them.
+
+#include "buffer.h"
+#include "http.h"
+
+#include <string>
+#include <string_view>
+
+struct Exchange {
+    Buffer& out;
+    bool close = false;     // close once out has been written
+    unsigned responses = 0; // answered in this call
+};
+
+// consumes whole requests from in, appends their responses to ex.out and
+// returns how many bytes of in were used
+using Protocol = size_t (*)(std::string_view in, Exchange& ex);
+
+inline size_t serveEcho(std::string_view in, Exchange& ex) {
+    ex.out.append(in);
+    ++ex.responses;
+    return in.size();
+}
+
+namespace detail {
+
+constexpr std::string_view kHello = "HTTP/1.1 200 OK\r\n"
+                                    "Content-Type: text/plain\r\n"
+                                    "Content-Length: 13\r\n"
+                                    "\r\n"
+                                    "Hello, world\n";
+constexpr std::string_view kNotFound = "HTTP/1.1 404 Not Found\r\n"
+                                       "Content-Length: 0\r\n"
+                                       "\r\n";
+constexpr std::string_view kTooLarge = "HTTP/1.1 431 Request Header Fields Too Large\r\n"
+                                       "Connection: close\r\n"
+                                       "Content-Length: 0\r\n"
+                                       "\r\n";
+constexpr size_t kMaxHead = 16 * 1024;
+constexpr size_t kBigBody = 64 * 1024;
+
+// GET /big: a 64 KiB body, large enough for zero-copy sends to matter
+inline const std::string& bigResponse() {
+    static const std::string response = "HTTP/1.1 200 OK\r\n"
+                                        "Content-Type: application/octet-stream\r\n"
+                                        "Content-Length: " +
+                                        std::to_string(kBigBody) + "\r\n\r\n" + std::string(kBigBody, 'x');
+    return response;
+}
+
+} // namespace detail
+
+// GET / answers "Hello, world", GET /big 64 KiB, anything else 404;
+// keep-alive and pipelining as HTTP/1.1 defines them
+inline size_t serveHttp(std::string_view in, Exchange& ex) {
+    size_t used = 0;
+    while (!ex.close) {
+        const std::string_view rest = in.substr(used);
+        const auto head = http::parseHead(rest);
+        if (!head) {
+            if (rest.size() > detail::kMaxHead) {
+                ex.out.append(detail::kTooLarge);
+                ex.close = true;
+            }
+            break;
+        }
+        if (rest.size() < head->headBytes + head->contentLength) break; // body still arriving
+        const std::string_view line = head->startLine;
+        if (line.starts_with("GET / "))
+            ex.out.append(detail::kHello);
+        else if (line.starts_with("GET /big "))
+            ex.out.append(detail::bigResponse());
+        else
+            ex.out.append(detail::kNotFound);
+        ++ex.responses;
+        used += head->headBytes + head->contentLength;
+        ex.close = !head->keepAlive;
+    }
+    return used;
+}
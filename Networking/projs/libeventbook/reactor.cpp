@@ -0,0 +1,99 @@
+#include "reactor.h"
+#include "iostats.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace {
+
+[[noreturn]] void fail(const char* what) { throw std::system_error(errno, std::generic_category(), what); }
+
+void control(int epfd, int op, int fd, uint32_t events, EventHandler* handler) {
+    epoll_event ev{};
+    ev.events = events | EPOLLET;
+    ev.data.ptr = handler;
+    ++net::syscalls;
+    if (::epoll_ctl(epfd, op, fd, &ev) < 0) fail("epoll_ctl");
+}
+
+} // namespace
+
+Reactor::Reactor() : epfd_(::epoll_create1(EPOLL_CLOEXEC)), now_(Clock::now()), events_(256) {
+    if (epfd_ < 0) fail("epoll_create1");
+}
+
+Reactor::~Reactor() {
+    runDeferred();
+    ::close(epfd_);
+}
+
+void Reactor::add(int fd, uint32_t events, EventHandler* handler) { control(epfd_, EPOLL_CTL_ADD, fd, events, handler); }
+
+void Reactor::modify(int fd, uint32_t events, EventHandler* handler) {
+    control(epfd_, EPOLL_CTL_MOD, fd, events, handler);
+}
+
+void Reactor::remove(int fd) {
+    ++net::syscalls;
+    ::epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void Reactor::remove(int fd, EventHandler* handler) {
+    remove(fd);
+    for (int i = batchNext_; i < batchEnd_; ++i)
+        if (events_[i].data.ptr == handler) events_[i].data.ptr = nullptr;
+}
+
+Reactor::TimerId Reactor::runAt(Clock::time_point when, Callback cb) {
+    TimerId id{when, nextTimer_++};
+    timers_.emplace(id, std::move(cb));
+    return id;
+}
+
+int Reactor::timeoutMs() const {
+    if (!deferred_.empty()) return 0;
+    if (timers_.empty()) return -1;
+    const auto wait = timers_.begin()->first.first - Clock::now();
+    if (wait <= Clock::duration::zero()) return 0;
+    // round up so a timer never fires early and spins
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(wait).count());
+}
+
+void Reactor::run() {
+    running_ = true;
+    while (running_) {
+        const int n = ::epoll_wait(epfd_, events_.data(), static_cast<int>(events_.size()), timeoutMs());
+        ++waits_;
+        ++net::syscalls;
+        if (n < 0 && errno != EINTR) fail("epoll_wait");
+        now_ = Clock::now();
+        for (batchNext_ = 0, batchEnd_ = n; batchNext_ < batchEnd_;) {
+            const epoll_event& ev = events_[batchNext_++];
+            if (ev.data.ptr) static_cast<EventHandler*>(ev.data.ptr)->onEvents(ev.events);
+        }
+        batchEnd_ = 0;
+        if (n == static_cast<int>(events_.size())) events_.resize(events_.size() * 2);
+        runDeferred();
+        runTimers();
+        runDeferred();
+    }
+}
+
+void Reactor::runTimers() {
+    // timers added by these callbacks wait for the next iteration
+    const uint64_t last = nextTimer_;
+    while (!timers_.empty() && timers_.begin()->first.first <= now_ && timers_.begin()->first.second < last) {
+        auto node = timers_.extract(timers_.begin());
+        node.mapped()();
+    }
+}
+
+void Reactor::runDeferred() {
+    while (!deferred_.empty()) {
+        std::vector<Callback> batch;
+        batch.swap(deferred_);
+        for (Callback& cb : batch) cb();
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+// Single-threaded epoll reactor. File descriptors are registered
+// edge-triggered with an EventHandler, which must drain the fd (read or
+// write until EAGAIN) on each notification. Timers and deferred callbacks
+// run on the same thread, after each batch of I/O events.
+
+#include <sys/epoll.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+class EventHandler {
+public:
+    // events is the epoll mask: EPOLLIN, EPOLLOUT, EPOLLERR, EPOLLHUP, EPOLLRDHUP
+    virtual void onEvents(uint32_t events) = 0;
+
+protected:
+    ~EventHandler() = default;
+};
+
+class Reactor {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+    using TimerId = std::pair<Clock::time_point, uint64_t>;
+
+    Reactor();
+    ~Reactor();
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    // events without EPOLLET; every registration is edge-triggered
+    void add(int fd, uint32_t events, EventHandler* handler);
+    void modify(int fd, uint32_t events, EventHandler* handler);
+    void remove(int fd);
+    // also drops events already collected for handler in the current
+    // batch, so the handler may be destroyed right after
+    void remove(int fd, EventHandler* handler);
+
+    TimerId runAt(Clock::time_point when, Callback cb);
+    TimerId runAfter(Clock::duration delay, Callback cb) { return runAt(now_ + delay, std::move(cb)); }
+    // cancelling a timer that already ran is a no-op
+    void cancel(const TimerId& id) { timers_.erase(id); }
+
+    // runs cb after the current batch of events, e.g. to free a handler
+    // whose fd may still have events pending in this batch
+    void defer(Callback cb) { deferred_.push_back(std::move(cb)); }
+
+    void run();
+    void stop() { running_ = false; }
+
+    // the time the current batch of events was collected
+    Clock::time_point now() const { return now_; }
+
+    uint64_t waits() const { return waits_; }
+
+private:
+    int timeoutMs() const;
+    void runTimers();
+    void runDeferred();
+
+    int epfd_;
+    bool running_ = false;
+    Clock::time_point now_;
+    uint64_t nextTimer_ = 0;
+    uint64_t waits_ = 0;
+    std::vector<epoll_event> events_;
+    int batchNext_ = 0, batchEnd_ = 0;
+    std::map<TimerId, Callback> timers_;
+    std::vector<Callback> deferred_;
+};
@@ -0,0 +1,72 @@
+// Resolves names with Resolver, all at once on one reactor thread, then
+// once more to show the cache answering without any queries.
+//
+//   g++ -std=c++20 -O2 resolve.cpp resolver.cpp reactor.cpp net.cpp -o resolve
+//   ./resolve [-s server[:port]] name...
+//
+// Without -s the nameservers come from /etc/resolv.conf. To try it
+// offline, run dns_stub and point -s at it:
+//
+//   ./dns_stub 5353 www.example=10.0.0.1,10.0.0.2 alias.example=cname:www.example &
+//   ./resolve -s 127.0.0.1:5353 www.example alias.example missing.example
+
+#include "net.h"
+#include "reactor.h"
+#include "resolver.h"
+#include "task.h"
+
+#include <arpa/inet.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+Task<> show(Resolver& resolver, std::string name, int& pending, Reactor& reactor) {
+    const auto start = Reactor::Clock::now();
+    const Resolution r = co_await resolver.resolve(name);
+    const double ms = std::chrono::duration<double, std::milli>(Reactor::Clock::now() - start).count();
+    std::printf("%-30s %8.3f ms  %s", name.c_str(), ms, toString(r.status));
+    for (const in_addr& a : r.addresses) {
+        char text[INET_ADDRSTRLEN];
+        std::printf(" %s", ::inet_ntop(AF_INET, &a, text, sizeof(text)));
+    }
+    std::printf("\n");
+    if (--pending == 0) reactor.stop();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    ResolverConfig config = ResolverConfig::load();
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            const std::string server = argv[++i];
+            const size_t colon = server.find(':');
+            const uint16_t port = static_cast<uint16_t>(colon == std::string::npos ? 53 : std::atoi(server.c_str() + colon + 1));
+            config.nameservers = {net::makeAddress(server.substr(0, colon), port)};
+            config.timeout = std::chrono::seconds(1);
+        } else {
+            names.push_back(argv[i]);
+        }
+    }
+    if (names.empty()) names = {"localhost"};
+
+    Reactor reactor;
+    Resolver resolver(reactor, config);
+    for (const char* round : {"first round", "second round (cached)"}) {
+        std::printf("%s\n", round);
+        int pending = static_cast<int>(names.size());
+        for (const std::string& name : names) spawn(show(resolver, name, pending, reactor));
+        if (pending > 0) reactor.run();
+    }
+    std::printf("%llu queries sent, %llu cache hits\n", static_cast<unsigned long long>(resolver.queriesSent()),
+                static_cast<unsigned long long>(resolver.cacheHits()));
+    return 0;
+}
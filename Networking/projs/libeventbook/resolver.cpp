@@ -0,0 +1,445 @@
+#include "resolver.h"
+#include "iostats.h"
+#include "net.h"
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+namespace {
+
+constexpr uint16_t kTypeA = 1;
+constexpr uint16_t kTypeCname = 5;
+constexpr uint16_t kTypeSoa = 6;
+constexpr uint16_t kClassIn = 1;
+constexpr int kRcodeNxDomain = 3;
+
+std::string lower(std::string_view s) {
+    std::string out(s);
+    for (char& c : out) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return out;
+}
+
+void put16(std::string& out, uint16_t v) {
+    out += static_cast<char>(v >> 8);
+    out += static_cast<char>(v & 0xff);
+}
+
+// a recursive query for name's A record; false if name has an empty or
+// over-long label
+bool encodeQuery(std::string& out, uint16_t id, std::string_view name) {
+    out.clear();
+    put16(out, id);
+    put16(out, 0x0100); // RD
+    put16(out, 1);      // one question
+    put16(out, 0);
+    put16(out, 0);
+    put16(out, 0);
+    while (!name.empty()) {
+        const size_t dot = name.find('.');
+        const std::string_view label = name.substr(0, dot);
+        if (label.empty() || label.size() > 63) return false;
+        out += static_cast<char>(label.size());
+        out += label;
+        name.remove_prefix(dot == std::string_view::npos ? name.size() : dot + 1);
+    }
+    out += '\0';
+    put16(out, kTypeA);
+    put16(out, kClassIn);
+    return true;
+}
+
+// bounds-checked reads from a DNS message; ok() turns false on overrun
+class Reader {
+public:
+    explicit Reader(std::string_view p) : p_(p) {}
+
+    bool ok() const { return ok_; }
+    size_t pos() const { return pos_; }
+    void seek(size_t pos) { pos <= p_.size() ? void(pos_ = pos) : void(ok_ = false); }
+
+    uint8_t u8() { return need(1) ? static_cast<uint8_t>(p_[pos_++]) : 0; }
+    uint16_t u16() {
+        const uint16_t hi = u8();
+        return static_cast<uint16_t>(hi << 8 | u8());
+    }
+    uint32_t u32() {
+        const uint32_t hi = u16();
+        return hi << 16 | u16();
+    }
+
+    // a possibly compressed name, lower-cased, without the final dot
+    std::string name() {
+        std::string out;
+        size_t pos = pos_;
+        bool jumped = false;
+        for (int hops = 0;;) {
+            if (pos >= p_.size()) return fail();
+            const uint8_t len = static_cast<uint8_t>(p_[pos]);
+            if ((len & 0xc0) == 0xc0) {
+                if (pos + 1 >= p_.size() || ++hops > 16) return fail();
+                if (!jumped) pos_ = pos + 2;
+                jumped = true;
+                pos = static_cast<size_t>(len & 0x3f) << 8 | static_cast<uint8_t>(p_[pos + 1]);
+                continue;
+            }
+            if (len & 0xc0) return fail();
+            if (len == 0) {
+                if (!jumped) pos_ = pos + 1;
+                return out;
+            }
+            if (pos + 1 + len > p_.size() || out.size() + len + 1 > 255) return fail();
+            if (!out.empty()) out += '.';
+            out += lower(p_.substr(pos + 1, len));
+            pos += 1 + len;
+        }
+    }
+
+private:
+    bool need(size_t n) {
+        if (ok_ && p_.size() - pos_ >= n) return true;
+        ok_ = false;
+        return false;
+    }
+    std::string fail() {
+        ok_ = false;
+        return {};
+    }
+
+    std::string_view p_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+struct Reply {
+    uint16_t id = 0;
+    int rcode = 0;
+    std::string question;
+    uint16_t questionType = 0;
+    std::vector<in_addr> addresses;
+    uint32_t ttl = UINT32_MAX;      // lowest TTL along the CNAME chain and A records
+    std::optional<uint32_t> negativeTtl; // from the SOA in the authority section
+};
+
+bool parseReply(std::string_view packet, Reply& r) {
+    Reader in(packet);
+    r.id = in.u16();
+    const uint16_t flags = in.u16();
+    const uint16_t questions = in.u16(), answers = in.u16(), authority = in.u16();
+    in.u16();
+    if (!in.ok() || !(flags & 0x8000) || questions != 1) return false;
+    r.rcode = flags & 0xf;
+    r.question = in.name();
+    r.questionType = in.u16();
+    in.u16();
+
+    struct Record {
+        std::string owner;
+        uint16_t type;
+        uint32_t ttl;
+        std::string cname;
+        in_addr address;
+    };
+    std::vector<Record> records;
+    for (int i = 0; i < answers + authority && in.ok(); ++i) {
+        Record rec{in.name(), in.u16(), 0, {}, {}};
+        in.u16();
+        rec.ttl = std::min(in.u32(), Resolver::kMaxTtl);
+        const uint16_t length = in.u16();
+        const size_t end = in.pos() + length;
+        if (i >= answers) {
+            if (rec.type == kTypeSoa) {
+                in.name(); // primary server
+                in.name(); // mailbox
+                in.seek(in.pos() + 16);
+                const uint32_t minimum = in.u32();
+                r.negativeTtl = std::min(rec.ttl, minimum);
+            }
+        } else if (rec.type == kTypeCname) {
+            rec.cname = in.name();
+            records.push_back(std::move(rec));
+        } else if (rec.type == kTypeA && length == 4) {
+            const uint32_t a = in.u32();
+            rec.address.s_addr = htonl(a);
+            records.push_back(std::move(rec));
+        }
+        in.seek(end);
+    }
+    if (!in.ok()) return false;
+
+    // follow the question's CNAME chain, then take the A records at its end
+    std::string target = r.question;
+    for (int hops = 0; hops < 16; ++hops) {
+        const auto it = std::find_if(records.begin(), records.end(),
+                                     [&](const Record& rec) { return rec.type == kTypeCname && rec.owner == target; });
+        if (it == records.end()) break;
+        target = it->cname;
+        r.ttl = std::min(r.ttl, it->ttl);
+    }
+    for (const Record& rec : records) {
+        if (rec.type != kTypeA || rec.owner != target) continue;
+        r.addresses.push_back(rec.address);
+        r.ttl = std::min(r.ttl, rec.ttl);
+    }
+    return true;
+}
+
+// suspends until the query is answered, refused or timed out
+struct WaitForReply {
+    std::coroutine_handle<>& waiter;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) noexcept { waiter = h; }
+    void await_resume() const noexcept {}
+};
+
+// suspends until the lookup that owns q finishes, then copies its result
+template <typename Query>
+struct JoinQuery {
+    Query& q;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) { q.followers.push_back(h); }
+    Resolution await_resume() const { return q.result; }
+};
+
+} // namespace
+
+ResolverConfig ResolverConfig::load(const std::string& path) {
+    ResolverConfig config;
+    std::ifstream file(path);
+    std::string line, domain;
+    while (std::getline(file, line)) {
+        std::istringstream words(line.substr(0, line.find_first_of("#;")));
+        std::string key, value;
+        if (!(words >> key)) continue;
+        if (key == "nameserver" && words >> value && config.nameservers.size() < 3) {
+            try {
+                config.nameservers.push_back(net::makeAddress(value, 53));
+            } catch (const std::system_error&) {
+                // IPv6 or malformed
+            }
+        } else if (key == "search") {
+            config.search.clear();
+            while (words >> value) config.search.push_back(lower(value));
+        } else if (key == "domain" && words >> value) {
+            domain = lower(value);
+        } else if (key == "options") {
+            while (words >> value) {
+                const size_t colon = value.find(':');
+                if (colon == std::string::npos) continue;
+                const int n = std::atoi(value.c_str() + colon + 1);
+                const std::string option = value.substr(0, colon);
+                if (option == "ndots") config.ndots = std::clamp(n, 0, 15);
+                if (option == "timeout") config.timeout = std::chrono::seconds(std::clamp(n, 1, 30));
+                if (option == "attempts") config.attempts = std::clamp(n, 1, 5);
+            }
+        }
+    }
+    if (config.search.empty() && !domain.empty()) config.search.push_back(domain);
+    if (config.nameservers.empty()) config.nameservers.push_back(net::makeAddress("127.0.0.1", 53));
+    return config;
+}
+
+HostsTable loadHosts(const std::string& path) {
+    HostsTable hosts;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string address, name;
+        in_addr a{};
+        if (!(words >> address) || ::inet_pton(AF_INET, address.c_str(), &a) != 1) continue;
+        while (words >> name) hosts[lower(name)].push_back(a);
+    }
+    return hosts;
+}
+
+const char* toString(ResolveStatus status) {
+    switch (status) {
+    case ResolveStatus::Ok: return "ok";
+    case ResolveStatus::NotFound: return "not found";
+    case ResolveStatus::Timeout: return "timed out";
+    case ResolveStatus::ServerFailure: return "server failure";
+    case ResolveStatus::BadName: return "bad name";
+    }
+    return "?";
+}
+
+// a connected UDP socket to one nameserver
+class Resolver::Server final : public EventHandler {
+public:
+    Server(Resolver& resolver, const sockaddr_in& to) : resolver_(resolver) {
+        fd_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) throw std::system_error(errno, std::generic_category(), "socket");
+        if (::connect(fd_, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) < 0) {
+            const int err = errno;
+            ::close(fd_);
+            throw std::system_error(err, std::generic_category(), "connect");
+        }
+        resolver_.reactor_.add(fd_, EPOLLIN, this);
+    }
+
+    ~Server() {
+        resolver_.reactor_.remove(fd_, this);
+        ::close(fd_);
+    }
+
+    bool send(const std::string& packet) {
+        ++net::syscalls;
+        return ::send(fd_, packet.data(), packet.size(), 0) == static_cast<ssize_t>(packet.size());
+    }
+
+    void onEvents(uint32_t) override {
+        char packet[4096];
+        for (;;) {
+            const ssize_t n = ::recv(fd_, packet, sizeof(packet), 0);
+            ++net::syscalls;
+            if (n >= 0) {
+                resolver_.onDatagram({packet, static_cast<size_t>(n)});
+            } else if (errno == ECONNREFUSED) {
+                // ICMP port unreachable: nothing listens there
+                resolver_.onRefused(this);
+            } else if (errno != EINTR) {
+                return;
+            }
+        }
+    }
+
+private:
+    Resolver& resolver_;
+    int fd_;
+};
+
+Resolver::Resolver(Reactor& reactor, ResolverConfig config, HostsTable hosts)
+    : reactor_(reactor), config_(std::move(config)), hosts_(std::move(hosts)) {
+    for (const sockaddr_in& ns : config_.nameservers) servers_.push_back(std::make_unique<Server>(*this, ns));
+}
+
+Resolver::~Resolver() = default;
+
+std::vector<std::string> Resolver::candidates(const std::string& name) const {
+    if (name.back() == '.') return {name.substr(0, name.size() - 1)};
+    std::vector<std::string> out;
+    const bool asIsFirst = std::count(name.begin(), name.end(), '.') >= config_.ndots;
+    if (asIsFirst) out.push_back(name);
+    for (const std::string& domain : config_.search) out.push_back(name + "." + domain);
+    if (!asIsFirst) out.push_back(name);
+    return out;
+}
+
+Task<Resolution> Resolver::resolve(std::string name) {
+    in_addr literal{};
+    if (::inet_pton(AF_INET, name.c_str(), &literal) == 1) co_return Resolution{ResolveStatus::Ok, {literal}};
+    name = lower(name);
+    if (name.empty() || name.size() > 254 || name == ".") co_return Resolution{ResolveStatus::BadName, {}};
+    const std::string bare = name.back() == '.' ? name.substr(0, name.size() - 1) : name;
+    if (const auto it = hosts_.find(bare); it != hosts_.end()) co_return Resolution{ResolveStatus::Ok, it->second};
+
+    Resolution result{ResolveStatus::NotFound, {}};
+    for (const std::string& candidate : candidates(name)) {
+        result = co_await lookup(candidate);
+        if (result.status != ResolveStatus::NotFound && result.status != ResolveStatus::BadName) break;
+    }
+    co_return result;
+}
+
+Task<Resolution> Resolver::lookup(std::string name) {
+    if (const auto it = cache_.find(name); it != cache_.end()) {
+        if (it->second.expires > reactor_.now()) {
+            ++cacheHits_;
+            co_return it->second.result;
+        }
+        cache_.erase(it);
+    }
+    if (const auto it = inflight_.find(name); it != inflight_.end()) co_return co_await JoinQuery<Query>{*it->second};
+
+    Query q;
+    q.name = name;
+    std::string packet;
+    if (!encodeQuery(packet, 0, name)) co_return Resolution{ResolveStatus::BadName, {}};
+    inflight_.emplace(name, &q);
+    q.result.status = ResolveStatus::Timeout;
+    for (int round = 0; round < config_.attempts && !q.answered; ++round) {
+        for (const auto& server : servers_) {
+            do {
+                q.id = static_cast<uint16_t>(random_());
+            } while (byId_.count(q.id));
+            packet[0] = static_cast<char>(q.id >> 8);
+            packet[1] = static_cast<char>(q.id & 0xff);
+            if (!server->send(packet)) continue;
+            ++queriesSent_;
+            q.server = server.get();
+            byId_.emplace(q.id, &q);
+            q.timer = reactor_.runAfter(config_.timeout, [this, &q] {
+                byId_.erase(q.id);
+                q.waiter.resume();
+            });
+            co_await WaitForReply{q.waiter};
+            if (q.answered) break;
+        }
+    }
+    inflight_.erase(name);
+    if (q.answered) store(name, q.result, q.ttl);
+    // followers copy q.result as they resume, while q is still alive
+    for (std::coroutine_handle<> h : std::exchange(q.followers, {})) h.resume();
+    co_return q.result;
+}
+
+// Called from Server::onEvents, which keeps reading its socket afterwards:
+// resuming the lookup there could let its caller destroy the Resolver (and
+// the Server) under it, so the resume waits for the end of the batch.
+void Resolver::finish(Query& q) {
+    reactor_.cancel(q.timer);
+    byId_.erase(q.id);
+    reactor_.defer([waiter = q.waiter] { waiter.resume(); });
+}
+
+void Resolver::onDatagram(std::string_view packet) {
+    Reply reply;
+    if (!parseReply(packet, reply)) return;
+    const auto it = byId_.find(reply.id);
+    // a reply must echo the id and the question; anything else is stale or forged
+    if (it == byId_.end() || reply.question != it->second->name || reply.questionType != kTypeA) return;
+    Query& q = *it->second;
+    if (reply.rcode == 0 && !reply.addresses.empty()) {
+        q.answered = true;
+        q.result = {ResolveStatus::Ok, std::move(reply.addresses)};
+        q.ttl = reply.ttl;
+    } else if (reply.rcode == 0 || reply.rcode == kRcodeNxDomain) {
+        // NXDOMAIN, or the name exists without an A record
+        q.answered = true;
+        q.result = {ResolveStatus::NotFound, {}};
+        q.ttl = reply.negativeTtl.value_or(kDefaultNegativeTtl);
+    } else {
+        q.result.status = ResolveStatus::ServerFailure; // next server
+    }
+    finish(q);
+}
+
+void Resolver::onRefused(const Server* server) {
+    std::vector<Query*> refused;
+    for (const auto& [id, q] : byId_)
+        if (q->server == server) refused.push_back(q);
+    for (Query* q : refused) {
+        q->result.status = ResolveStatus::ServerFailure;
+        finish(*q);
+    }
+}
+
+void Resolver::store(const std::string& name, const Resolution& result, uint32_t ttl) {
+    if (ttl == 0) return;
+    if (cache_.size() >= kMaxCacheEntries) {
+        std::erase_if(cache_, [&](const auto& entry) { return entry.second.expires <= reactor_.now(); });
+        if (cache_.size() >= kMaxCacheEntries) cache_.clear();
+    }
+    cache_[name] = CacheEntry{result, reactor_.now() + std::chrono::seconds(std::min(ttl, kMaxTtl))};
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+// Non-blocking DNS resolver (IPv4 A records) for Task coroutines on a
+// Reactor, in place of gethostbyname/getaddrinfo, which block the calling
+// thread for as long as the lookup takes.
+//
+// Lookups check literal addresses, then /etc/hosts, then the cache, and
+// only then send a UDP query from the event loop to the nameservers in
+// resolv.conf (in turn, `attempts` rounds, `timeout` per try). Answers
+// are cached for their TTL; NXDOMAIN and "no such record" are cached too,
+// for the SOA's negative TTL. Concurrent lookups of one name share a
+// single query. Search domains apply the way resolv.conf's ndots says.
+//
+// Each nameserver gets its own connected UDP socket, so only its replies
+// are read, and queries carry random ids that replies must echo along
+// with the question.
+
+#include "reactor.h"
+#include "task.h"
+
+#include <netinet/in.h>
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct ResolverConfig {
+    std::vector<sockaddr_in> nameservers; // 127.0.0.1:53 when there are none
+    std::vector<std::string> search;
+    int ndots = 1;
+    Reactor::Clock::duration timeout = std::chrono::seconds(5);
+    int attempts = 2;
+
+    // nameserver, search, domain and options ndots/timeout/attempts lines;
+    // IPv6 nameservers are skipped
+    static ResolverConfig load(const std::string& path = "/etc/resolv.conf");
+};
+
+// lower-case name -> addresses, from a hosts file (IPv4 entries only)
+using HostsTable = std::unordered_map<std::string, std::vector<in_addr>>;
+HostsTable loadHosts(const std::string& path = "/etc/hosts");
+
+enum class ResolveStatus { Ok, NotFound, Timeout, ServerFailure, BadName };
+
+const char* toString(ResolveStatus status);
+
+struct Resolution {
+    ResolveStatus status = ResolveStatus::Ok;
+    std::vector<in_addr> addresses;
+};
+
+class Resolver {
+public:
+    using Clock = Reactor::Clock;
+
+    static constexpr uint32_t kMaxTtl = 24 * 3600;
+    static constexpr uint32_t kDefaultNegativeTtl = 30; // no SOA in the reply
+    static constexpr size_t kMaxCacheEntries = 10000;
+
+    Resolver(Reactor& reactor, ResolverConfig config = ResolverConfig::load(), HostsTable hosts = loadHosts());
+    ~Resolver();
+    Resolver(const Resolver&) = delete;
+    Resolver& operator=(const Resolver&) = delete;
+
+    // The Resolver must outlive every lookup it has started.
+    Task<Resolution> resolve(std::string name);
+
+    uint64_t queriesSent() const { return queriesSent_; }
+    uint64_t cacheHits() const { return cacheHits_; }
+
+private:
+    struct CacheEntry {
+        Resolution result;
+        Clock::time_point expires;
+    };
+
+    class Server;
+
+    // one outstanding question; lives in the frame of the lookup() asking it
+    struct Query {
+        std::string name;
+        uint16_t id = 0;
+        bool answered = false;
+        Resolution result;
+        uint32_t ttl = 0;
+        Server* server = nullptr;
+        Reactor::TimerId timer;
+        std::coroutine_handle<> waiter;
+        std::vector<std::coroutine_handle<>> followers; // same name, asked meanwhile
+    };
+
+    Task<Resolution> lookup(std::string name);
+    void onDatagram(std::string_view packet);
+    void onRefused(const Server* server);
+    void finish(Query& q);
+    std::vector<std::string> candidates(const std::string& name) const;
+    void store(const std::string& name, const Resolution& result, uint32_t ttl);
+
+    Reactor& reactor_;
+    ResolverConfig config_;
+    HostsTable hosts_;
+    std::vector<std::unique_ptr<Server>> servers_;
+    std::unordered_map<std::string, CacheEntry> cache_;
+    std::unordered_map<uint16_t, Query*> byId_;
+    std::unordered_map<std::string, Query*> inflight_;
+    std::mt19937 random_{std::random_device{}()};
+    uint64_t queriesSent_ = 0;
+    uint64_t cacheHits_ = 0;
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+// Task<T>: a lazily started coroutine that produces a T. Awaiting a task
+// starts it and suspends the awaiter until it finishes; control passes
+// between them by symmetric transfer, so a chain of tasks that complete
+// without blocking does not grow the stack. Exceptions propagate to the
+// awaiter. Frames come from FramePool.
+//
+// spawn() starts a Task<> with no awaiter, e.g. one per connection; it
+// frees itself when done.
+
+#include "frame_pool.h"
+
+#include <coroutine>
+#include <cstdio>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr error;
+
+    static void* operator new(size_t n) { return FramePool::allocate(n); }
+    static void operator delete(void* p, size_t n) noexcept { FramePool::deallocate(p, n); }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            return h.promise().continuation;
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object() noexcept;
+    template <typename U>
+    void return_value(U&& v) {
+        value.emplace(std::forward<U>(v));
+    }
+    T result() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+    void result() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace detail
+
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle h) noexcept : h_(h) {}
+    Task(Task&& other) noexcept : h_(std::exchange(other.h_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (h_) h_.destroy();
+            h_ = std::exchange(other.h_, {});
+        }
+        return *this;
+    }
+    ~Task() {
+        if (h_) h_.destroy();
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            Handle h;
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+                h.promise().continuation = awaiter;
+                return h;
+            }
+            T await_resume() { return h.promise().result(); }
+        };
+        return Awaiter{h_};
+    }
+
+private:
+    Handle h_;
+};
+
+template <typename T>
+Task<T> detail::Promise<T>::get_return_object() noexcept {
+    return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> detail::Promise<void>::get_return_object() noexcept {
+    return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+namespace detail {
+
+// runs eagerly and destroys itself at the end
+struct Detached {
+    struct promise_type {
+        static void* operator new(size_t n) { return FramePool::allocate(n); }
+        static void operator delete(void* p, size_t n) noexcept { FramePool::deallocate(p, n); }
+
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {
+            // nobody is waiting for the result: report it and carry on
+            try {
+                throw;
+            } catch (const std::exception& e) {
+                std::fprintf(stderr, "spawned task failed: %s\n", e.what());
+            } catch (...) {
+                std::fprintf(stderr, "spawned task failed\n");
+            }
+        }
+    };
+};
+
+inline Detached detach(Task<> task) { co_await std::move(task); }
+
+} // namespace detail
+
+// runs task until it first suspends, then leaves it to the event loop
+inline void spawn(Task<> task) { detail::detach(std::move(task)); }
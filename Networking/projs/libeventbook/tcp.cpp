@@ -0,0 +1,114 @@
+#include "tcp.h"
+#include "iostats.h"
+#include "net.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+
+Connection::Connection(Reactor& reactor, int fd, bool connecting)
+    : reactor_(reactor), fd_(fd), connecting_(connecting) {
+    reactor_.add(fd_, EPOLLIN | EPOLLOUT | EPOLLRDHUP, this);
+}
+
+Connection* Connection::adopt(Reactor& reactor, int fd, bool connecting) {
+    return new Connection(reactor, fd, connecting);
+}
+
+Connection* Connection::connect(Reactor& reactor, const sockaddr_in& to) {
+    return adopt(reactor, net::connectTcp(to), true);
+}
+
+void Connection::onEvents(uint32_t events) {
+    if (closed_) return; // closed earlier in this batch
+    if (connecting_) {
+        if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) return;
+        if (const int err = net::connectError(fd_)) return fail(err);
+        connecting_ = false;
+        net::setNoDelay(fd_);
+        if (onConnect_) onConnect_(*this);
+        if (closed_) return;
+    }
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) {
+        bool eof;
+        const ssize_t n = input_.readFrom(fd_, eof);
+        if (n < 0) return fail(errno);
+        if (n > 0 && onData_) onData_(*this);
+        if (closed_) return;
+        if (eof) {
+            // the peer is done sending; finish our side, then close
+            if (output_.empty()) return close();
+            closing_ = true;
+        }
+    }
+    if ((events & EPOLLOUT) && !output_.empty()) flush();
+}
+
+void Connection::send(std::string_view data) {
+    if (closed_) return;
+    output_.append(data);
+    if (!connecting_) flush();
+}
+
+void Connection::flush() {
+    if (output_.writeTo(fd_) < 0) return fail(errno);
+    if (closing_ && output_.empty()) close();
+}
+
+void Connection::closeAfterWrite() {
+    closing_ = true;
+    if (output_.empty() && !connecting_) close();
+}
+
+void Connection::fail(int err) {
+    error_ = err;
+    close();
+}
+
+void Connection::close() {
+    if (closed_) return;
+    closed_ = true;
+    reactor_.remove(fd_);
+    ::close(fd_);
+    ++net::syscalls;
+    if (onClose_) onClose_(*this);
+    reactor_.defer([this] { delete this; });
+}
+
+TcpServer::TcpServer(Reactor& reactor, int listenFd, Connection::Callback onAccept)
+    : reactor_(reactor), fd_(listenFd), onAccept_(std::move(onAccept)) {
+    reactor_.add(fd_, EPOLLIN, this);
+}
+
+TcpServer::~TcpServer() {
+    if (paused_) reactor_.cancel(retry_);
+    reactor_.remove(fd_);
+    ::close(fd_);
+}
+
+void TcpServer::onEvents(uint32_t) {
+    if (paused_) return;
+    for (;;) {
+        const int fd = ::accept4(fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        ++net::syscalls;
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno == EMFILE || errno == ENFILE) {
+                // out of descriptors: the backlog stays queued, and with
+                // edge triggering no new event may come, so poll again later
+                paused_ = true;
+                retry_ = reactor_.runAfter(std::chrono::milliseconds(100), [this] {
+                    paused_ = false;
+                    onEvents(EPOLLIN);
+                });
+            }
+            return; // EAGAIN: drained
+        }
+        ++accepted_;
+        net::setNoDelay(fd);
+        Connection* conn = Connection::adopt(reactor_, fd);
+        onAccept_(*conn);
+    }
+}
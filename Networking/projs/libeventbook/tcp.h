@@ -0,0 +1,89 @@
+#pragma once
+
+// TCP connections and a listener on top of Reactor.
+//
+// A Connection owns its socket and two Buffers. It is registered once for
+// EPOLLIN | EPOLLOUT | EPOLLRDHUP, edge-triggered, so it never has to call
+// epoll_ctl again: reads drain the socket into input(), and output() is
+// flushed when send() is called or the socket turns writable again.
+// A Connection deletes itself after close(), once the current batch of
+// events is done, so callbacks must not keep references to it past onClose.
+
+#include "buffer.h"
+#include "reactor.h"
+
+#include <functional>
+#include <string_view>
+
+struct sockaddr_in;
+
+class Connection final : public EventHandler {
+public:
+    using Callback = std::function<void(Connection&)>;
+
+    // takes ownership of a connected (or, with connecting, still
+    // connecting) non-blocking socket
+    static Connection* adopt(Reactor& reactor, int fd, bool connecting = false);
+    // starts a connect; onConnect runs when it completes, onClose if it fails
+    static Connection* connect(Reactor& reactor, const sockaddr_in& to);
+
+    void setOnConnect(Callback cb) { onConnect_ = std::move(cb); }
+    void setOnData(Callback cb) { onData_ = std::move(cb); }
+    void setOnClose(Callback cb) { onClose_ = std::move(cb); }
+
+    Buffer& input() { return input_; }
+    Buffer& output() { return output_; }
+
+    // queues data and writes as much as the socket takes right away
+    void send(std::string_view data);
+    void flush();
+    // closes once output() has been written
+    void closeAfterWrite();
+    void close();
+
+    int fd() const { return fd_; }
+    bool connected() const { return !connecting_ && !closed_; }
+    bool closed() const { return closed_; }
+    // errno that closed the connection, 0 for an orderly close
+    int error() const { return error_; }
+    Reactor& reactor() { return reactor_; }
+
+    void onEvents(uint32_t events) override;
+
+private:
+    Connection(Reactor& reactor, int fd, bool connecting);
+    ~Connection() = default;
+    void fail(int err);
+
+    Reactor& reactor_;
+    int fd_;
+    bool connecting_;
+    bool closed_ = false;
+    bool closing_ = false;
+    int error_ = 0;
+    Buffer input_;
+    Buffer output_;
+    Callback onConnect_, onData_, onClose_;
+};
+
+// Accepts connections on a listening socket and hands each one to
+// onAccept, which sets its callbacks.
+class TcpServer final : public EventHandler {
+public:
+    TcpServer(Reactor& reactor, int listenFd, Connection::Callback onAccept);
+    ~TcpServer();
+    TcpServer(const TcpServer&) = delete;
+    TcpServer& operator=(const TcpServer&) = delete;
+
+    uint64_t accepted() const { return accepted_; }
+
+    void onEvents(uint32_t events) override;
+
+private:
+    Reactor& reactor_;
+    int fd_;
+    Connection::Callback onAccept_;
+    uint64_t accepted_ = 0;
+    bool paused_ = false;
+    Reactor::TimerId retry_; // polls accept again while paused_
+};
@@ -0,0 +1,174 @@
+#include "uring.h"
+#include "iostats.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+namespace {
+
+[[noreturn]] void fail(int err, const char* what) { throw std::system_error(err, std::generic_category(), what); }
+
+int setup(unsigned entries, io_uring_params& p) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+}
+
+int enter(int fd, unsigned submit, unsigned wait, unsigned flags) {
+    ++net::syscalls;
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, submit, wait, flags, nullptr, 0));
+}
+
+int registerOp(int fd, unsigned op, void* arg, unsigned n) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, op, arg, n));
+}
+
+void* mapRing(int fd, size_t size, off_t offset) {
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    if (p == MAP_FAILED) fail(errno, "mmap io_uring");
+    return p;
+}
+
+} // namespace
+
+Uring::Uring(unsigned entries) {
+    io_uring_params p{};
+    // one thread submits, and completions may wait for the next enter;
+    // older kernels reject these flags, so retry without them
+    p.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_CQSIZE;
+    p.cq_entries = entries * 4;
+    fd_ = setup(entries, p);
+    if (fd_ < 0 && errno == EINVAL) {
+        p = io_uring_params{};
+        p.flags = IORING_SETUP_CQSIZE;
+        p.cq_entries = entries * 4;
+        fd_ = setup(entries, p);
+    }
+    if (fd_ < 0) fail(errno, "io_uring_setup");
+
+    sqRingSize_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqRingSize_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    sqRing_ = mapRing(fd_, sqRingSize_, IORING_OFF_SQ_RING);
+    cqRing_ = (p.features & IORING_FEAT_SINGLE_MMAP) ? sqRing_ : mapRing(fd_, cqRingSize_, IORING_OFF_CQ_RING);
+    sqesSize_ = p.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(mapRing(fd_, sqesSize_, IORING_OFF_SQES));
+
+    auto at = [](void* base, unsigned off) { return reinterpret_cast<unsigned*>(static_cast<char*>(base) + off); };
+    sqHead_ = at(sqRing_, p.sq_off.head);
+    sqTail_ = at(sqRing_, p.sq_off.tail);
+    sqMask_ = *at(sqRing_, p.sq_off.ring_mask);
+    sqEntries_ = p.sq_entries;
+    sqArray_ = at(sqRing_, p.sq_off.array);
+    cqHead_ = at(cqRing_, p.cq_off.head);
+    cqTail_ = at(cqRing_, p.cq_off.tail);
+    cqMask_ = *at(cqRing_, p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(static_cast<char*>(cqRing_) + p.cq_off.cqes);
+
+    // which opcodes this kernel knows
+    const unsigned probeOps = 256;
+    std::vector<char> probeMem(sizeof(io_uring_probe) + probeOps * sizeof(io_uring_probe_op));
+    auto* probe = reinterpret_cast<io_uring_probe*>(probeMem.data());
+    ops_.assign(probeOps, false);
+    if (registerOp(fd_, IORING_REGISTER_PROBE, probe, probeOps) == 0)
+        for (unsigned i = 0; i < probe->ops_len; ++i)
+            ops_[probe->ops[i].op] = (probe->ops[i].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+
+Uring::~Uring() {
+    ::munmap(sqes_, sqesSize_);
+    if (cqRing_ != sqRing_) ::munmap(cqRing_, cqRingSize_);
+    ::munmap(sqRing_, sqRingSize_);
+    ::close(fd_);
+}
+
+bool Uring::supported() {
+    try {
+        Uring probe(8);
+        return probe.hasOp(IORING_OP_SEND_ZC);
+    } catch (const std::system_error&) {
+        return false;
+    }
+}
+
+io_uring_sqe* Uring::sqe() {
+    unsigned tail = *sqTail_;
+    if (tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) == sqEntries_) {
+        // submit may take none of them (EAGAIN/EBUSY) or only some; the
+        // head says whether a slot came free. Callers run inside drain(),
+        // so completions can't be reaped here to make room.
+        submit(false);
+        if (tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) == sqEntries_)
+            fail(EBUSY, "io_uring submission queue full");
+    }
+    io_uring_sqe* s = &sqes_[tail & sqMask_];
+    std::memset(s, 0, sizeof(*s));
+    sqArray_[tail & sqMask_] = tail & sqMask_;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+    ++pending_;
+    return s;
+}
+
+void Uring::submit(bool wait) {
+    if (pending_ == 0 && !wait) return;
+    for (;;) {
+        const int n = enter(fd_, pending_, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0);
+        if (n >= 0) {
+            pending_ -= std::min<unsigned>(pending_, static_cast<unsigned>(n));
+            return;
+        }
+        if (errno == EINTR) continue;
+        // EAGAIN/EBUSY: the completion queue is backed up; the caller
+        // drains it and the SQEs go in with the next submit
+        if (errno == EAGAIN || errno == EBUSY) return;
+        fail(errno, "io_uring_enter");
+    }
+}
+
+bool Uring::registerBuffer(void* base, size_t size) {
+    iovec iov{base, size};
+    return registerOp(fd_, IORING_REGISTER_BUFFERS, &iov, 1) == 0;
+}
+
+BufferRing::BufferRing(Uring& ring, uint16_t gid, unsigned count, unsigned size)
+    : ring_(ring), gid_(gid), count_(count), size_(size), storage_(size_t{count} * size) {
+    // count must be a power of two; the ring is page aligned memory
+    brSize_ = count * sizeof(io_uring_buf);
+    void* mem = ::mmap(nullptr, brSize_, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (mem == MAP_FAILED) fail(errno, "mmap buffer ring");
+    br_ = static_cast<io_uring_buf_ring*>(mem);
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(br_);
+    reg.ring_entries = count;
+    reg.bgid = gid;
+    if (registerOp(ring.fd(), IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        const int err = errno;
+        ::munmap(br_, brSize_);
+        fail(err, "IORING_REGISTER_PBUF_RING");
+    }
+    for (unsigned i = 0; i < count; ++i) recycle(static_cast<uint16_t>(i));
+}
+
+BufferRing::~BufferRing() {
+    io_uring_buf_reg reg{};
+    reg.bgid = gid_;
+    registerOp(ring_.fd(), IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    ::munmap(br_, brSize_);
+}
+
+void BufferRing::recycle(uint16_t bid) {
+    const uint16_t tail = br_->tail;
+    // the ring is an array of io_uring_buf whose first entry overlays the
+    // tail; not br_->bufs, which C++ compilers place at the wrong offset
+    io_uring_buf& b = reinterpret_cast<io_uring_buf*>(br_)[tail & (count_ - 1)];
+    b.addr = reinterpret_cast<uint64_t>(buffer(bid));
+    b.len = size_;
+    b.bid = bid;
+    __atomic_store_n(&br_->tail, static_cast<uint16_t>(tail + 1), __ATOMIC_RELEASE);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+// A thin io_uring wrapper over the raw system calls (no liburing): maps the
+// submission and completion rings, hands out SQEs, and submits them in
+// batches. BufferRing is a provided-buffer ring that multishot receives
+// pick their buffers from.
+
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Uring {
+public:
+    // throws std::system_error, e.g. ENOSYS on kernels without io_uring
+    explicit Uring(unsigned entries);
+    ~Uring();
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+
+    // whether this kernel can run the io_uring server engine: the ring
+    // itself plus multishot receive and SEND_ZC (Linux 6.0+)
+    static bool supported();
+    bool hasOp(uint8_t opcode) const { return opcode < ops_.size() && ops_[opcode]; }
+
+    // a zeroed SQE; submits what is queued first if the ring is full, and
+    // throws std::system_error(EBUSY) if the kernel still can't take any
+    io_uring_sqe* sqe();
+
+    // submits queued SQEs and, with wait, blocks until a completion is
+    // ready; one io_uring_enter either way
+    void submit(bool wait);
+
+    // calls f(const io_uring_cqe&) for each ready completion; returns how many
+    template <typename F>
+    unsigned drain(F&& f) {
+        unsigned head = *cqHead_;
+        const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        const unsigned n = tail - head;
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & cqMask_];
+            f(cqe);
+        }
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        return n;
+    }
+
+    // pins [base, base + size) as fixed buffer 0 for IORING_RECVSEND_FIXED_BUF
+    bool registerBuffer(void* base, size_t size);
+
+    int fd() const { return fd_; }
+
+private:
+    friend class BufferRing;
+
+    int fd_;
+    unsigned pending_ = 0; // SQEs queued since the last submit
+    void* sqRing_;
+    void* cqRing_;
+    size_t sqRingSize_, cqRingSize_;
+    io_uring_sqe* sqes_;
+    size_t sqesSize_;
+    unsigned *sqHead_, *sqTail_, *sqArray_, sqMask_, sqEntries_;
+    unsigned *cqHead_, *cqTail_, cqMask_;
+    io_uring_cqe* cqes_;
+    std::vector<bool> ops_; // opcodes the kernel supports
+};
+
+// count buffers of size bytes each, registered as buffer group gid
+class BufferRing {
+public:
+    BufferRing(Uring& ring, uint16_t gid, unsigned count, unsigned size);
+    ~BufferRing();
+    BufferRing(const BufferRing&) = delete;
+    BufferRing& operator=(const BufferRing&) = delete;
+
+    uint16_t group() const { return gid_; }
+    char* buffer(uint16_t bid) { return storage_.data() + size_t{bid} * size_; }
+    // hands a buffer back to the kernel
+    void recycle(uint16_t bid);
+
+private:
+    Uring& ring_;
+    uint16_t gid_;
+    unsigned count_;
+    unsigned size_;
+    io_uring_buf_ring* br_;
+    size_t brSize_;
+    std::vector<char> storage_;
+};
@@ -5,14 +5,14 @@
 #pragma once
 
 #include <iostream>
+#include <string>
 
 class Shape {
 public:
     // virtual destructor
     // essential for derived class cleanup
-    virtual ~Shape() {
-        std::cout << "Shape destructor called" << std::endl;
-    }
+    // no printing here: ShapePool destroys millions of these
+    virtual ~Shape() = default;
 
     // delete copy constructor
     Shape(const Shape& other) = delete;
@@ -31,4 +31,44 @@ public:
 
 protected:
     std::string color = "transparent";
-};
\ No newline at end of file
+};
+
+// where draw() puts its pixels; one per thread so drawing needs no locking
+struct Canvas {
+    double coverage = 0;
+    long shapes = 0;
+
+    void fill(double area) {
+        coverage += area;
+        ++shapes;
+    }
+
+    static Canvas& current() {
+        thread_local Canvas canvas;
+        return canvas;
+    }
+};
+
+class Circle final : public Shape {
+public:
+    explicit Circle(double r) : radius(r) {}
+    void draw() const override { Canvas::current().fill(3.14159265358979 * radius * radius); }
+private:
+    double radius;
+};
+
+class Rectangle final : public Shape {
+public:
+    Rectangle(double w, double h) : width(w), height(h) {}
+    void draw() const override { Canvas::current().fill(width * height); }
+private:
+    double width, height;
+};
+
+class Triangle final : public Shape {
+public:
+    Triangle(double b, double h) : base(b), height(h) {}
+    void draw() const override { Canvas::current().fill(0.5 * base * height); }
+private:
+    double base, height;
+};
@@ -5,22 +5,41 @@
 #pragma once
 
 #include <iostream>
+#include <memory_resource>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <cassert>
 
+#include "small_vector.h"
+#include "tracking.h"
+
+// Allocator-aware: std::pmr::vector<Customer> hands its memory resource to
+// every element, so long names and values spill into that resource.
 class Customer {
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
 private:
-    std::string name;
-    std::vector<int> values;
+    // both stay inside the object for short names and a handful of values
+    SmallString<24, std::pmr::polymorphic_allocator<char>> name;
+    SmallVector<int, 8, std::pmr::polymorphic_allocator<int>> values;
 public:
-    explicit Customer(const std::string&n): name(n) {
-        std::cout << "Customer " << n << " created" << std::endl;
+    explicit Customer(const std::string&n, const allocator_type& alloc = {}): name(n, alloc), values(alloc) {
+        TRACK_CONSTRUCT(Customer);
         assert(!name.empty());
     }
 
+    allocator_type get_allocator() const {
+        return values.get_allocator();
+    }
+
     std::string get_name() {
-        return name;
+        return name.str();
+    }
+
+    const SmallVector<int, 8, std::pmr::polymorphic_allocator<int>>& get_values() const {
+        return values;
     }
 
     void addValue(const int& value) {
@@ -36,22 +55,34 @@ public:
     }
 
     Customer(const Customer& cust): name(cust.name), values(cust.values) {
-        std::cout << "Copy constructor called" << cust.name << std::endl;
+        TRACK_COPY(Customer);
     }
 
     Customer(Customer&& cust) noexcept : name(std::move(cust.name)), values(std::move(cust.values)) {
-        std::cout << "Move constructor called" << name << std::endl;
+        TRACK_MOVE(Customer);
+    }
+
+    // used by pmr containers to copy/move an element into their own resource
+    Customer(const Customer& cust, const allocator_type& alloc): name(cust.name, alloc), values(cust.values, alloc) {
+        TRACK_COPY(Customer);
+    }
+
+    Customer(Customer&& cust, const allocator_type& alloc): name(std::move(cust.name), alloc), values(std::move(cust.values), alloc) {
+        TRACK_MOVE(Customer);
     }
 
     Customer& operator= (const Customer& cust) {
-        std::cout << "Copy assignment operator called" << cust.name << std::endl;
+        TRACK_COPY_ASSIGN(Customer);
         name = cust.name;
         values = cust.values;
         return *this;
     }
 
-    Customer& operator= (Customer&& cust) noexcept {
-        std::cout << "Move assignment operator called" << name << std::endl;
+    // with pmr allocators this can allocate: members on different resources
+    // move element by element instead of handing over their buffers
+    Customer& operator= (Customer&& cust) noexcept(std::is_nothrow_move_assignable_v<decltype(name)> &&
+                                                   std::is_nothrow_move_assignable_v<decltype(values)>) {
+        TRACK_MOVE_ASSIGN(Customer);
         if (this != &cust) {
             name = std::move(cust.name);
             values = std::move(cust.values);
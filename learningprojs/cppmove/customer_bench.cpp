@@ -0,0 +1,58 @@
+// builds and moves millions of customers with the old layout (std::string +
+// std::vector<int>, two heap blocks each) and with Customer's inline storage,
+// counting heap allocations with tracking.h
+
+#define TRACKING_ENABLED 1
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "customer.h"
+
+TRACKING_DEFINE_GLOBAL_NEW()
+
+class HeapCustomer {
+    std::string name;
+    std::vector<int> values;
+public:
+    explicit HeapCustomer(const std::string& n) : name(n) {}
+    void addValue(const int& value) { values.push_back(value); }
+};
+
+template <typename C>
+void run(const char* label, std::size_t count, bool reserve) {
+    track::ThreadAllocs before = track::threadAllocs();
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<C> coll;
+        if (reserve) coll.reserve(count);
+        std::string name = "TestCustomer ";
+        for (std::size_t i = 0; i < count; ++i) {
+            name.resize(13);
+            name += std::to_string(i);
+            C c{name};
+            for (int v = 0; v < 4; ++v) c.addValue(v);
+            coll.push_back(std::move(c));
+        }
+        // move the whole collection once more, like handing it to another owner
+        std::vector<C> moved;
+        moved.reserve(coll.size());
+        for (auto& c : coll) moved.push_back(std::move(c));
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    const track::ThreadAllocs& after = track::threadAllocs();
+    std::cout << label << (reserve ? " reserved:   " : " unreserved: ") << ms << " ms, "
+              << static_cast<double>(after.allocations - before.allocations) / count << " allocations/customer\n";
+}
+
+int main(int argc, char** argv) {
+    std::size_t count = argc > 1 ? std::stoull(argv[1]) : 2'000'000;
+    for (bool reserve : {true, false}) {
+        run<HeapCustomer>("std::string+std::vector", count, reserve);
+        run<Customer>("SmallString+SmallVector", count, reserve);
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+// CustomerTable: the same data as std::vector<Customer>, stored by column.
+//
+//   names      "TestCustomer 0TestCustomer 1..."   one char arena
+//   nameEnd    [14, 28, ...]                        end offset of each name
+//   values     [v0 v0 v0 | v1 v1 | ...]             every value, contiguous
+//   valueEnd   [3, 5, ...]                          end offset of each row
+//
+// Appending a customer appends to four vectors, so after reserve() a bulk
+// load does no per-customer allocation. Scans over all values are a loop
+// over one int array, which the compiler vectorizes.
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory_resource>
+#include <numeric>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class CustomerTable {
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    CustomerTable() = default;
+    explicit CustomerTable(const allocator_type& alloc) : names(alloc), nameEnd(alloc), values(alloc), valueEnd(alloc) {}
+
+    void reserve(std::size_t customers, std::size_t nameBytes, std::size_t valueCount) {
+        names.reserve(nameBytes);
+        nameEnd.reserve(customers);
+        values.reserve(valueCount);
+        valueEnd.reserve(customers);
+    }
+
+    // returns the row index
+    std::size_t append(std::string_view name, std::span<const int> vals) {
+        names.append(name);
+        nameEnd.push_back(names.size());
+        values.insert(values.end(), vals.begin(), vals.end());
+        valueEnd.push_back(values.size());
+        return nameEnd.size() - 1;
+    }
+
+    std::size_t append(std::string_view name, std::initializer_list<int> vals) {
+        return append(name, std::span<const int>(vals.begin(), vals.size()));
+    }
+
+    // adds a value to the last row; rows before it are immutable
+    void addValueToLast(int value) {
+        values.push_back(value);
+        ++valueEnd.back();
+    }
+
+    std::size_t size() const { return nameEnd.size(); }
+    bool empty() const { return nameEnd.empty(); }
+
+    std::string_view name(std::size_t row) const {
+        const std::size_t begin = row == 0 ? 0 : nameEnd[row - 1];
+        return std::string_view(names).substr(begin, nameEnd[row] - begin);
+    }
+
+    std::span<const int> valuesOf(std::size_t row) const {
+        const std::size_t begin = row == 0 ? 0 : valueEnd[row - 1];
+        return std::span<const int>(values).subspan(begin, valueEnd[row] - begin);
+    }
+
+    // every value of every customer, in row order
+    std::span<const int> allValues() const { return values; }
+
+    std::int64_t sumAll() const { return std::accumulate(values.begin(), values.end(), std::int64_t{0}); }
+
+    std::size_t countValuesAbove(int threshold) const {
+        std::size_t n = 0;
+        for (int v : values) n += v > threshold;
+        return n;
+    }
+
+    // per-row totals, written into out (resized to size())
+    void rowSums(std::vector<std::int64_t>& out) const {
+        out.resize(size());
+        std::size_t begin = 0;
+        for (std::size_t row = 0; row < size(); ++row) {
+            std::int64_t sum = 0;
+            for (std::size_t i = begin; i < valueEnd[row]; ++i) sum += values[i];
+            out[row] = sum;
+            begin = valueEnd[row];
+        }
+    }
+
+    // rows whose values add up to more than threshold
+    std::vector<std::size_t> rowsWithSumAbove(std::int64_t threshold) const {
+        std::vector<std::size_t> rows;
+        std::size_t begin = 0;
+        for (std::size_t row = 0; row < size(); ++row) {
+            std::int64_t sum = 0;
+            for (std::size_t i = begin; i < valueEnd[row]; ++i) sum += values[i];
+            if (sum > threshold) rows.push_back(row);
+            begin = valueEnd[row];
+        }
+        return rows;
+    }
+
+    template <typename F>
+    void forEach(F&& f) const {
+        for (std::size_t row = 0; row < size(); ++row) f(name(row), valuesOf(row));
+    }
+
+    void clear() {
+        names.clear();
+        nameEnd.clear();
+        values.clear();
+        valueEnd.clear();
+    }
+
+private:
+    std::pmr::string names;
+    std::pmr::vector<std::size_t> nameEnd;
+    std::pmr::vector<int> values;
+    std::pmr::vector<std::size_t> valueEnd;
+};
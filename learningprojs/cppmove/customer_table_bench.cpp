@@ -0,0 +1,81 @@
+// std::vector<Customer> vs CustomerTable: bulk insert, a sum over every value
+// and a filter on per-customer totals
+
+#define TRACKING_ENABLED 1
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "customer.h"
+#include "customer_table.h"
+
+TRACKING_DEFINE_GLOBAL_NEW()
+
+template <typename F>
+double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    std::size_t count = argc > 1 ? std::stoull(argv[1]) : 2'000'000;
+    const int valuesPerCustomer = 12; // more than SmallVector's 8 inline slots
+    std::string name = "TestCustomer ";
+
+    std::vector<Customer> coll;
+    std::uint64_t allocsBefore = track::threadAllocs().allocations;
+    double insertVec = timeMs([&] {
+        coll.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            name.resize(13);
+            name += std::to_string(i);
+            Customer& c = coll.emplace_back(name);
+            for (int v = 0; v < valuesPerCustomer; ++v) c.addValue(static_cast<int>(i % 100) + v);
+        }
+    });
+    std::uint64_t vecAllocs = track::threadAllocs().allocations - allocsBefore;
+
+    CustomerTable table;
+    allocsBefore = track::threadAllocs().allocations;
+    double insertTable = timeMs([&] {
+        table.reserve(count, count * 20, count * valuesPerCustomer);
+        int vals[valuesPerCustomer];
+        for (std::size_t i = 0; i < count; ++i) {
+            name.resize(13);
+            name += std::to_string(i);
+            for (int v = 0; v < valuesPerCustomer; ++v) vals[v] = static_cast<int>(i % 100) + v;
+            table.append(name, vals);
+        }
+    });
+    std::uint64_t tableAllocs = track::threadAllocs().allocations - allocsBefore;
+
+    std::int64_t vecSum = 0, tableSum = 0;
+    double scanVec = timeMs([&] {
+        for (const Customer& c : coll) {
+            for (int v : c.get_values()) vecSum += v;
+        }
+    });
+    double scanTable = timeMs([&] { tableSum = table.sumAll(); });
+
+    std::size_t vecHits = 0, tableHits = 0;
+    double filterVec = timeMs([&] {
+        for (const Customer& c : coll) {
+            std::int64_t s = 0;
+            for (int v : c.get_values()) s += v;
+            vecHits += s > 1000;
+        }
+    });
+    double filterTable = timeMs([&] { tableHits = table.rowsWithSumAbove(1000).size(); });
+
+    std::cout << "insert: vector<Customer> " << insertVec << " ms (" << vecAllocs << " allocations), CustomerTable "
+              << insertTable << " ms (" << tableAllocs << " allocations)\n";
+    std::cout << "sum:    vector<Customer> " << scanVec << " ms, CustomerTable " << scanTable << " ms"
+              << (vecSum == tableSum ? "" : " MISMATCH") << "\n";
+    std::cout << "filter: vector<Customer> " << filterVec << " ms, CustomerTable " << filterTable << " ms"
+              << (vecHits == tableHits ? "" : " MISMATCH") << "\n";
+    return 0;
+}
@@ -2,8 +2,13 @@
 #include<vector>
 #include<string>
 #include "customer.h"
+#include "customer_table.h"
+#include "small_vector.h"
+#include <cassert>
 using namespace std::string_literals;
 
+TRACKING_DEFINE_GLOBAL_NEW()
+
 // TIP To <b>Run</b> code, press <shortcut actionId="Run"/> or
 // click the <icon src="AllIcons.Actions.Execute"/> icon in the gutter.
 void validButUnspecifiedState() {
@@ -47,6 +52,7 @@ void readManyLines() {
 }
 
 void makeACollectionOfCustomers() {
+    TRACK_ALLOCS(Customer, allocs);
     std::vector<Customer> coll;
     // coll.reserve(16); // reserve preserves unnecessary moving!
     for (int i=0; i<12; ++i) {
@@ -54,6 +60,28 @@ void makeACollectionOfCustomers() {
     }
 }
 
+// same data as makeACollectionOfCustomers, stored by column: no per-customer
+// allocations, and the values of all customers sit in one array
+void makeACustomerTable() {
+    CustomerTable table;
+    table.reserve(12, 12 * 16, 12 * 2);
+    for (int i=0; i<12; ++i) {
+        table.append("TestCustomer " + std::to_string(i), {i, i * 10});
+    }
+    std::cout << "table rows: " << table.size() << ", sum of all values: " << table.sumAll() << std::endl;
+}
+
+// pushing one of its own elements into a full SmallVector: the element has
+// to be copied before growing moves it away, inline storage and heap alike
+void pushBackOwnElement() {
+    SmallVector<std::string, 2> v{"first, long enough to be on the heap", "second"};
+    v.push_back(v[0]);           // full inline storage -> heap
+    v.emplace_back(v.back());    // full heap block -> bigger one
+    v.push_back(v[1]);
+    assert(v.size() == 5 && v[2] == v[0] && v[3] == v[0] && v[4] == "second");
+    std::cout << "pushBackOwnElement: " << v.size() << " elements, last: " << v[4] << std::endl;
+}
+
 int main() {
     // TIP Press <shortcut actionId="RenameElement"/> when your caret is at the
     // <b>lang</b> variable name to see how CLion can help you rename it.
@@ -64,6 +92,10 @@ int main() {
     workWithCustomer();
     std::cout << "=================" <<std::endl;
     makeACollectionOfCustomers();
+    // without the reserve() above this shows the moves made by every reallocation
+    track::report<Customer>("Customer");
+    makeACustomerTable();
+    pushBackOwnElement();
 
     auto b = "asdfjk"; // b is const char*
     auto c = "hey"s;// c is std::string, needs both <string> and "using namespace std::string_literals"
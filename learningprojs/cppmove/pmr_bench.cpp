@@ -0,0 +1,72 @@
+// short-lived batches of customers on several threads at once, allocated from
+//   - the default resource (global new/delete)
+//   - a per-thread RequestArena, reset once per batch
+//   - a per-thread FixedPoolResource
+//   - std::pmr::unsynchronized_pool_resource, for reference
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "customer.h"
+#include "pmr_resources.h"
+
+constexpr std::size_t kBatch = 1000;
+constexpr int kValues = 12; // spills past SmallVector's 8 inline ints
+
+// long enough to spill out of SmallString<24> as well
+static std::string nameFor(std::size_t i) { return "Customer with a long name #" + std::to_string(i); }
+
+static std::int64_t runBatch(std::pmr::memory_resource* mr, std::size_t batchNo) {
+    std::pmr::vector<Customer> batch(mr);
+    batch.reserve(kBatch);
+    for (std::size_t i = 0; i < kBatch; ++i) {
+        Customer& c = batch.emplace_back(nameFor(batchNo * kBatch + i));
+        for (int v = 0; v < kValues; ++v) c.addValue(v);
+    }
+    std::int64_t sum = 0;
+    for (const Customer& c : batch) {
+        for (int v : c.get_values()) sum += v;
+    }
+    return sum;
+}
+
+// perThread(threadIndex) runs all batches of one thread
+static void run(const char* label, int threads, const std::function<void(int)>& perThread) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) workers.emplace_back(perThread, t);
+    for (auto& w : workers) w.join();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << label << ms << " ms\n";
+}
+
+int main(int argc, char** argv) {
+    const std::size_t batches = argc > 1 ? std::stoull(argv[1]) : 500;
+    const int threads = 4;
+
+    run("new/delete:                   ", threads, [&](int) {
+        for (std::size_t b = 0; b < batches; ++b) runBatch(std::pmr::new_delete_resource(), b);
+    });
+    run("RequestArena (monotonic):     ", threads, [&](int) {
+        auto arena = std::make_unique<RequestArena<256 * 1024>>();
+        for (std::size_t b = 0; b < batches; ++b) {
+            runBatch(arena->resource(), b);
+            arena->reset();
+        }
+    });
+    run("FixedPoolResource:            ", threads, [&](int) {
+        FixedPoolResource pool;
+        for (std::size_t b = 0; b < batches; ++b) runBatch(&pool, b);
+    });
+    run("unsynchronized_pool_resource: ", threads, [&](int) {
+        std::pmr::unsynchronized_pool_resource pool;
+        for (std::size_t b = 0; b < batches; ++b) runBatch(&pool, b);
+    });
+    return 0;
+}
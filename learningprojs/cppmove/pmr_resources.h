@@ -0,0 +1,113 @@
+#pragma once
+
+// Memory resources to plug into Customer / CustomerTable / std::pmr containers.
+//
+// FixedPoolResource: power-of-two size classes (8..512 bytes), each a free
+// list carved out of 64 KiB chunks. No locking, so give each thread its own.
+// Bigger requests go straight to the upstream resource.
+//
+// RequestArena: a monotonic_buffer_resource that starts in an inline buffer.
+// Everything allocated while handling one request/batch is dropped by a
+// single reset(); individual deallocations are no-ops.
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+class FixedPoolResource : public std::pmr::memory_resource {
+public:
+    static constexpr std::size_t kMinBlock = 8;
+    static constexpr std::size_t kMaxBlock = 512;
+    static constexpr std::size_t kChunkBytes = 64 * 1024;
+
+    explicit FixedPoolResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream(upstream) {}
+
+    FixedPoolResource(const FixedPoolResource&) = delete;
+    FixedPoolResource& operator=(const FixedPoolResource&) = delete;
+
+    ~FixedPoolResource() override { release(); }
+
+    // returns every chunk to upstream; all blocks handed out become invalid
+    void release() {
+        for (void* chunk : chunks) upstream->deallocate(chunk, kChunkBytes, alignof(std::max_align_t));
+        chunks.clear();
+        for (auto& head : freeLists) head = nullptr;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static constexpr std::size_t kClasses = 7; // 8, 16, ..., 512
+
+    static std::size_t classOf(std::size_t bytes) {
+        std::size_t cls = 0;
+        for (std::size_t size = kMinBlock; size < bytes; size <<= 1) ++cls;
+        return cls;
+    }
+
+    // a block of size 2^k in a max_align_t-aligned chunk is aligned to
+    // 2^k, so the class also has to be big enough for align (8 bytes at
+    // 16-byte alignment takes a 16-byte block)
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        if (bytes > kMaxBlock || align > alignof(std::max_align_t)) return upstream->allocate(bytes, align);
+        const std::size_t cls = classOf(std::max(bytes, align));
+        if (!freeLists[cls]) refill(cls);
+        FreeBlock* block = freeLists[cls];
+        freeLists[cls] = block->next;
+        return block;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+        if (bytes > kMaxBlock || align > alignof(std::max_align_t)) {
+            upstream->deallocate(p, bytes, align);
+            return;
+        }
+        const std::size_t cls = classOf(std::max(bytes, align));
+        auto* block = static_cast<FreeBlock*>(p);
+        block->next = freeLists[cls];
+        freeLists[cls] = block;
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void refill(std::size_t cls) {
+        const std::size_t blockSize = kMinBlock << cls;
+        auto* chunk = static_cast<char*>(upstream->allocate(kChunkBytes, alignof(std::max_align_t)));
+        chunks.push_back(chunk);
+        // thread the chunk into a free list, lowest address first
+        FreeBlock* head = nullptr;
+        for (std::size_t i = kChunkBytes / blockSize; i-- > 0;) {
+            auto* block = reinterpret_cast<FreeBlock*>(chunk + i * blockSize);
+            block->next = head;
+            head = block;
+        }
+        freeLists[cls] = head;
+    }
+
+    std::pmr::memory_resource* upstream;
+    FreeBlock* freeLists[kClasses] = {};
+    std::vector<void*> chunks;
+};
+
+template <std::size_t InlineBytes = 16 * 1024>
+class RequestArena {
+public:
+    explicit RequestArena(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : arena(buffer, InlineBytes, upstream) {}
+
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &arena; }
+
+    // drops everything allocated since the last reset in one step
+    void reset() { arena.release(); }
+
+private:
+    alignas(std::max_align_t) std::byte buffer[InlineBytes];
+    std::pmr::monotonic_buffer_resource arena;
+};
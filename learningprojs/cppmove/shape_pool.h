@@ -0,0 +1,108 @@
+#pragma once
+
+// ShapePool<Circle, Rectangle, ...>: one contiguous store per concrete shape
+// type instead of one heap block per shape behind a Shape*.
+//
+// Shape is neither copyable nor movable, so elements are constructed in place
+// in fixed-size chunks that never relocate (a plain std::vector would need to
+// move them on growth). draw_all() walks each type's chunks and calls
+// T::draw() by qualified name, which the compiler dispatches statically and
+// can inline, instead of going through the vtable for every shape.
+//
+// References returned by emplace() stay valid until clear() or destruction,
+// and can still be used polymorphically as Shape&.
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Shapes.h"
+
+template <typename T, std::size_t ChunkSize = 4096>
+class ChunkedStore {
+public:
+    ChunkedStore() = default;
+    ChunkedStore(const ChunkedStore&) = delete;
+    ChunkedStore& operator=(const ChunkedStore&) = delete;
+
+    ~ChunkedStore() { clear(); }
+
+    template <typename... Args>
+    T& emplace(Args&&... args) {
+        if (count % ChunkSize == 0 && count / ChunkSize == chunks.size()) {
+            chunks.push_back(std::make_unique<Chunk>());
+        }
+        Chunk& chunk = *chunks[count / ChunkSize];
+        T* obj = ::new (chunk.slot(count % ChunkSize)) T(std::forward<Args>(args)...);
+        ++count;
+        return *obj;
+    }
+
+    // calls f(const T&) on every element, one tight loop per chunk
+    template <typename F>
+    void forEach(F&& f) const {
+        std::size_t left = count;
+        for (const auto& chunk : chunks) {
+            const std::size_t n = left < ChunkSize ? left : ChunkSize;
+            const T* items = chunk->items();
+            for (std::size_t i = 0; i < n; ++i) f(items[i]);
+            left -= n;
+        }
+    }
+
+    std::size_t size() const { return count; }
+
+    // destroys the elements but keeps the chunks for reuse
+    void clear() {
+        std::size_t left = count;
+        for (auto& chunk : chunks) {
+            const std::size_t n = left < ChunkSize ? left : ChunkSize;
+            std::destroy_n(chunk->items(), n);
+            left -= n;
+        }
+        count = 0;
+    }
+
+private:
+    struct Chunk {
+        alignas(T) unsigned char storage[ChunkSize * sizeof(T)];
+
+        void* slot(std::size_t i) { return storage + i * sizeof(T); }
+        T* items() { return std::launder(reinterpret_cast<T*>(storage)); }
+        const T* items() const { return std::launder(reinterpret_cast<const T*>(storage)); }
+    };
+
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    std::size_t count = 0;
+};
+
+template <typename... Shapes>
+class ShapePool {
+    static_assert((std::is_base_of_v<Shape, Shapes> && ...), "ShapePool only holds Shapes");
+
+public:
+    template <typename T, typename... Args>
+    T& emplace(Args&&... args) {
+        return std::get<ChunkedStore<T>>(stores).emplace(std::forward<Args>(args)...);
+    }
+
+    void draw_all() const {
+        (std::get<ChunkedStore<Shapes>>(stores).forEach([](const Shapes& s) { s.Shapes::draw(); }), ...);
+    }
+
+    template <typename T>
+    std::size_t count() const {
+        return std::get<ChunkedStore<T>>(stores).size();
+    }
+
+    std::size_t size() const { return (std::get<ChunkedStore<Shapes>>(stores).size() + ...); }
+
+    void clear() { (std::get<ChunkedStore<Shapes>>(stores).clear(), ...); }
+
+private:
+    std::tuple<ChunkedStore<Shapes>...> stores;
+};
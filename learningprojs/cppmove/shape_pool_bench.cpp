@@ -0,0 +1,79 @@
+// draw millions of shapes: std::vector<std::unique_ptr<Shape>> (one heap
+// block and one virtual call per shape) vs ShapePool (per-type arrays,
+// statically dispatched draw_all)
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Shapes.h"
+#include "shape_pool.h"
+
+template <typename F>
+double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::stoull(argv[1]) : 3'000'000;
+    const int passes = 10;
+
+    std::vector<std::unique_ptr<Shape>> heap;
+    ShapePool<Circle, Rectangle, Triangle> pool;
+
+    // same random mix for both; random order is what a real scene looks like
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> kind(0, 2);
+    std::uniform_real_distribution<double> size(1.0, 10.0);
+    // drawn up front so the timed loops below only build
+    struct Spec {
+        int kind;
+        double a, b;
+    };
+    std::vector<Spec> specs(count);
+    for (auto& s : specs) {
+        s.kind = kind(rng);
+        s.a = size(rng);
+        s.b = size(rng);
+    }
+
+    heap.reserve(count);
+    double buildHeap = timeMs([&] {
+        for (const auto& s : specs) {
+            if (s.kind == 0) heap.push_back(std::make_unique<Circle>(s.a));
+            else if (s.kind == 1) heap.push_back(std::make_unique<Rectangle>(s.a, s.b));
+            else heap.push_back(std::make_unique<Triangle>(s.a, s.b));
+        }
+    });
+    double buildPool = timeMs([&] {
+        for (const auto& s : specs) {
+            if (s.kind == 0) pool.emplace<Circle>(s.a);
+            else if (s.kind == 1) pool.emplace<Rectangle>(s.a, s.b);
+            else pool.emplace<Triangle>(s.a, s.b);
+        }
+    });
+
+    Canvas& canvas = Canvas::current();
+    double drawHeap = timeMs([&] {
+        for (int p = 0; p < passes; ++p) {
+            for (const auto& s : heap) s->draw();
+        }
+    });
+    const double heapCoverage = canvas.coverage;
+    canvas = Canvas{};
+    double drawPool = timeMs([&] {
+        for (int p = 0; p < passes; ++p) pool.draw_all();
+    });
+
+    std::cout << count << " shapes, " << passes << " passes\n";
+    std::cout << "build: unique_ptr " << buildHeap << " ms, pool " << buildPool << " ms\n";
+    std::cout << "draw:  unique_ptr " << drawHeap << " ms, pool " << drawPool << " ms"
+              << (std::abs(heapCoverage - canvas.coverage) < 1e-6 * heapCoverage ? "" : " MISMATCH") << "\n";
+    return 0;
+}
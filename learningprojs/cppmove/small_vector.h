@@ -0,0 +1,273 @@
+#pragma once
+
+// SmallVector<T, N>: a vector that keeps its first N elements inside the
+// object and only goes to the heap when it grows past them. For the common
+// "a handful of ints" case that is zero allocations, and moving a small one
+// moves N elements instead of stealing a pointer, which is still cheap.
+//
+// SmallString<N>: the same idea for text. libstdc++'s std::string only keeps
+// 15 chars inline; names like "TestCustomer 123" already spill.
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+template <typename T, std::size_t N, typename Alloc = std::allocator<T>>
+class SmallVector {
+    static_assert(N > 0, "use std::vector when nothing should be inline");
+    using Traits = std::allocator_traits<Alloc>;
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+    explicit SmallVector(const Alloc& a) : alloc_(a) {}
+
+    SmallVector(std::initializer_list<T> init, const Alloc& a = Alloc()) : alloc_(a) {
+        append(init.begin(), init.end());
+    }
+
+    SmallVector(const SmallVector& other)
+        : alloc_(Traits::select_on_container_copy_construction(other.alloc_)) {
+        append(other.begin(), other.end());
+    }
+
+    SmallVector(const SmallVector& other, const Alloc& a) : alloc_(a) { append(other.begin(), other.end()); }
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : alloc_(other.alloc_) {
+        takeFrom(std::move(other));
+    }
+
+    // a heap block can only be stolen if our allocator can free it
+    SmallVector(SmallVector&& other, const Alloc& a) : alloc_(a) {
+        if (alloc_ == other.alloc_) {
+            takeFrom(std::move(other));
+        } else {
+            append(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+            other.clear();
+        }
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            clear();
+            if constexpr (Traits::propagate_on_container_copy_assignment::value) {
+                if (alloc_ != other.alloc_) releaseHeap();
+                alloc_ = other.alloc_;
+            }
+            append(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept(
+        std::is_nothrow_move_constructible_v<T> &&
+        (Traits::propagate_on_container_move_assignment::value || Traits::is_always_equal::value)) {
+        if (this != &other) {
+            clear();
+            if (Traits::propagate_on_container_move_assignment::value || alloc_ == other.alloc_) {
+                releaseHeap();
+                if constexpr (Traits::propagate_on_container_move_assignment::value) alloc_ = other.alloc_;
+                takeFrom(std::move(other));
+            } else {
+                // e.g. two different pmr resources: move the elements, keep our memory
+                append(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+                other.clear();
+            }
+        }
+        return *this;
+    }
+
+    ~SmallVector() {
+        clear();
+        releaseHeap();
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) return growAndEmplace(std::forward<Args>(args)...);
+        T* slot = ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+    }
+
+    void push_back(const T& v) { emplace_back(v); }
+    void push_back(T&& v) { emplace_back(std::move(v)); }
+
+    void pop_back() {
+        assert(size_ > 0);
+        data_[--size_].~T();
+    }
+
+    template <typename It>
+    void append(It first, It last) {
+        const auto n = static_cast<std::size_t>(std::distance(first, last));
+        if (size_ + n > capacity_) grow(std::max(size_ + n, capacity_ * 2));
+        std::uninitialized_copy(first, last, data_ + size_);
+        size_ += n;
+    }
+
+    void reserve(std::size_t n) {
+        if (n > capacity_) grow(n);
+    }
+
+    void resize(std::size_t n) {
+        reserve(n);
+        while (size_ < n) emplace_back();
+        while (size_ > n) pop_back();
+    }
+
+    void clear() noexcept {
+        std::destroy(begin(), end());
+        size_ = 0;
+    }
+
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+    bool isInline() const { return data_ == inlineData(); }
+    Alloc get_allocator() const { return alloc_; }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    T& operator[](std::size_t i) { return data_[i]; }
+    const T& operator[](std::size_t i) const { return data_[i]; }
+    T& back() { return data_[size_ - 1]; }
+
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+
+private:
+    T* inlineData() { return std::launder(reinterpret_cast<T*>(storage_)); }
+    const T* inlineData() const { return std::launder(reinterpret_cast<const T*>(storage_)); }
+
+    void grow(std::size_t n) {
+        T* bigger = Traits::allocate(alloc_, n);
+        try {
+            std::uninitialized_move(begin(), end(), bigger);
+        } catch (...) {
+            Traits::deallocate(alloc_, bigger, n);
+            throw;
+        }
+        adopt(bigger, n);
+    }
+
+    // args may refer to one of our own elements (v.push_back(v[0])), so
+    // the new element is built before the old ones leave their storage
+    template <typename... Args>
+    T& growAndEmplace(Args&&... args) {
+        const std::size_t n = capacity_ * 2;
+        T* bigger = Traits::allocate(alloc_, n);
+        T* slot = bigger + size_;
+        try {
+            ::new (static_cast<void*>(slot)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            Traits::deallocate(alloc_, bigger, n);
+            throw;
+        }
+        try {
+            std::uninitialized_move(begin(), end(), bigger);
+        } catch (...) {
+            slot->~T();
+            Traits::deallocate(alloc_, bigger, n);
+            throw;
+        }
+        adopt(bigger, n);
+        ++size_;
+        return *slot;
+    }
+
+    // bigger holds our elements, moved: drop the old storage and switch to it
+    void adopt(T* bigger, std::size_t n) {
+        std::destroy(begin(), end());
+        releaseHeap();
+        data_ = bigger;
+        capacity_ = n;
+    }
+
+    void releaseHeap() {
+        if (!isInline()) Traits::deallocate(alloc_, data_, capacity_);
+        data_ = inlineData();
+        capacity_ = N;
+    }
+
+    // *this is empty and inline on entry, and other's heap block (if any)
+    // was allocated by an allocator equal to ours
+    void takeFrom(SmallVector&& other) {
+        if (other.isInline()) {
+            std::uninitialized_move(other.begin(), other.end(), data_);
+            size_ = other.size_;
+            other.clear();
+        } else {
+            data_ = other.data_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.data_ = other.inlineData();
+            other.size_ = 0;
+            other.capacity_ = N;
+        }
+    }
+
+    [[no_unique_address]] Alloc alloc_;
+    T* data_ = inlineData();
+    std::size_t size_ = 0;
+    std::size_t capacity_ = N;
+    alignas(T) unsigned char storage_[N * sizeof(T)];
+};
+
+template <std::size_t N, typename Alloc = std::allocator<char>>
+class SmallString {
+public:
+    using allocator_type = Alloc;
+
+    SmallString() = default;
+    explicit SmallString(const Alloc& a) : chars(a) {}
+    SmallString(std::string_view s, const Alloc& a = Alloc()) : chars(a) { assign(s); }
+    SmallString(const char* s, const Alloc& a = Alloc()) : SmallString(std::string_view(s), a) {}
+    SmallString(const std::string& s, const Alloc& a = Alloc()) : SmallString(std::string_view(s), a) {}
+
+    SmallString(const SmallString&) = default;
+    SmallString(SmallString&&) noexcept = default;
+    SmallString(const SmallString& other, const Alloc& a) : chars(other.chars, a) {}
+    SmallString(SmallString&& other, const Alloc& a) : chars(std::move(other.chars), a) {}
+    SmallString& operator=(const SmallString&) = default;
+    SmallString& operator=(SmallString&&) = default;
+
+    SmallString& operator=(std::string_view s) {
+        assign(s);
+        return *this;
+    }
+
+    std::size_t size() const { return chars.size(); }
+    bool empty() const { return chars.empty(); }
+    bool isInline() const { return chars.isInline(); }
+    std::string_view view() const { return {chars.data(), chars.size()}; }
+    std::string str() const { return std::string(view()); }
+    operator std::string_view() const { return view(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const SmallString& s) { return os << s.view(); }
+    friend bool operator==(const SmallString& a, std::string_view b) { return a.view() == b; }
+
+private:
+    void assign(std::string_view s) {
+        chars.clear();
+        chars.append(s.data(), s.data() + s.size());
+    }
+
+    SmallVector<char, N, Alloc> chars;
+};
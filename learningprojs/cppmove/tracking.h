@@ -0,0 +1,159 @@
+#pragma once
+
+// Counting copies, moves and heap traffic of value types without printing.
+//
+// Put the TRACK_* macros in a type's special member functions:
+//
+//     Customer(const Customer& c) : ... { TRACK_COPY(Customer); }
+//
+// and wrap a workload in a track::AllocScope<T> to charge every operator new
+// made on this thread meanwhile to T. track::report<T>() prints the totals.
+//
+// Allocation counting needs the global operator new/delete replaced, which
+// must happen in exactly one translation unit:
+//
+//     TRACKING_DEFINE_GLOBAL_NEW()
+//
+// Tracking is on by default in debug builds and compiled out entirely (the
+// macros expand to nothing, operator new is left alone) when NDEBUG is set.
+// Define TRACKING_ENABLED=1 to keep it on in an optimized build.
+
+#ifndef TRACKING_ENABLED
+#ifdef NDEBUG
+#define TRACKING_ENABLED 0
+#else
+#define TRACKING_ENABLED 1
+#endif
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <string_view>
+
+namespace track {
+
+struct Counts {
+    std::atomic<std::uint64_t> constructions{0};
+    std::atomic<std::uint64_t> copies{0};
+    std::atomic<std::uint64_t> moves{0};
+    std::atomic<std::uint64_t> copyAssigns{0};
+    std::atomic<std::uint64_t> moveAssigns{0};
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> bytes{0};
+
+    void reset() {
+        for (auto* c : {&constructions, &copies, &moves, &copyAssigns, &moveAssigns, &allocations, &bytes}) {
+            c->store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+template <typename T>
+inline Counts counts;
+
+// allocations made by this thread, read by AllocScope
+struct ThreadAllocs {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+};
+
+inline ThreadAllocs& threadAllocs() {
+    thread_local ThreadAllocs allocs;
+    return allocs;
+}
+
+inline void countAllocation(std::size_t size) {
+    auto& allocs = threadAllocs();
+    ++allocs.allocations;
+    allocs.bytes += size;
+}
+
+template <typename T>
+class AllocScope {
+public:
+    AllocScope() : start(threadAllocs()) {}
+
+    ~AllocScope() {
+        const ThreadAllocs& now = threadAllocs();
+        counts<T>.allocations.fetch_add(now.allocations - start.allocations, std::memory_order_relaxed);
+        counts<T>.bytes.fetch_add(now.bytes - start.bytes, std::memory_order_relaxed);
+    }
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+    ThreadAllocs start;
+};
+
+template <typename T>
+void report(std::string_view name, std::ostream& os = std::cout) {
+#if TRACKING_ENABLED
+    const Counts& c = counts<T>;
+    os << name << ": " << c.constructions << " constructed, " << c.copies << " copies, " << c.moves
+       << " moves, " << c.copyAssigns << " copy-assigns, " << c.moveAssigns << " move-assigns, "
+       << c.allocations << " allocations (" << c.bytes << " bytes)\n";
+#else
+    os << name << ": tracking compiled out\n";
+#endif
+}
+
+} // namespace track
+
+#if TRACKING_ENABLED
+
+#define TRACK_CONSTRUCT(T) ::track::counts<T>.constructions.fetch_add(1, std::memory_order_relaxed)
+#define TRACK_COPY(T) ::track::counts<T>.copies.fetch_add(1, std::memory_order_relaxed)
+#define TRACK_MOVE(T) ::track::counts<T>.moves.fetch_add(1, std::memory_order_relaxed)
+#define TRACK_COPY_ASSIGN(T) ::track::counts<T>.copyAssigns.fetch_add(1, std::memory_order_relaxed)
+#define TRACK_MOVE_ASSIGN(T) ::track::counts<T>.moveAssigns.fetch_add(1, std::memory_order_relaxed)
+#define TRACK_ALLOCS(T, var) ::track::AllocScope<T> var
+
+#include <cstdlib>
+#include <new>
+
+#define TRACKING_DEFINE_GLOBAL_NEW()                                                                 \
+    void* operator new(std::size_t size) {                                                           \
+        ::track::countAllocation(size);                                                              \
+        if (void* p = std::malloc(size ? size : 1)) return p;                                        \
+        throw std::bad_alloc();                                                                      \
+    }                                                                                                \
+    /* noinline: otherwise GCC sees new -> free() or new[] -> new and warns about a mismatch */     \
+    [[gnu::noinline]] void* operator new[](std::size_t size) { return ::operator new(size); }        \
+    [[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }                       \
+    [[gnu::noinline]] void operator delete[](void* p) noexcept { std::free(p); }                     \
+    [[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }          \
+    [[gnu::noinline]] void operator delete[](void* p, std::size_t) noexcept { std::free(p); }        \
+    /* over-aligned types; aligned_alloc wants a multiple of the alignment */                       \
+    void* operator new(std::size_t size, std::align_val_t al) {                                      \
+        ::track::countAllocation(size);                                                              \
+        const auto a = static_cast<std::size_t>(al);                                                 \
+        if (void* p = std::aligned_alloc(a, size ? (size + a - 1) / a * a : a)) return p;            \
+        throw std::bad_alloc();                                                                      \
+    }                                                                                                \
+    [[gnu::noinline]] void* operator new[](std::size_t size, std::align_val_t al) {                  \
+        return ::operator new(size, al);                                                             \
+    }                                                                                                \
+    [[gnu::noinline]] void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }     \
+    [[gnu::noinline]] void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }   \
+    [[gnu::noinline]] void operator delete(void* p, std::size_t, std::align_val_t) noexcept {        \
+        std::free(p);                                                                                \
+    }                                                                                                \
+    [[gnu::noinline]] void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {      \
+        std::free(p);                                                                                \
+    }
+
+#else
+
+#define TRACK_CONSTRUCT(T) ((void)0)
+#define TRACK_COPY(T) ((void)0)
+#define TRACK_MOVE(T) ((void)0)
+#define TRACK_COPY_ASSIGN(T) ((void)0)
+#define TRACK_MOVE_ASSIGN(T) ((void)0)
+#define TRACK_ALLOCS(T, var) ((void)0)
+#define TRACKING_DEFINE_GLOBAL_NEW()
+
+#endif
@@ -1,4 +1,9 @@
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <variant>
+
 class IRenderer
 {
 public:
@@ -7,43 +12,115 @@ public:
     virtual ~IRenderer() = default; // good practice for cleanup of implementers
 };
 
-class OpenGLRenderer : public IRenderer
+// Backends are plain classes with non-virtual render()/update().
+// A loop that knows the concrete backend type can inline both calls;
+// a loop over IRenderer* pays an indirect call per frame.
+class OpenGLRenderer
 {
 public:
-    void render() override
-    {
-        std::cout << "OpenGLRenderer::render()" << std::endl;
-    }
-    void update() override
-    {
-        std::cout << "OpenGLRenderer::update()" << std::endl;
-    }
+    static constexpr const char *name = "OpenGL";
+
+    void update() { position = position * 0.5 + 1.0; }
+    void render() { checksum += position; }
+
+    double checksum = 0;
+
+private:
+    double position = 0;
 };
 
-class VulkanRenderer : public IRenderer
+class VulkanRenderer
 {
 public:
-    void render() override
-    {
-        std::cout << "VulkanRenderer::render()" << std::endl;
-    }
-    void update() override
+    static constexpr const char *name = "Vulkan";
+
+    void update() { tick = tick * 3 + 1; }
+    void render() { checksum += static_cast<double>(tick & 0xff); }
+
+    double checksum = 0;
+
+private:
+    unsigned tick = 0;
+};
+
+// Wraps any backend in the IRenderer interface, for plugins and other
+// code that only knows about IRenderer.
+template <typename Backend>
+class RendererAdapter : public IRenderer
+{
+public:
+    void render() override { backend.render(); }
+    void update() override { backend.update(); }
+
+    Backend backend;
+};
+
+// Every backend known at compile time; which one is used is decided at startup.
+using AnyRenderer = std::variant<OpenGLRenderer, VulkanRenderer>;
+
+AnyRenderer makeRenderer(const std::string &name)
+{
+    if (name == VulkanRenderer::name)
+        return VulkanRenderer{};
+    return OpenGLRenderer{};
+}
+
+std::unique_ptr<IRenderer> makePluginRenderer(const std::string &name)
+{
+    if (name == VulkanRenderer::name)
+        return std::make_unique<RendererAdapter<VulkanRenderer>>();
+    return std::make_unique<RendererAdapter<OpenGLRenderer>>();
+}
+
+template <typename Backend>
+void frameLoop(Backend &renderer, long frames)
+{
+    for (long i = 0; i < frames; ++i)
     {
-        std::cout << "VulkanRenderer::update()" << std::endl;
+        renderer.update();
+        renderer.render();
     }
-};
+}
 
-int main()
+// dispatch once, outside the loop; frameLoop<Backend> is then fully inlined
+void runFrames(AnyRenderer &renderer, long frames)
 {
-    IRenderer *renderer = new OpenGLRenderer();
-    renderer->render();
-    renderer->update();
-    delete renderer;
+    std::visit([frames](auto &backend) { frameLoop(backend, frames); }, renderer);
+}
+
+double checksumOf(const AnyRenderer &renderer)
+{
+    return std::visit([](const auto &backend) { return backend.checksum; }, renderer);
+}
+
+template <typename F>
+double timeMs(F &&f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// usage: interfaces [OpenGL|Vulkan] [frames]
+int main(int argc, char **argv)
+{
+    const std::string backend = argc > 1 ? argv[1] : "OpenGL";
+    const long frames = argc > 2 ? std::stol(argv[2]) : 50'000'000;
+
+    std::unique_ptr<IRenderer> plugin = makePluginRenderer(backend);
+    double virtualMs = timeMs([&] { frameLoop(*plugin, frames); });
+
+    AnyRenderer renderer = makeRenderer(backend);
+    double staticMs = timeMs([&] { runFrames(renderer, frames); });
+
+    double pluginChecksum = backend == VulkanRenderer::name
+                                ? static_cast<RendererAdapter<VulkanRenderer> &>(*plugin).backend.checksum
+                                : static_cast<RendererAdapter<OpenGLRenderer> &>(*plugin).backend.checksum;
 
-    renderer = new VulkanRenderer();
-    renderer->render();
-    renderer->update();
-    delete renderer;
+    std::cout << backend << ", " << frames << " frames of update()+render()\n";
+    std::cout << "IRenderer* (virtual): " << virtualMs << " ms\n";
+    std::cout << "variant (static):     " << staticMs << " ms\n";
+    std::cout << "checksums " << (pluginChecksum == checksumOf(renderer) ? "match" : "DIFFER") << std::endl;
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,332 @@
+#pragma once
+
+// FastReader / FastWriter: buffered text I/O straight over read(2) and
+// write(2), for programs that move a lot of numbers through stdin/stdout
+// or files.
+//
+// iostreams pay for things these programs do not use: syncing with
+// stdio (cin/cout read and write through C's FILE buffers by default),
+// locale-aware number parsing, a virtual call per buffer refill, and
+// `endl`, which flushes, i.e. one write(2) per line. Here numbers go
+// through std::from_chars / std::to_chars, the buffers are 1 MiB, and
+// nothing is flushed until the buffer fills or the writer is destroyed.
+// A regular file given to FastReader is mmap()ed instead of read.
+//
+//   FastReader in;              // stdin, or FastReader in("input.txt")
+//   FastWriter out;             // stdout, or FastWriter out("output.txt")
+//   int n;
+//   while (in >> n) out << n * 2 << '\n';
+//
+// Differences from iostreams: whitespace is ' ', '\t', '\n', '\r', '\v',
+// '\f' regardless of locale; floating point is written in the shortest
+// form that reads back exactly (0.1 + 0.2 prints 0.30000000000000004);
+// signed char and unsigned char (so int8_t and uint8_t) are numbers both
+// ways, where iostreams treat them as characters: only char is a character;
+// bool is written as 0 or 1, as iostreams do without boolalpha; and a
+// FastWriter only reaches the file when it flushes.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace fastio {
+
+template <typename T>
+concept Number = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>;
+
+inline bool isSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+class FastReader {
+public:
+    static constexpr size_t kBufferSize = 1 << 20;
+
+    // reads fd, which stays open
+    explicit FastReader(int fd = STDIN_FILENO) : fd_(fd) { init(); }
+
+    explicit FastReader(const char* path) : fd_(::open(path, O_RDONLY | O_CLOEXEC)), owned_(true) {
+        if (fd_ < 0) throw std::system_error(errno, std::generic_category(), path);
+        init();
+    }
+
+    ~FastReader() {
+        if (map_) ::munmap(map_, mapSize_);
+        if (owned_) ::close(fd_);
+    }
+
+    FastReader(const FastReader&) = delete;
+    FastReader& operator=(const FastReader&) = delete;
+
+    // false once a >> has failed, like a stream's failbit
+    explicit operator bool() const { return !failed_; }
+    bool mapped() const { return map_ != nullptr; }
+
+    // true when only whitespace is left
+    bool eof() {
+        skipSpace();
+        return pos_ == end_;
+    }
+
+    template <Number T>
+    bool read(T& value) {
+        if constexpr (std::is_integral_v<T>) {
+            // parse in place: only digits follow the sign, so a number
+            // that stops before end_ is complete; one that reaches end_,
+            // or a lone sign there, may go on after a refill
+            skipSpace();
+            for (;;) {
+                const char* first = pos_;
+                // from_chars takes no leading '+', operator>> does
+                if (first != end_ && *first == '+') ++first;
+                const auto [ptr, ec] = std::from_chars(first, end_, value);
+                const bool cut = ptr == end_ || (ec != std::errc() && end_ - pos_ == 1);
+                if (cut && fill()) continue;
+                if (ec != std::errc() || ptr == first) return false;
+                pos_ = ptr;
+                return true;
+            }
+        } else {
+            // "1e" + "5" split across a refill would parse as 1: take the
+            // whole word first
+            const std::string_view token = nextToken();
+            const char* first = token.data();
+            const char* last = first + token.size();
+            if (first != last && *first == '+') ++first;
+            const auto [ptr, ec] = std::from_chars(first, last, value);
+            if (ec != std::errc() || ptr == first) return false;
+            pos_ = ptr; // like >>, leave what follows the number for the next read
+            return true;
+        }
+    }
+
+    // the next whitespace-delimited word
+    bool read(std::string& word) {
+        std::string_view view;
+        if (!read(view)) return false;
+        word.assign(view);
+        return true;
+    }
+
+    // the next word, in place; valid until the next call
+    bool read(std::string_view& word) {
+        word = nextToken();
+        pos_ = word.data() + word.size();
+        return !word.empty();
+    }
+
+    bool read(char& c) {
+        skipSpace();
+        if (pos_ == end_) return false;
+        c = *pos_++;
+        return true;
+    }
+
+    // the rest of the current line, without its '\n'; false at end of input.
+    // The view is valid until the next call.
+    bool readLine(std::string_view& line) {
+        size_t scanned = 0;
+        for (;;) {
+            if (const void* nl = std::memchr(pos_ + scanned, '\n', static_cast<size_t>(end_ - pos_) - scanned)) {
+                const char* stop = static_cast<const char*>(nl);
+                line = {pos_, static_cast<size_t>(stop - pos_)};
+                pos_ = stop + 1;
+                break;
+            }
+            scanned = static_cast<size_t>(end_ - pos_);
+            if (fill()) continue;
+            if (pos_ == end_) return false;
+            line = {pos_, static_cast<size_t>(end_ - pos_)};
+            pos_ = end_;
+            break;
+        }
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        return true;
+    }
+
+    // the next character, whitespace included; -1 at end of input
+    int get() {
+        if (pos_ == end_ && !fill()) return -1;
+        return static_cast<unsigned char>(*pos_++);
+    }
+
+    template <typename T>
+    FastReader& operator>>(T& value) {
+        if (!failed_ && !read(value)) failed_ = true;
+        return *this;
+    }
+
+private:
+    void init() {
+        struct stat st{};
+        if (::fstat(fd_, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (p != MAP_FAILED) {
+                ::madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+                map_ = p;
+                mapSize_ = static_cast<size_t>(st.st_size);
+                pos_ = static_cast<const char*>(p);
+                end_ = pos_ + mapSize_;
+                return;
+            }
+        }
+        capacity_ = kBufferSize;
+        buffer_ = std::make_unique<char[]>(capacity_);
+        pos_ = end_ = buffer_.get();
+    }
+
+    // Reads more input after end_, keeping [pos_, end_) (moved to the
+    // front of the buffer, which grows if that is all it holds). False at
+    // end of input.
+    bool fill() {
+        if (map_ || eofSeen_) return false;
+        const size_t kept = static_cast<size_t>(end_ - pos_);
+        if (kept == capacity_) {
+            capacity_ *= 2;
+            auto bigger = std::make_unique<char[]>(capacity_);
+            std::memcpy(bigger.get(), pos_, kept);
+            buffer_ = std::move(bigger);
+        } else if (pos_ != buffer_.get()) {
+            std::memmove(buffer_.get(), pos_, kept);
+        }
+        pos_ = buffer_.get();
+        end_ = pos_ + kept;
+        for (;;) {
+            const ssize_t n = ::read(fd_, buffer_.get() + kept, capacity_ - kept);
+            if (n > 0) {
+                end_ += n;
+                return true;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            eofSeen_ = true;
+            return false;
+        }
+    }
+
+    void skipSpace() {
+        for (;;) {
+            while (pos_ != end_ && isSpace(*pos_)) ++pos_;
+            if (pos_ != end_ || !fill()) return;
+        }
+    }
+
+    // the next word, without consuming it
+    std::string_view nextToken() {
+        skipSpace();
+        size_t n = 0;
+        for (;;) {
+            while (pos_ + n != end_ && !isSpace(pos_[n])) ++n;
+            if (pos_ + n != end_ || !fill()) return {pos_, n};
+        }
+    }
+
+    int fd_;
+    bool owned_ = false;
+    bool failed_ = false;
+    bool eofSeen_ = false;
+    std::unique_ptr<char[]> buffer_;
+    size_t capacity_ = 0;
+    void* map_ = nullptr;
+    size_t mapSize_ = 0;
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+};
+
+class FastWriter {
+public:
+    static constexpr size_t kBufferSize = 1 << 20;
+
+    // writes to fd, which stays open
+    explicit FastWriter(int fd = STDOUT_FILENO) : fd_(fd), buffer_(std::make_unique<char[]>(kBufferSize)) {}
+
+    // creates or truncates path
+    explicit FastWriter(const char* path)
+        : fd_(::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)), owned_(true),
+          buffer_(std::make_unique<char[]>(kBufferSize)) {
+        if (fd_ < 0) throw std::system_error(errno, std::generic_category(), path);
+    }
+
+    ~FastWriter() {
+        flush();
+        if (owned_) ::close(fd_);
+    }
+
+    FastWriter(const FastWriter&) = delete;
+    FastWriter& operator=(const FastWriter&) = delete;
+
+    // false once a write(2) has failed
+    explicit operator bool() const { return !failed_; }
+
+    void write(char c) {
+        if (used_ == kBufferSize) flush();
+        buffer_[used_++] = c;
+    }
+
+    // without this, bool would convert to char and write byte 0 or 1
+    void write(bool b) { write(b ? '1' : '0'); }
+
+    void write(std::string_view s) {
+        if (s.size() > kBufferSize - used_) {
+            flush();
+            if (s.size() >= kBufferSize) return writeAll(s.data(), s.size());
+        }
+        std::memcpy(buffer_.get() + used_, s.data(), s.size());
+        used_ += s.size();
+    }
+
+    template <Number T>
+    void write(T value) {
+        // enough for any integer and the shortest form of any double
+        constexpr size_t kMaxChars = 32;
+        if (kBufferSize - used_ < kMaxChars) flush();
+        char* const first = buffer_.get() + used_;
+        used_ += static_cast<size_t>(std::to_chars(first, first + kMaxChars, value).ptr - first);
+    }
+
+    template <typename T>
+    FastWriter& operator<<(const T& value) {
+        if constexpr (std::is_convertible_v<const T&, std::string_view>)
+            write(std::string_view(value));
+        else
+            write(value);
+        return *this;
+    }
+
+    void flush() {
+        writeAll(buffer_.get(), used_);
+        used_ = 0;
+    }
+
+private:
+    void writeAll(const char* p, size_t n) {
+        while (n > 0 && !failed_) {
+            const ssize_t w = ::write(fd_, p, n);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                failed_ = true;
+                return;
+            }
+            p += w;
+            n -= static_cast<size_t>(w);
+        }
+    }
+
+    int fd_;
+    bool owned_ = false;
+    bool failed_ = false;
+    std::unique_ptr<char[]> buffer_;
+    size_t used_ = 0;
+};
+
+} // namespace fastio
+
+using fastio::FastReader;
+using fastio::FastWriter;
@@ -0,0 +1,143 @@
+// Writes a file of integers, one per line, and reads it back with each
+// method, comparing iostreams and stdio against fastio.h. Every reader
+// sums what it read, so a wrong parse shows up as a different sum.
+//
+//   g++ -std=c++20 -O2 fastio_bench.cpp -o fastio_bench
+//   ./fastio_bench [megabytes, default 100] [file, default /tmp/fastio_bench.txt]
+//
+// `cin` is measured as a program would see it: stdin redirected to the
+// file, sync_with_stdio left on. The second cin run turns it off (a
+// stream can't be switched back, so that run comes last).
+
+#include "fastio.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsFor(const std::function<void()>& f) {
+    const auto start = Clock::now();
+    f();
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void report(const char* name, double secs, double mb, long long sum) {
+    std::printf("%-34s %7.3f s  %7.1f MB/s  sum %lld\n", name, secs, mb / secs, sum);
+    std::fflush(stdout);
+}
+
+// the same numbers every time: values of 1 to 9 digits, some negative
+struct Numbers {
+    std::mt19937 rng{42};
+    int next() {
+        static constexpr uint32_t kLimit[] = {10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+        const int v = static_cast<int>(rng() % kLimit[rng() % 9]);
+        return rng() % 4 == 0 ? -v : v;
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const double mb = argc > 1 ? std::atof(argv[1]) : 100;
+    const std::string path = argc > 2 ? argv[2] : "/tmp/fastio_bench.txt";
+    const size_t target = static_cast<size_t>(mb * 1024 * 1024);
+
+    // the numbers are made up front, so the writers only time the writing
+    std::vector<int> values;
+    Numbers numbers;
+    for (size_t bytes = 0; bytes < target;) {
+        char text[16];
+        values.push_back(numbers.next());
+        bytes += static_cast<size_t>(std::to_chars(text, text + sizeof(text), values.back()).ptr - text) + 1;
+    }
+    std::printf("%zu numbers, %.0f MB\n\nwriting\n", values.size(), mb);
+
+    double secs = secondsFor([&] {
+        FastWriter out(path.c_str());
+        for (int v : values) out << v << '\n';
+    });
+    report("FastWriter", secs, mb, 0);
+    const std::string scratch = path + ".out";
+    secs = secondsFor([&] {
+        std::ofstream out(scratch);
+        for (int v : values) out << v << '\n';
+    });
+    report("ofstream << '\\n'", secs, mb, 0);
+    secs = secondsFor([&] {
+        std::ofstream out(scratch);
+        for (int v : values) out << v << std::endl;
+    });
+    report("ofstream << endl", secs, mb, 0);
+    secs = secondsFor([&] {
+        FILE* out = std::fopen(scratch.c_str(), "w");
+        for (int v : values) std::fprintf(out, "%d\n", v);
+        std::fclose(out);
+    });
+    report("fprintf", secs, mb, 0);
+    std::remove(scratch.c_str());
+
+    std::printf("\nreading\n");
+    long long sum = 0;
+    secs = secondsFor([&] {
+        FastReader in(path.c_str());
+        sum = 0;
+        for (int v = 0; in >> v;) sum += v;
+    });
+    report("FastReader (mmap)", secs, mb, sum);
+    secs = secondsFor([&] {
+        // a pipe can't be mapped: plain read(2) into the buffer
+        FILE* pipe = ::popen(("cat " + path).c_str(), "r");
+        {
+            FastReader in(::fileno(pipe));
+            sum = 0;
+            for (int v = 0; in >> v;) sum += v;
+        }
+        ::pclose(pipe);
+    });
+    report("FastReader (read(2) from a pipe)", secs, mb, sum);
+    secs = secondsFor([&] {
+        FILE* in = std::fopen(path.c_str(), "r");
+        sum = 0;
+        for (int v = 0; std::fscanf(in, "%d", &v) == 1;) sum += v;
+        std::fclose(in);
+    });
+    report("fscanf", secs, mb, sum);
+    secs = secondsFor([&] {
+        std::ifstream in(path);
+        sum = 0;
+        for (int v = 0; in >> v;) sum += v;
+    });
+    report("ifstream >>", secs, mb, sum);
+
+    if (!std::freopen(path.c_str(), "r", stdin)) return 1;
+    secs = secondsFor([&] {
+        sum = 0;
+        for (int v = 0; std::cin >> v;) sum += v;
+    });
+    report("cin >> (synced with stdio)", secs, mb, sum);
+    if (!std::freopen(path.c_str(), "r", stdin)) return 1;
+    std::cin.clear();
+    std::ios_base::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+    secs = secondsFor([&] {
+        sum = 0;
+        for (int v = 0; std::cin >> v;) sum += v;
+    });
+    report("cin >> (sync_with_stdio(false))", secs, mb, sum);
+
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,36 @@
+// rdbufexample.cpp with fastio.h: instead of swapping the buffers of
+// cin/cout, read and write the files directly. Nothing is written to
+// output.txt until `out` flushes, here when it goes out of scope.
+//
+//   g++ -std=c++20 -O2 fastioexample.cpp -o fastioexample && ./fastioexample
+
+#include "fastio.h"
+
+#include <cstdio>
+#include <string>
+#include <system_error>
+
+int main()
+{
+    try {
+        FastReader in("input.txt");
+        FastWriter out("output.txt");
+
+        // Suppose input.txt contains:
+        //   42 Hello
+        int number = 0;
+        std::string word;
+        if (!(in >> number >> word)) {
+            std::fprintf(stderr, "input.txt: expected a number and a word\n");
+            return 1;
+        }
+        out << "Read from input.txt: " << number << " and \"" << word << "\"\n";
+    } catch (const std::system_error& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    FastWriter console;
+    console << "Finished. Check output.txt for the results.\n";
+    return 0;
+}
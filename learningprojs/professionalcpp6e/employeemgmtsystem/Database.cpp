@@ -0,0 +1,380 @@
+module;
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+module employee;
+import std;
+using namespace std;
+
+namespace Records {
+    // The file written by save(): a header, then each column as one block,
+    // in the machine's (little-endian) byte order.
+    //   "EMPDB\0\0\1"  count (u64)  names size (u64)
+    //   employee numbers (i32 x count)  salaries (i32 x count)  hired (u8 x count)
+    //   name lengths (u16 first, u16 last, x count)
+    //   names (first then last for each employee, no separators)
+    static_assert(endian::native == endian::little);
+    constexpr array<char, 8> FileMagic{ 'E', 'M', 'P', 'D', 'B', '\0', '\0', '\1' };
+
+    MappedFile::MappedFile(const filesystem::path& path)
+    {
+        const int fd{ ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+        if (fd < 0) { throw runtime_error{ format("Unable to open {}.", path.string()) }; }
+        struct stat info{};
+        void* data{ MAP_FAILED };
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            data = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (info.st_size == 0) { return; }
+        if (data == MAP_FAILED) { throw runtime_error{ format("Unable to map {}.", path.string()) }; }
+        ::madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(data);
+        m_size = static_cast<size_t>(info.st_size);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (m_data) { ::munmap(const_cast<char*>(m_data), m_size); }
+    }
+
+    void Database::Index::clear()
+    {
+        m_slots.clear();
+        m_mask = 0;
+        m_shift = 64;
+        m_size = 0;
+    }
+
+    void Database::Index::reserve(size_t count)
+    {
+        // At most half full: probes stay short
+        const size_t slotCount{ bit_ceil(max<size_t>(count * 2, 16)) };
+        if (slotCount > m_slots.size()) { rehash(slotCount); }
+    }
+
+    void Database::Index::insert(uint32_t tag, uint32_t row)
+    {
+        if ((m_size + 1) * 2 > m_slots.size()) { rehash(max<size_t>(m_slots.size() * 2, 16)); }
+        size_t i{ home(tag) };
+        while (m_slots[i].row != Empty) { i = (i + 1) & m_mask; }
+        m_slots[i] = { tag, row };
+        ++m_size;
+    }
+
+    void Database::Index::rehash(size_t slotCount)
+    {
+        vector<Slot> old(slotCount);
+        swap(old, m_slots);
+        m_mask = slotCount - 1;
+        m_shift = 64 - countr_zero(slotCount);
+        // Equal keys share a home slot, so they sit in one run in the order
+        // they were added, and find() returns the first. Walking the old
+        // table from an empty slot (so no run wraps around) reinserts them
+        // in that order.
+        const size_t oldMask{ old.size() - 1 };
+        size_t start{ 0 };
+        while (start < old.size() && old[start].row != Empty) { ++start; }
+        for (size_t n{ 0 }; n < old.size(); ++n) {
+            const Slot& slot{ old[(start + n) & oldMask] };
+            if (slot.row == Empty) { continue; }
+            size_t i{ home(slot.tag) };
+            while (m_slots[i].row != Empty) { i = (i + 1) & m_mask; }
+            m_slots[i] = slot;
+        }
+    }
+
+    uint32_t Database::hashName(string_view firstName, string_view lastName)
+    {
+        const uint64_t first{ hash<string_view>{}(firstName) };
+        const uint64_t both{ first ^ (hash<string_view>{}(lastName) + 0x9e37'79b9'7f4a'7c15ull + (first << 6) + (first >> 2)) };
+        return static_cast<uint32_t>(both ^ (both >> 32));
+    }
+
+    int Database::addEmployee(string_view firstName, string_view lastName, int salary)
+    {
+        while (contains(m_nextEmployeeNumber)) { ++m_nextEmployeeNumber; }
+        const int employeeNumber{ m_nextEmployeeNumber++ };
+        append(employeeNumber, firstName, lastName, salary, true);
+        return employeeNumber;
+    }
+
+    void Database::addEmployee(const Employee& employee)
+    {
+        if (contains(employee.getEmployeeNumber())) {
+            throw invalid_argument{ format("Employee number {} is taken.", employee.getEmployeeNumber()) };
+        }
+        append(employee.getEmployeeNumber(), employee.getFirstName(), employee.getLastName(),
+            employee.getSalary(), employee.isHired());
+    }
+
+    void Database::append(int employeeNumber, string_view firstName, string_view lastName,
+        int salary, bool hired)
+    {
+        if (firstName.size() > numeric_limits<uint16_t>::max() || lastName.size() > numeric_limits<uint16_t>::max()) {
+            throw length_error{ "Employee name too long." };
+        }
+        if (m_names.size() + firstName.size() + lastName.size() > numeric_limits<uint32_t>::max()
+            || m_employeeNumbers.size() >= numeric_limits<uint32_t>::max()) {
+            throw length_error{ "Database full." };
+        }
+        const auto row{ static_cast<uint32_t>(m_employeeNumbers.size()) };
+        m_employeeNumbers.push_back(employeeNumber);
+        m_salaries.push_back(salary);
+        m_hired.push_back(hired);
+        m_nameRefs.push_back({ static_cast<uint32_t>(m_names.size()), static_cast<uint16_t>(firstName.size()),
+            static_cast<uint16_t>(lastName.size()) });
+        m_names.append(firstName);
+        m_names.append(lastName);
+        m_byNumber.insert(static_cast<uint32_t>(employeeNumber), row);
+        m_byName.insert(hashName(firstName, lastName), row);
+        if (employeeNumber >= m_nextEmployeeNumber && employeeNumber < numeric_limits<int>::max()) {
+            m_nextEmployeeNumber = employeeNumber + 1;
+        }
+        salariesChanged();
+    }
+
+    void Database::reserve(size_t count)
+    {
+        m_employeeNumbers.reserve(count);
+        m_salaries.reserve(count);
+        m_hired.reserve(count);
+        m_nameRefs.reserve(count);
+        m_byNumber.reserve(count);
+        m_byName.reserve(count);
+    }
+
+    optional<uint32_t> Database::findRow(int employeeNumber) const
+    {
+        // The tag is the number itself, so a matching tag is the employee
+        return m_byNumber.find(static_cast<uint32_t>(employeeNumber), [](uint32_t) { return true; });
+    }
+
+    uint32_t Database::rowOf(int employeeNumber) const
+    {
+        if (const auto row{ findRow(employeeNumber) }) { return *row; }
+        throw logic_error{ "No employee found." };
+    }
+
+    string_view Database::firstNameAt(uint32_t row) const
+    {
+        const NameRef& name{ m_nameRefs[row] };
+        return string_view{ m_names }.substr(name.offset, name.firstLength);
+    }
+
+    string_view Database::lastNameAt(uint32_t row) const
+    {
+        const NameRef& name{ m_nameRefs[row] };
+        return string_view{ m_names }.substr(name.offset + name.firstLength, name.lastLength);
+    }
+
+    Employee Database::employeeAt(uint32_t row) const
+    {
+        Employee employee{ string{ firstNameAt(row) }, string{ lastNameAt(row) } };
+        employee.setEmployeeNumber(m_employeeNumbers[row]);
+        employee.setSalary(m_salaries[row]);
+        if (m_hired[row]) { employee.hire(); }
+        return employee;
+    }
+
+    Employee Database::getEmployee(int employeeNumber) const
+    {
+        return employeeAt(rowOf(employeeNumber));
+    }
+
+    Employee Database::getEmployee(string_view firstName, string_view lastName) const
+    {
+        const auto row{ m_byName.find(hashName(firstName, lastName), [&](uint32_t candidate) {
+            return firstNameAt(candidate) == firstName && lastNameAt(candidate) == lastName;
+        }) };
+        if (!row) { throw logic_error{ "No employee found." }; }
+        return employeeAt(*row);
+    }
+
+    bool Database::contains(int employeeNumber) const { return findRow(employeeNumber).has_value(); }
+    size_t Database::size() const { return m_employeeNumbers.size(); }
+
+    void Database::setSalary(int employeeNumber, int newSalary)
+    {
+        m_salaries[rowOf(employeeNumber)] = newSalary;
+        salariesChanged();
+    }
+
+    void Database::promote(int employeeNumber, int raiseAmount)
+    {
+        m_salaries[rowOf(employeeNumber)] += raiseAmount;
+        salariesChanged();
+    }
+
+    void Database::demote(int employeeNumber, int demeritAmount)
+    {
+        m_salaries[rowOf(employeeNumber)] -= demeritAmount;
+        salariesChanged();
+    }
+
+    void Database::hire(int employeeNumber) { m_hired[rowOf(employeeNumber)] = true; }
+    void Database::fire(int employeeNumber) { m_hired[rowOf(employeeNumber)] = false; }
+
+    void Database::salariesChanged()
+    {
+        m_salaryIndexValid = false;
+        m_scannedSinceChange = false;
+    }
+
+    vector<int> Database::employeesWithSalary(int low, int high) const
+    {
+        vector<int> employeeNumbers;
+        if (low > high) { return employeeNumbers; }
+        // Salary in the high half, offset so the order of the unsigned
+        // keys is that of the salaries; row in the low half breaks ties
+        const auto key{ [](int salary, uint32_t row) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(salary) ^ 0x8000'0000u) << 32) | row;
+        } };
+        vector<uint64_t> found;
+        if (!m_salaryIndexValid && !m_scannedSinceChange) {
+            // The first query after a change scans the salary column, which
+            // is cheaper than sorting it; a second query with no change in
+            // between is worth building the sorted index for.
+            m_scannedSinceChange = true;
+            for (uint32_t row{ 0 }; row < m_salaries.size(); ++row) {
+                if (m_salaries[row] >= low && m_salaries[row] <= high) { found.push_back(key(m_salaries[row], row)); }
+            }
+            ranges::sort(found);
+        } else {
+            if (!m_salaryIndexValid) {
+                m_bySalary.resize(m_salaries.size());
+                for (uint32_t row{ 0 }; row < m_salaries.size(); ++row) { m_bySalary[row] = key(m_salaries[row], row); }
+                ranges::sort(m_bySalary);
+                m_salaryIndexValid = true;
+            }
+            found.assign(ranges::lower_bound(m_bySalary, key(low, 0)),
+                ranges::upper_bound(m_bySalary, key(high, numeric_limits<uint32_t>::max())));
+        }
+        employeeNumbers.reserve(found.size());
+        for (uint64_t k : found) { employeeNumbers.push_back(m_employeeNumbers[static_cast<uint32_t>(k)]); }
+        return employeeNumbers;
+    }
+
+    int64_t Database::payroll() const
+    {
+        int64_t total{ 0 };
+        for (size_t row{ 0 }; row < m_salaries.size(); ++row) {
+            // Multiplying rather than branching lets the loop vectorize
+            total += static_cast<int64_t>(m_salaries[row]) * (m_hired[row] != 0);
+        }
+        return total;
+    }
+
+    void Database::display(bool current, bool former) const
+    {
+        for (uint32_t row{ 0 }; row < m_employeeNumbers.size(); ++row) {
+            if (m_hired[row] ? current : former) { employeeAt(row).display(); }
+        }
+    }
+
+    void Database::displayAll() const { display(true, true); }
+    void Database::displayCurrent() const { display(true, false); }
+    void Database::displayFormer() const { display(false, true); }
+
+    namespace {
+        template <typename T>
+        void writeColumn(ofstream& out, const vector<T>& column)
+        {
+            out.write(reinterpret_cast<const char*>(column.data()), static_cast<streamsize>(column.size() * sizeof(T)));
+        }
+
+        template <typename T>
+        void readColumn(span<const char>& in, vector<T>& column, size_t count)
+        {
+            column.resize(count);
+            // An empty column's data() may be null, and memcpy() from or to null is undefined
+            if (count == 0) { return; }
+            memcpy(column.data(), in.data(), count * sizeof(T));
+            in = in.subspan(count * sizeof(T));
+        }
+    }
+
+    void Database::save(const filesystem::path& path) const
+    {
+        ofstream out{ path, ios::binary | ios::trunc };
+        const uint64_t count{ m_employeeNumbers.size() };
+        const uint64_t namesSize{ m_names.size() };
+        out.write(FileMagic.data(), FileMagic.size());
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char*>(&namesSize), sizeof(namesSize));
+        writeColumn(out, m_employeeNumbers);
+        writeColumn(out, m_salaries);
+        writeColumn(out, m_hired);
+        vector<uint16_t> lengths(2 * m_nameRefs.size());
+        for (size_t row{ 0 }; row < m_nameRefs.size(); ++row) {
+            lengths[2 * row] = m_nameRefs[row].firstLength;
+            lengths[2 * row + 1] = m_nameRefs[row].lastLength;
+        }
+        writeColumn(out, lengths);
+        out.write(m_names.data(), static_cast<streamsize>(m_names.size()));
+        out.close();
+        if (!out) { throw runtime_error{ format("Unable to write {}.", path.string()) }; }
+    }
+
+    void Database::load(const filesystem::path& path)
+    {
+        const MappedFile file{ path };
+        span<const char> in{ file.bytes() };
+        constexpr size_t HeaderBytes{ FileMagic.size() + 2 * sizeof(uint64_t) };
+        // Per employee: number, salary, hired, two name lengths
+        constexpr uint64_t RowBytes{ 4 + 4 + 1 + 2 + 2 };
+        array<char, 8> magic{};
+        uint64_t count{ 0 };
+        uint64_t namesSize{ 0 };
+        if (in.size() >= HeaderBytes) {
+            memcpy(magic.data(), in.data(), magic.size());
+            memcpy(&count, in.data() + magic.size(), sizeof(count));
+            memcpy(&namesSize, in.data() + magic.size() + sizeof(count), sizeof(namesSize));
+        }
+        if (in.size() < HeaderBytes || magic != FileMagic || count > numeric_limits<uint32_t>::max()
+            || namesSize > numeric_limits<uint32_t>::max() || in.size() != HeaderBytes + count * RowBytes + namesSize) {
+            throw runtime_error{ format("{} is not an employee database.", path.string()) };
+        }
+        in = in.subspan(HeaderBytes);
+
+        Database loaded;
+        readColumn(in, loaded.m_employeeNumbers, count);
+        readColumn(in, loaded.m_salaries, count);
+        readColumn(in, loaded.m_hired, count);
+        vector<uint16_t> lengths;
+        readColumn(in, lengths, 2 * count);
+        loaded.m_names.assign(in.data(), namesSize);
+
+        loaded.m_nameRefs.resize(count);
+        uint64_t offset{ 0 };
+        for (size_t row{ 0 }; row < count; ++row) {
+            loaded.m_nameRefs[row] = { static_cast<uint32_t>(offset), lengths[2 * row], lengths[2 * row + 1] };
+            offset += lengths[2 * row] + lengths[2 * row + 1];
+        }
+        if (offset != namesSize) { throw runtime_error{ format("{} is corrupt.", path.string()) }; }
+        loaded.rebuildIndexes();
+        *this = std::move(loaded);
+    }
+
+    void Database::rebuildIndexes()
+    {
+        m_byNumber.clear();
+        m_byName.clear();
+        m_byNumber.reserve(size());
+        m_byName.reserve(size());
+        m_nextEmployeeNumber = FirstEmployeeNumber;
+        for (uint32_t row{ 0 }; row < size(); ++row) {
+            const int employeeNumber{ m_employeeNumbers[row] };
+            if (findRow(employeeNumber)) {
+                throw runtime_error{ format("Employee number {} appears twice.", employeeNumber) };
+            }
+            m_byNumber.insert(static_cast<uint32_t>(employeeNumber), row);
+            m_byName.insert(hashName(firstNameAt(row), lastNameAt(row)), row);
+            if (employeeNumber >= m_nextEmployeeNumber && employeeNumber < numeric_limits<int>::max()) {
+                m_nextEmployeeNumber = employeeNumber + 1;
+            }
+        }
+        salariesChanged();
+    }
+}
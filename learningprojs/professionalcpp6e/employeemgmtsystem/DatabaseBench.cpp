@@ -0,0 +1,93 @@
+// Times the Database on a few million employees: building it, lookups by
+// number and by name, salary range queries, a payroll scan, and a save
+// and load of the binary file.
+//   DatabaseBench [employees, default 2000000]
+
+import std;
+import employee;
+
+using namespace std;
+using namespace Records;
+
+namespace {
+    using Clock = chrono::steady_clock;
+
+    double secondsFor(const function<void()>& f)
+    {
+        const auto start{ Clock::now() };
+        f();
+        return chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void report(string_view name, double seconds, size_t operations)
+    {
+        println("{:<36} {:9.3f} ms  {:10.1f} ns/op", name, seconds * 1e3, seconds * 1e9 / static_cast<double>(operations));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t count{ argc > 1 ? static_cast<size_t>(atol(argv[1])) : 2'000'000 };
+    constexpr size_t Lookups{ 1'000'000 };
+    const array<string_view, 8> firstNames{ "Jane", "John", "Greg", "Marc", "Ada", "Alan", "Grace", "Linus" };
+    mt19937 rng{ 42 };
+
+    Database db;
+    vector<int> numbers;
+    report("addEmployee", secondsFor([&] {
+        db.reserve(count);
+        numbers.reserve(count);
+        for (size_t i{ 0 }; i < count; ++i) {
+            // unique last names, so a name lookup has exactly one match
+            numbers.push_back(db.addEmployee(firstNames[i % firstNames.size()], format("Doe{}", i),
+                DefaultStartingSalary + static_cast<int>(rng() % 100'000)));
+        }
+    }), count);
+
+    long long checksum{ 0 };
+    vector<int> probes(Lookups);
+    for (int& probe : probes) { probe = numbers[rng() % count]; }
+    report("getEmployee(number)", secondsFor([&] {
+        for (int probe : probes) { checksum += db.getEmployee(probe).getSalary(); }
+    }), Lookups);
+
+    vector<pair<string, string>> names(Lookups / 10);
+    for (auto& [first, last] : names) {
+        const size_t i{ rng() % count };
+        first = firstNames[i % firstNames.size()];
+        last = format("Doe{}", i);
+    }
+    report("getEmployee(first, last)", secondsFor([&] {
+        for (const auto& [first, last] : names) { checksum += db.getEmployee(first, last).getEmployeeNumber(); }
+    }), names.size());
+
+    report("promote", secondsFor([&] {
+        for (int probe : probes) { db.promote(probe, 1); }
+    }), Lookups);
+
+    constexpr int Queries{ 100 };
+    report("salary range, first after a change", secondsFor([&] {
+        checksum += ssize(db.employeesWithSalary(50'000, 50'100));
+    }), 1);
+    report("salary range, builds the index", secondsFor([&] {
+        checksum += ssize(db.employeesWithSalary(50'000, 50'100));
+    }), 1);
+    report("salary range, indexed", secondsFor([&] {
+        for (int i{ 0 }; i < Queries; ++i) {
+            const int low{ DefaultStartingSalary + static_cast<int>(rng() % 100'000) };
+            checksum += ssize(db.employeesWithSalary(low, low + 100));
+        }
+    }), Queries);
+    report("payroll scan", secondsFor([&] {
+        for (int i{ 0 }; i < Queries; ++i) { checksum += db.payroll(); }
+    }), Queries);
+
+    const auto path{ filesystem::temp_directory_path() / "employees_bench.db" };
+    report("save", secondsFor([&] { db.save(path); }), count);
+    Database loaded;
+    report("load", secondsFor([&] { loaded.load(path); }), count);
+    println("{} employees, {:.1f} MB on disk, checksum {}", loaded.size(),
+        static_cast<double>(filesystem::file_size(path)) / (1024 * 1024), checksum);
+    filesystem::remove(path);
+    return loaded.payroll() == db.payroll() ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+import std;
+import employee;
+
+using namespace std;
+using namespace Records;
+
+int main()
+{
+    Database myDB;
+    const int greg{ myDB.addEmployee("Greg", "Wallis") };
+    const int marc{ myDB.addEmployee("Marc", "White", 100'000) };
+    const int john{ myDB.addEmployee("John", "Doe") };
+    myDB.fire(greg);
+    myDB.promote(john, 5'000);
+    myDB.setSalary(marc, 120'000);
+
+    println("all employees:\n");
+    myDB.displayAll();
+    println("current employees:\n");
+    myDB.displayCurrent();
+    println("former employees:\n");
+    myDB.displayFormer();
+
+    println("John Doe is employee {}", myDB.getEmployee("John", "Doe").getEmployeeNumber());
+    println("earning 30000 to 100000: {}", myDB.employeesWithSalary(30'000, 100'000));
+    println("payroll: ${}", myDB.payroll());
+
+    const auto path{ filesystem::temp_directory_path() / "employees.db" };
+    myDB.save(path);
+    Database loaded;
+    loaded.load(path);
+    filesystem::remove(path);
+    println("reloaded {} employees, Marc White earns ${}", loaded.size(), loaded.getEmployee(marc).getSalary());
+
+    try {
+        loaded.getEmployee(42);
+    } catch (const logic_error& e) {
+        println("employee 42: {}", e.what());
+    }
+}
@@ -1,5 +1,295 @@
 export module employee;
-imprt std;
+import std;
+
 namespace Records {
-    
-}
\ No newline at end of file
+    export inline constexpr int DefaultStartingSalary{ 30'000 };
+    export inline constexpr int DefaultRaiseAndDemeritAmount{ 1'000 };
+    export inline constexpr int FirstEmployeeNumber{ 1'000 };
+
+    export class Employee
+    {
+    public:
+        Employee(const std::string& firstName, const std::string& lastName);
+
+        void promote(int raiseAmount = DefaultRaiseAndDemeritAmount);
+        void demote(int demeritAmount = DefaultRaiseAndDemeritAmount);
+        void hire(); // Hires or rehires the employee
+        void fire(); // Dismisses the employee
+        void display() const; // Prints employee info to console
+
+        // Getters and setters
+        void setFirstName(const std::string& firstName);
+        const std::string& getFirstName() const;
+
+        void setLastName(const std::string& lastName);
+        const std::string& getLastName() const;
+
+        void setEmployeeNumber(int employeeNumber);
+        int getEmployeeNumber() const;
+
+        void setSalary(int newSalary);
+        int getSalary() const;
+
+        bool isHired() const;
+
+    private:
+        std::string m_firstName;
+        std::string m_lastName;
+        int m_employeeNumber{ -1 };
+        int m_salary{ DefaultStartingSalary };
+        bool m_hired{ false };
+    };
+
+    // A whole file mapped read-only
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::filesystem::path& path);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        std::span<const char> bytes() const { return { m_data, m_size }; }
+
+    private:
+        const char* m_data{ nullptr };
+        std::size_t m_size{ 0 };
+    };
+
+    // Employees stored column-wise: one vector per field (a name's position
+    // and lengths together, as they are read together), and employee i is
+    // element i of each. A scan reads only the columns it needs (a salary
+    // query 4 bytes per employee instead of a whole Employee and its two
+    // strings), and the names sit back to back in one string instead of in
+    // a heap block each.
+    //
+    // Lookups by employee number and by name go through hash indexes that
+    // hold row numbers only. Employees are never removed; fire() keeps them
+    // as former employees. getEmployee() returns a copy: change an employee
+    // through the Database. Not thread-safe.
+    export class Database
+    {
+    public:
+        // Hires a new employee under the next free employee number, and returns that number
+        int addEmployee(std::string_view firstName, std::string_view lastName,
+            int salary = DefaultStartingSalary);
+        // Adds a copy of employee under its own number, which must be free
+        void addEmployee(const Employee& employee);
+        void reserve(std::size_t count);
+
+        // These throw std::logic_error if there is no such employee
+        Employee getEmployee(int employeeNumber) const;
+        // The first one added with that name
+        Employee getEmployee(std::string_view firstName, std::string_view lastName) const;
+
+        bool contains(int employeeNumber) const;
+        std::size_t size() const;
+
+        void setSalary(int employeeNumber, int newSalary);
+        void promote(int employeeNumber, int raiseAmount = DefaultRaiseAndDemeritAmount);
+        void demote(int employeeNumber, int demeritAmount = DefaultRaiseAndDemeritAmount);
+        void hire(int employeeNumber);
+        void fire(int employeeNumber);
+
+        // Numbers of the employees earning low to high inclusive, in order of salary
+        std::vector<int> employeesWithSalary(int low, int high) const;
+        // Total salary of the current employees
+        std::int64_t payroll() const;
+
+        void displayAll() const;
+        void displayCurrent() const;
+        void displayFormer() const;
+
+        // Whole columns to and from a compact binary file; load() maps the
+        // file and replaces the contents. Both throw std::runtime_error on failure.
+        void save(const std::filesystem::path& path) const;
+        void load(const std::filesystem::path& path);
+
+    private:
+        // Open addressing with linear probing. A slot holds a row and a
+        // 32-bit tag (the key's hash); the key itself stays in the columns,
+        // and find() is given a predicate that checks a candidate row.
+        class Index
+        {
+        public:
+            void clear();
+            void reserve(std::size_t count);
+            void insert(std::uint32_t tag, std::uint32_t row);
+
+            template <typename Matches>
+            std::optional<std::uint32_t> find(std::uint32_t tag, Matches matches) const
+            {
+                if (m_slots.empty()) { return {}; }
+                for (std::size_t i{ home(tag) }; ; i = (i + 1) & m_mask) {
+                    const Slot& slot{ m_slots[i] };
+                    if (slot.row == Empty) { return {}; }
+                    if (slot.tag == tag && matches(slot.row)) { return slot.row; }
+                }
+            }
+
+        private:
+            static constexpr std::uint32_t Empty{ 0xffff'ffff };
+            struct Slot
+            {
+                std::uint32_t tag{ 0 };
+                std::uint32_t row{ Empty };
+            };
+
+            // Fibonacci hashing: the top bits of tag times 2^64 / phi
+            std::size_t home(std::uint32_t tag) const
+            {
+                return static_cast<std::size_t>((tag * 0x9e37'79b9'7f4a'7c15ull) >> m_shift);
+            }
+            void rehash(std::size_t slotCount);
+
+            std::vector<Slot> m_slots;
+            std::size_t m_mask{ 0 };
+            int m_shift{ 64 };
+            std::size_t m_size{ 0 };
+        };
+
+        // Where an employee's names are in m_names: the first name, then the last
+        struct NameRef
+        {
+            std::uint32_t offset;
+            std::uint16_t firstLength;
+            std::uint16_t lastLength;
+        };
+
+        static std::uint32_t hashName(std::string_view firstName, std::string_view lastName);
+
+        std::optional<std::uint32_t> findRow(int employeeNumber) const;
+        std::uint32_t rowOf(int employeeNumber) const;
+        std::string_view firstNameAt(std::uint32_t row) const;
+        std::string_view lastNameAt(std::uint32_t row) const;
+        Employee employeeAt(std::uint32_t row) const;
+        void append(int employeeNumber, std::string_view firstName, std::string_view lastName,
+            int salary, bool hired);
+        void rebuildIndexes();
+        void salariesChanged();
+        void display(bool current, bool former) const;
+
+        std::vector<int> m_employeeNumbers;
+        std::vector<int> m_salaries;
+        std::vector<std::uint8_t> m_hired;
+        std::vector<NameRef> m_nameRefs;
+        std::string m_names;
+
+        Index m_byNumber;
+        Index m_byName;
+        // Salary and row packed into one number, sorted; rebuilt lazily,
+        // see employeesWithSalary()
+        mutable std::vector<std::uint64_t> m_bySalary;
+        mutable bool m_salaryIndexValid{ false };
+        mutable bool m_scannedSinceChange{ false };
+
+        int m_nextEmployeeNumber{ FirstEmployeeNumber };
+    };
+
+    export struct PersistenceOptions
+    {
+        // Mutations per fsync of the log
+        std::size_t commitBatch{ 64 };
+        // Mutations between background snapshots; 0 for only on snapshot()
+        std::size_t snapshotEvery{ 1'000'000 };
+    };
+
+    // A Database whose changes survive a crash. The directory holds:
+    //   wal-N.log       log segments, records of the mutations in order
+    //   snapshot-N.db   Database::save() of everything in segments before N
+    // Opening it loads the newest snapshot and replays the segments after.
+    //
+    // A mutation is applied in memory and appended to a log buffer. Every
+    // commitBatch mutations the buffer goes to a background thread that
+    // writes it with one write() and one fdatasync() (group commit) while
+    // the next batch fills, so a mutation is durable once sync() returns
+    // or two batches later, whichever is first. A crash loses at most the
+    // unsynced tail.
+    //
+    // Every snapshotEvery mutations the log moves to a new segment, the
+    // Database is copied, and a background thread saves the copy and then
+    // deletes the segments and snapshot it replaces.
+    export class PersistentDatabase
+    {
+    public:
+        explicit PersistentDatabase(const std::filesystem::path& directory, PersistenceOptions options = {});
+        // Syncs the log and waits for a running snapshot
+        ~PersistentDatabase();
+        PersistentDatabase(const PersistentDatabase&) = delete;
+        PersistentDatabase& operator=(const PersistentDatabase&) = delete;
+
+        // For lookups and queries; change it only through the members below
+        const Database& database() const;
+
+        int addEmployee(std::string_view firstName, std::string_view lastName,
+            int salary = DefaultStartingSalary);
+        void setSalary(int employeeNumber, int newSalary);
+        void promote(int employeeNumber, int raiseAmount = DefaultRaiseAndDemeritAmount);
+        void demote(int employeeNumber, int demeritAmount = DefaultRaiseAndDemeritAmount);
+        void hire(int employeeNumber);
+        void fire(int employeeNumber);
+
+        // Returns once every mutation so far is on disk
+        void sync();
+        // Starts a snapshot now, after any running one has finished
+        void snapshot();
+        // Waits for a running snapshot; rethrows its error if it failed
+        void waitForSnapshot();
+
+        // What opening the directory found
+        std::size_t recoveredEmployees() const;
+        std::size_t replayedRecords() const;
+
+    private:
+        // An append-only file written in batches by its own thread: the
+        // caller fills one buffer while the thread writes and syncs the
+        // other, and only waits when it gets a whole batch ahead.
+        class WriteAheadLog
+        {
+        public:
+            WriteAheadLog(const std::filesystem::path& path, std::size_t commitBatch);
+            ~WriteAheadLog();
+            WriteAheadLog(const WriteAheadLog&) = delete;
+            WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+            void append(std::span<const char> record);
+            void sync();
+            // Syncs, then continues in a new file
+            void reopen(const std::filesystem::path& path);
+
+        private:
+            void handOff(std::unique_lock<std::mutex>& lock);
+            void writeLoop();
+
+            int m_fd{ -1 };
+            std::size_t m_commitBatch;
+            std::string m_filling; // Only touched by the caller
+            std::size_t m_fillingCount{ 0 };
+            std::string m_writing; // Non-empty while the writer owns it
+            std::uint64_t m_handedOff{ 0 };
+            std::uint64_t m_written{ 0 };
+            bool m_stopping{ false };
+            std::exception_ptr m_error;
+            std::mutex m_mutex;
+            std::condition_variable m_changed;
+            std::thread m_writer;
+        };
+
+        std::filesystem::path segmentPath(std::uint64_t segment) const;
+        std::filesystem::path snapshotPath(std::uint64_t segment) const;
+        void recover();
+        void replay(const std::filesystem::path& path, bool last);
+        void log(std::span<const char> record);
+        void writeSnapshot(const Database& copy, std::uint64_t segment) const;
+
+        std::filesystem::path m_directory;
+        PersistenceOptions m_options;
+        Database m_database;
+        std::uint64_t m_segment{ 0 };
+        std::size_t m_sinceSnapshot{ 0 };
+        std::size_t m_recoveredEmployees{ 0 };
+        std::size_t m_replayedRecords{ 0 };
+        std::future<void> m_snapshot;
+        std::unique_ptr<WriteAheadLog> m_log;
+    };
+}
@@ -0,0 +1,459 @@
+module;
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+module employee;
+import std;
+using namespace std;
+
+namespace Records {
+    // A log record: length (u32) and CRC-32 (u32) of what follows, then an
+    // operation byte and its fields, in the machine's byte order. Replay
+    // stops at the first record that is cut short or fails its CRC, which
+    // is where a crash in the middle of a write leaves the log.
+    enum class LogOp : uint8_t
+    {
+        Add = 1, // number i32, salary i32, first length u16, last length u16, names
+        SetSalary = 2, // number i32, salary i32
+        Raise = 3, // number i32, amount i32 (negative for a demotion)
+        SetHired = 4, // number i32, hired u8
+    };
+
+    constexpr size_t RecordHeaderBytes{ 2 * sizeof(uint32_t) };
+
+    namespace {
+        constexpr array<uint32_t, 256> CrcTable{ [] {
+            array<uint32_t, 256> table{};
+            for (uint32_t i{ 0 }; i < 256; ++i) {
+                uint32_t c{ i };
+                for (int bit{ 0 }; bit < 8; ++bit) { c = (c & 1) ? 0xedb8'8320u ^ (c >> 1) : c >> 1; }
+                table[i] = c;
+            }
+            return table;
+        }() };
+
+        uint32_t crc32(span<const char> bytes)
+        {
+            uint32_t crc{ 0xffff'ffffu };
+            for (char b : bytes) { crc = CrcTable[(crc ^ static_cast<uint8_t>(b)) & 0xff] ^ (crc >> 8); }
+            return ~crc;
+        }
+
+        // Builds one record, in a buffer reused by the thread's next record
+        class RecordWriter
+        {
+        public:
+            explicit RecordWriter(LogOp op) : m_bytes{ scratch() }
+            {
+                m_bytes.resize(RecordHeaderBytes);
+                put(op);
+            }
+
+            template <typename T>
+            RecordWriter& put(T value)
+            {
+                const auto bytes{ bit_cast<array<char, sizeof(T)>>(value) };
+                m_bytes.append(bytes.data(), bytes.size());
+                return *this;
+            }
+
+            RecordWriter& put(string_view text)
+            {
+                m_bytes.append(text);
+                return *this;
+            }
+
+            span<const char> finish()
+            {
+                const auto length{ static_cast<uint32_t>(m_bytes.size() - RecordHeaderBytes) };
+                const uint32_t crc{ crc32(span{ m_bytes }.subspan(RecordHeaderBytes)) };
+                memcpy(m_bytes.data(), &length, sizeof(length));
+                memcpy(m_bytes.data() + sizeof(length), &crc, sizeof(crc));
+                return m_bytes;
+            }
+
+        private:
+            static string& scratch()
+            {
+                thread_local string bytes;
+                return bytes;
+            }
+
+            string& m_bytes;
+        };
+
+        // Reads the fields of one record; ok() is false if it ran past the end
+        class RecordReader
+        {
+        public:
+            explicit RecordReader(span<const char> bytes) : m_bytes{ bytes } {}
+
+            template <typename T>
+            T get()
+            {
+                array<char, sizeof(T)> bytes{};
+                if (m_bytes.size() < sizeof(T)) {
+                    m_ok = false;
+                    return T{};
+                }
+                memcpy(bytes.data(), m_bytes.data(), sizeof(T));
+                m_bytes = m_bytes.subspan(sizeof(T));
+                return bit_cast<T>(bytes);
+            }
+
+            string_view text(size_t length)
+            {
+                if (m_bytes.size() < length) {
+                    m_ok = false;
+                    return {};
+                }
+                const string_view result{ m_bytes.data(), length };
+                m_bytes = m_bytes.subspan(length);
+                return result;
+            }
+
+            bool ok() const { return m_ok && m_bytes.empty(); }
+
+        private:
+            span<const char> m_bytes;
+            bool m_ok{ true };
+        };
+
+        void syncFile(const filesystem::path& path)
+        {
+            const int fd{ ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+            const bool synced{ fd >= 0 && ::fsync(fd) == 0 };
+            if (fd >= 0) { ::close(fd); }
+            if (!synced) { throw system_error{ errno, generic_category(), path.string() }; }
+        }
+
+        // Parses "<prefix><number><suffix>"
+        optional<uint64_t> numberIn(string_view name, string_view prefix, string_view suffix)
+        {
+            if (!name.starts_with(prefix) || !name.ends_with(suffix)) { return {}; }
+            name = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+            uint64_t number{ 0 };
+            const auto [end, error] { from_chars(name.data(), name.data() + name.size(), number) };
+            if (name.empty() || error != errc{} || end != name.data() + name.size()) { return {}; }
+            return number;
+        }
+    }
+
+    PersistentDatabase::WriteAheadLog::WriteAheadLog(const filesystem::path& path, size_t commitBatch)
+        : m_commitBatch{ max<size_t>(commitBatch, 1) }
+    {
+        reopen(path);
+        m_writer = thread{ [this] { writeLoop(); } };
+    }
+
+    PersistentDatabase::WriteAheadLog::~WriteAheadLog()
+    {
+        try {
+            sync();
+        } catch (const exception& e) {
+            println(cerr, "write-ahead log: {}", e.what());
+        }
+        {
+            lock_guard lock{ m_mutex };
+            m_stopping = true;
+        }
+        m_changed.notify_all();
+        m_writer.join();
+        ::close(m_fd);
+    }
+
+    void PersistentDatabase::WriteAheadLog::append(span<const char> record)
+    {
+        m_filling.append(record.data(), record.size());
+        if (++m_fillingCount >= m_commitBatch) {
+            unique_lock lock{ m_mutex };
+            handOff(lock);
+        }
+    }
+
+    void PersistentDatabase::WriteAheadLog::handOff(unique_lock<mutex>& lock)
+    {
+        // Wait for the writer to finish the previous batch
+        m_changed.wait(lock, [this] { return m_writing.empty() || m_error; });
+        if (m_error) { rethrow_exception(m_error); }
+        swap(m_filling, m_writing);
+        m_filling.clear();
+        m_fillingCount = 0;
+        ++m_handedOff;
+        m_changed.notify_all();
+    }
+
+    void PersistentDatabase::WriteAheadLog::sync()
+    {
+        unique_lock lock{ m_mutex };
+        if (!m_filling.empty()) { handOff(lock); }
+        m_changed.wait(lock, [this] { return m_written == m_handedOff || m_error; });
+        if (m_error) { rethrow_exception(m_error); }
+    }
+
+    void PersistentDatabase::WriteAheadLog::reopen(const filesystem::path& path)
+    {
+        const int fd{ ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644) };
+        if (fd < 0) { throw system_error{ errno, generic_category(), path.string() }; }
+        if (m_writer.joinable()) { sync(); }
+        lock_guard lock{ m_mutex };
+        if (m_fd >= 0) { ::close(m_fd); }
+        m_fd = fd;
+    }
+
+    void PersistentDatabase::WriteAheadLog::writeLoop()
+    {
+        unique_lock lock{ m_mutex };
+        for (;;) {
+            m_changed.wait(lock, [this] { return !m_writing.empty() || m_stopping; });
+            if (m_writing.empty()) { return; }
+            const int fd{ m_fd };
+            // The caller leaves m_writing alone until it is empty again
+            lock.unlock();
+            exception_ptr error;
+            const char* data{ m_writing.data() };
+            size_t left{ m_writing.size() };
+            while (left > 0) {
+                const ssize_t n{ ::write(fd, data, left) };
+                if (n < 0 && errno == EINTR) { continue; }
+                if (n < 0) { break; }
+                data += n;
+                left -= static_cast<size_t>(n);
+            }
+            if (left > 0 || ::fdatasync(fd) != 0) {
+                error = make_exception_ptr(system_error{ errno, generic_category(), "write-ahead log" });
+            }
+            lock.lock();
+            if (error) {
+                m_error = error;
+                m_changed.notify_all();
+                return;
+            }
+            m_writing.clear();
+            ++m_written;
+            m_changed.notify_all();
+        }
+    }
+
+    PersistentDatabase::PersistentDatabase(const filesystem::path& directory, PersistenceOptions options)
+        : m_directory{ directory }, m_options{ options }
+    {
+        filesystem::create_directories(m_directory);
+        recover();
+        m_log = make_unique<WriteAheadLog>(segmentPath(m_segment), m_options.commitBatch);
+    }
+
+    PersistentDatabase::~PersistentDatabase()
+    {
+        try {
+            waitForSnapshot();
+        } catch (const exception& e) {
+            println(cerr, "snapshot: {}", e.what());
+        }
+    }
+
+    filesystem::path PersistentDatabase::segmentPath(uint64_t segment) const
+    {
+        return m_directory / format("wal-{:012}.log", segment);
+    }
+
+    filesystem::path PersistentDatabase::snapshotPath(uint64_t segment) const
+    {
+        return m_directory / format("snapshot-{:012}.db", segment);
+    }
+
+    void PersistentDatabase::recover()
+    {
+        optional<uint64_t> latestSnapshot;
+        vector<uint64_t> segments;
+        for (const auto& entry : filesystem::directory_iterator{ m_directory }) {
+            const string name{ entry.path().filename().string() };
+            if (name.ends_with(".tmp")) {
+                // A snapshot that was being written
+                filesystem::remove(entry.path());
+            } else if (const auto segment{ numberIn(name, "snapshot-", ".db") }) {
+                latestSnapshot = max(latestSnapshot.value_or(0), *segment);
+            } else if (const auto segment{ numberIn(name, "wal-", ".log") }) {
+                segments.push_back(*segment);
+            }
+        }
+        ranges::sort(segments);
+
+        // The snapshot holds everything before its segment; older files
+        // are left over from a crash before they could be deleted
+        const uint64_t first{ latestSnapshot.value_or(0) };
+        if (latestSnapshot) {
+            m_database.load(snapshotPath(first));
+            m_recoveredEmployees = m_database.size();
+        }
+        for (uint64_t segment : segments) {
+            if (segment < first) {
+                filesystem::remove(segmentPath(segment));
+            } else {
+                replay(segmentPath(segment), segment == segments.back());
+            }
+        }
+        // Carry on appending to the newest segment, whose tail replay()
+        // has cut back to the last whole record
+        m_segment = segments.empty() ? first : max(first, segments.back());
+    }
+
+    void PersistentDatabase::replay(const filesystem::path& path, bool last)
+    {
+        const MappedFile file{ path };
+        span<const char> log{ file.bytes() };
+        size_t valid{ 0 };
+        while (log.size() >= RecordHeaderBytes) {
+            uint32_t length{ 0 };
+            uint32_t crc{ 0 };
+            memcpy(&length, log.data(), sizeof(length));
+            memcpy(&crc, log.data() + sizeof(length), sizeof(crc));
+            if (length > log.size() - RecordHeaderBytes) { break; }
+            const span<const char> body{ log.subspan(RecordHeaderBytes, length) };
+            if (crc32(body) != crc) { break; }
+
+            RecordReader in{ body };
+            const auto op{ in.get<LogOp>() };
+            const auto employeeNumber{ in.get<int32_t>() };
+            try {
+                switch (op) {
+                case LogOp::Add: {
+                    const auto salary{ in.get<int32_t>() };
+                    const auto firstLength{ in.get<uint16_t>() };
+                    const auto lastLength{ in.get<uint16_t>() };
+                    const string_view firstName{ in.text(firstLength) };
+                    const string_view lastName{ in.text(lastLength) };
+                    if (in.ok()) {
+                        Employee employee{ string{ firstName }, string{ lastName } };
+                        employee.setEmployeeNumber(employeeNumber);
+                        employee.setSalary(salary);
+                        employee.hire();
+                        m_database.addEmployee(employee);
+                    }
+                    break;
+                }
+                case LogOp::SetSalary: {
+                    const auto salary{ in.get<int32_t>() };
+                    if (in.ok()) { m_database.setSalary(employeeNumber, salary); }
+                    break;
+                }
+                case LogOp::Raise: {
+                    const auto amount{ in.get<int32_t>() };
+                    if (in.ok()) { m_database.promote(employeeNumber, amount); }
+                    break;
+                }
+                case LogOp::SetHired: {
+                    const auto hired{ in.get<uint8_t>() };
+                    if (in.ok()) { hired ? m_database.hire(employeeNumber) : m_database.fire(employeeNumber); }
+                    break;
+                }
+                default:
+                    break;
+                }
+            } catch (const exception& e) {
+                throw runtime_error{ format("{}: record at {} can't be applied: {}", path.string(), valid, e.what()) };
+            }
+            if (!in.ok()) { throw runtime_error{ format("{}: bad record at {}.", path.string(), valid) }; }
+
+            ++m_replayedRecords;
+            valid += RecordHeaderBytes + length;
+            log = log.subspan(RecordHeaderBytes + length);
+        }
+        if (log.empty()) { return; }
+        // A torn write can only be at the end of the newest segment; cut
+        // it off so it isn't in the middle of the log next time
+        if (!last) { throw runtime_error{ format("{}: corrupt record at {}.", path.string(), valid) }; }
+        filesystem::resize_file(path, valid);
+    }
+
+    const Database& PersistentDatabase::database() const { return m_database; }
+
+    void PersistentDatabase::log(span<const char> record)
+    {
+        m_log->append(record);
+        if (m_options.snapshotEvery > 0 && ++m_sinceSnapshot >= m_options.snapshotEvery) {
+            // Don't queue up behind a snapshot that is still being written
+            if (!m_snapshot.valid() || m_snapshot.wait_for(0s) == future_status::ready) { snapshot(); }
+        }
+    }
+
+    int PersistentDatabase::addEmployee(string_view firstName, string_view lastName, int salary)
+    {
+        const int employeeNumber{ m_database.addEmployee(firstName, lastName, salary) };
+        log(RecordWriter{ LogOp::Add }.put<int32_t>(employeeNumber).put<int32_t>(salary)
+            .put(static_cast<uint16_t>(firstName.size())).put(static_cast<uint16_t>(lastName.size()))
+            .put(firstName).put(lastName).finish());
+        return employeeNumber;
+    }
+
+    void PersistentDatabase::setSalary(int employeeNumber, int newSalary)
+    {
+        m_database.setSalary(employeeNumber, newSalary);
+        log(RecordWriter{ LogOp::SetSalary }.put<int32_t>(employeeNumber).put<int32_t>(newSalary).finish());
+    }
+
+    void PersistentDatabase::promote(int employeeNumber, int raiseAmount)
+    {
+        m_database.promote(employeeNumber, raiseAmount);
+        log(RecordWriter{ LogOp::Raise }.put<int32_t>(employeeNumber).put<int32_t>(raiseAmount).finish());
+    }
+
+    void PersistentDatabase::demote(int employeeNumber, int demeritAmount)
+    {
+        m_database.demote(employeeNumber, demeritAmount);
+        log(RecordWriter{ LogOp::Raise }.put<int32_t>(employeeNumber).put<int32_t>(-demeritAmount).finish());
+    }
+
+    void PersistentDatabase::hire(int employeeNumber)
+    {
+        m_database.hire(employeeNumber);
+        log(RecordWriter{ LogOp::SetHired }.put<int32_t>(employeeNumber).put<uint8_t>(1).finish());
+    }
+
+    void PersistentDatabase::fire(int employeeNumber)
+    {
+        m_database.fire(employeeNumber);
+        log(RecordWriter{ LogOp::SetHired }.put<int32_t>(employeeNumber).put<uint8_t>(0).finish());
+    }
+
+    void PersistentDatabase::sync() { m_log->sync(); }
+
+    void PersistentDatabase::snapshot()
+    {
+        waitForSnapshot();
+        // Everything so far is in segments before the new one, and in the copy
+        m_log->reopen(segmentPath(++m_segment));
+        m_sinceSnapshot = 0;
+        m_snapshot = async(launch::async, [this, copy = m_database, segment = m_segment] {
+            writeSnapshot(copy, segment);
+        });
+    }
+
+    void PersistentDatabase::waitForSnapshot()
+    {
+        if (m_snapshot.valid()) { m_snapshot.get(); }
+    }
+
+    void PersistentDatabase::writeSnapshot(const Database& copy, uint64_t segment) const
+    {
+        // Written under a temporary name and renamed once it is complete
+        // and on disk, so a crash leaves either the old snapshot or the new
+        const filesystem::path path{ snapshotPath(segment) };
+        filesystem::path temporary{ path };
+        temporary += ".tmp";
+        copy.save(temporary);
+        syncFile(temporary);
+        filesystem::rename(temporary, path);
+        syncFile(m_directory);
+
+        for (const auto& entry : filesystem::directory_iterator{ m_directory }) {
+            const string name{ entry.path().filename().string() };
+            const auto older{ numberIn(name, "snapshot-", ".db") };
+            const auto covered{ numberIn(name, "wal-", ".log") };
+            if ((older && *older < segment) || (covered && *covered < segment)) { filesystem::remove(entry.path()); }
+        }
+    }
+
+    size_t PersistentDatabase::recoveredEmployees() const { return m_recoveredEmployees; }
+    size_t PersistentDatabase::replayedRecords() const { return m_replayedRecords; }
+}
@@ -0,0 +1,106 @@
+// Mutations per second through PersistentDatabase at several commit batch
+// sizes (mutations per fsync), against the in-memory Database; then the
+// time to reopen it from a snapshot plus a log tail, and from a log with a
+// torn write at its end.
+//   PersistenceBench [directory, default employee_bench_data] [employees, default 100000]
+
+import std;
+import employee;
+
+using namespace std;
+using namespace Records;
+
+namespace {
+    using Clock = chrono::steady_clock;
+
+    double secondsFor(const function<void()>& f)
+    {
+        const auto start{ Clock::now() };
+        f();
+        return chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void addEmployees(auto& db, size_t count)
+    {
+        for (size_t i{ 0 }; i < count; ++i) { db.addEmployee("Jane", format("Doe{}", i)); }
+    }
+
+    // Raises, salary changes and firings on random employees
+    void mutate(auto& db, size_t count, size_t employees, mt19937& rng)
+    {
+        for (size_t i{ 0 }; i < count; ++i) {
+            const int employeeNumber{ FirstEmployeeNumber + static_cast<int>(rng() % employees) };
+            switch (i % 4) {
+            case 0: db.promote(employeeNumber, 100); break;
+            case 1: db.demote(employeeNumber, 50); break;
+            case 2: db.setSalary(employeeNumber, 40'000 + static_cast<int>(rng() % 1'000)); break;
+            default: (i % 8 == 3) ? db.fire(employeeNumber) : db.hire(employeeNumber); break;
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const filesystem::path directory{ argc > 1 ? argv[1] : "employee_bench_data" };
+    const size_t employees{ argc > 2 ? static_cast<size_t>(atol(argv[2])) : 100'000 };
+    constexpr size_t MaxMutations{ 400'000 };
+    mt19937 rng{ 42 };
+
+    println("{:<28} {:>10} {:>8} {:>14}", "", "mutations", "fsyncs", "mutations/s");
+    {
+        Database db;
+        addEmployees(db, employees);
+        const double seconds{ secondsFor([&] { mutate(db, MaxMutations, employees, rng); }) };
+        println("{:<28} {:>10} {:>8} {:>14.0f}", "in memory", MaxMutations, 0, MaxMutations / seconds);
+    }
+    for (size_t batch : { 1, 8, 64, 512, 4096 }) {
+        filesystem::remove_all(directory);
+        PersistentDatabase db{ directory, { .commitBatch = batch, .snapshotEvery = 0 } };
+        addEmployees(db, employees);
+        db.sync();
+        // Enough mutations for about 1000 fsyncs, up to MaxMutations
+        const size_t count{ min(MaxMutations, batch * 1'000) };
+        const double seconds{ secondsFor([&] {
+            mutate(db, count, employees, rng);
+            db.sync();
+        }) };
+        println("{:<28} {:>10} {:>8} {:>14.0f}", format("commit batch {}", batch), count,
+            (count + batch - 1) / batch, count / seconds);
+    }
+
+    // A snapshot of the employees, then a log tail after it
+    int64_t payroll{ 0 };
+    {
+        filesystem::remove_all(directory);
+        PersistentDatabase db{ directory, { .commitBatch = 512, .snapshotEvery = 0 } };
+        addEmployees(db, employees);
+        const double seconds{ secondsFor([&] {
+            db.snapshot();
+            db.waitForSnapshot();
+        }) };
+        println("\nsnapshot of {} employees: {:.1f} ms", employees, seconds * 1e3);
+        mutate(db, MaxMutations, employees, rng);
+        payroll = db.database().payroll();
+    }
+    const auto reopen{ [&](string_view what) {
+        unique_ptr<PersistentDatabase> db;
+        const double seconds{ secondsFor([&] { db = make_unique<PersistentDatabase>(directory); }) };
+        println("recovery{}: {} employees from the snapshot, {} log records replayed, {:.1f} ms, payroll {}",
+            what, db->recoveredEmployees(), db->replayedRecords(), seconds * 1e3,
+            db->database().payroll() == payroll ? "matches" : "DIFFERS");
+        return db->database().payroll() == payroll;
+    } };
+    bool ok{ reopen("") };
+
+    // What a crash in the middle of a write leaves: part of a record
+    filesystem::path newest;
+    for (const auto& entry : filesystem::directory_iterator{ directory }) {
+        if (entry.path().extension() == ".log" && entry.path() > newest) { newest = entry.path(); }
+    }
+    ofstream{ newest, ios::binary | ios::app }.write("\x20\0\0\0\x12\x34", 6);
+    ok = reopen(" after a torn write") && ok;
+
+    filesystem::remove_all(directory);
+    return ok ? 0 : 1;
+}
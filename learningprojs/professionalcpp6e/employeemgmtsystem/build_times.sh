@@ -0,0 +1,49 @@
+#!/bin/sh
+# Build times of the module targets against the header variant (see
+# CMakeLists.txt): a clean build, and rebuilds after touching sources.
+#   ./build_times.sh [build directory, default build_times] [cmake arguments...]
+# for example
+#   ./build_times.sh build_times -DCMAKE_CXX_COMPILER=clang++ -DCMAKE_CXX_FLAGS=-stdlib=libc++
+# The generator is Ninja unless CMAKE_GENERATOR says otherwise.
+set -e
+
+source_dir=$(cd "$(dirname "$0")" && pwd)
+# absolute: the rows below build from inside the source directory
+build_dir=$(realpath -m "${1:-build_times}")
+[ $# -gt 0 ] && shift
+export CMAKE_GENERATOR=${CMAKE_GENERATOR:-Ninja}
+
+seconds() {
+    start=$(date +%s.%N)
+    cmake --build "$build_dir" --target "$1" > /dev/null
+    end=$(date +%s.%N)
+    echo "$start $end" | awk '{ printf "%8.2f", $2 - $1 }'
+}
+
+# Touches the given sources, then builds each variant
+row() {
+    label=$1
+    shift
+    touch "$@"
+    printf '%-40s' "$label"
+    seconds modules
+    touch "$@"
+    seconds headers
+    echo
+}
+
+cmake -E rm -rf "$build_dir"
+cmake -S "$source_dir" -B "$build_dir" -DCMAKE_BUILD_TYPE=Release "$@" > /dev/null
+
+printf '%-40s%8s%8s\n' "" modules headers
+# The modules clean build includes building the std module once
+printf '%-40s' "clean build"
+seconds modules
+seconds headers
+echo
+cd "$source_dir"
+row "every source touched" Employee.cppm Employee.cpp Database.cpp Persistence.cpp \
+    EmployeeTest.cpp DatabaseTest.cpp DatabaseBench.cpp PersistenceBench.cpp
+row "Database.cpp touched" Database.cpp
+row "Employee.cppm touched (the interface)" Employee.cppm
+row "DatabaseBench.cpp touched" DatabaseBench.cpp
@@ -0,0 +1,22 @@
+# Writes OUT: the module source IN rewritten as an ordinary header or
+# source file, for the header variant of the build.
+#   export module employee;   ->  #pragma once
+#   module employee;          ->  #include "Employee.h" (a "module;" before it goes)
+#   import employee;          ->  #include "Employee.h"
+#   import std;               ->  #include "std.h"
+#   export <declaration>      ->  <declaration>
+#
+#   cmake -DIN=Database.cpp -DOUT=headers/Database.cpp -P cmake/HeaderVariant.cmake
+
+file(READ "${IN}" text)
+# A leading newline so every line, the first included, starts with one
+set(text "\n${text}")
+string(REPLACE "\nexport module employee;" "\n#pragma once" text "${text}")
+# Blanked rather than removed, to keep the #line numbering right
+string(REPLACE "\nmodule;\n" "\n\n" text "${text}")
+string(REPLACE "\nmodule employee;" "\n#include \"Employee.h\"" text "${text}")
+string(REPLACE "\nimport employee;" "\n#include \"Employee.h\"" text "${text}")
+string(REPLACE "\nimport std;" "\n#include \"std.h\"" text "${text}")
+string(REGEX REPLACE "\n([ \t]*)export " "\n\\1" text "${text}")
+# Diagnostics point at the module source, not the copy
+file(WRITE "${OUT}" "#line 1 \"${IN}\"${text}")
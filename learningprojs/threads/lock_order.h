@@ -0,0 +1,206 @@
+#pragma once
+
+// Lock-order validation for debug builds.
+//
+// OrderedMutex is a std::mutex that, when NDEBUG is not defined, records every
+// "held A while taking B" edge in a global graph. Adding an edge that closes a
+// cycle means two code paths take the same locks in opposite orders, which is
+// a deadlock waiting for the right interleaving (see deadlock.cpp). The report
+// names both locks and prints the stack of the new acquisition and of the
+// acquisition that recorded the opposite edge.
+//
+// With NDEBUG defined OrderedMutex is exactly a std::mutex.
+//
+// ScopedMultiLock locks any number of mutexes in one global order (by address)
+// so callers that need several locks never have to think about ordering.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+#ifndef NDEBUG
+#include <cstdio>
+#include <execinfo.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#endif
+
+#ifdef NDEBUG
+
+class OrderedMutex : public std::mutex {
+public:
+    explicit OrderedMutex(const char* = nullptr) {}
+};
+
+#else
+
+namespace lockorder {
+
+struct Stack {
+    void* frames[32];
+    int depth = 0;
+
+    void capture() { depth = backtrace(frames, 32); }
+
+    void print() const { backtrace_symbols_fd(frames, depth, STDERR_FILENO); }
+};
+
+struct Node {
+    const char* name;
+    // edges to locks that were taken while this one was held
+    std::unordered_map<const void*, Stack> after;
+};
+
+class Graph {
+public:
+    static Graph& instance() {
+        static Graph g;
+        return g;
+    }
+
+    void add(const void* lock, const char* name) {
+        std::lock_guard<std::mutex> guard(m);
+        nodes[lock].name = name;
+    }
+
+    void remove(const void* lock) {
+        std::lock_guard<std::mutex> guard(m);
+        nodes.erase(lock);
+        for (auto& entry : nodes) entry.second.after.erase(lock);
+    }
+
+    // called before `next` is acquired while the thread holds `held`
+    void acquire(const std::vector<const void*>& held, const void* next) {
+        std::lock_guard<std::mutex> guard(m);
+        for (const void* h : held) {
+            if (h == next) {
+                std::fprintf(stderr, "lock-order: recursive acquisition of \"%s\"\n", nodes[next].name);
+                Stack here;
+                here.capture();
+                here.print();
+                continue;
+            }
+            auto& edges = nodes[h].after;
+            if (edges.count(next)) continue; // known edge, nothing new to check
+
+            Stack here;
+            here.capture();
+            std::vector<const void*> path;
+            std::unordered_set<const void*> seen;
+            if (findPath(next, h, path, seen)) report(h, next, path, here);
+            edges.emplace(next, here);
+        }
+    }
+
+    std::size_t violations() const { return violationCount; }
+
+private:
+    bool findPath(const void* from, const void* to, std::vector<const void*>& path,
+                  std::unordered_set<const void*>& seen) {
+        if (!seen.insert(from).second) return false;
+        path.push_back(from);
+        if (from == to) return true;
+        for (auto& edge : nodes[from].after) {
+            if (findPath(edge.first, to, path, seen)) return true;
+        }
+        path.pop_back();
+        return false;
+    }
+
+    void report(const void* held, const void* next, const std::vector<const void*>& path, const Stack& here) {
+        ++violationCount;
+        std::fprintf(stderr, "lock-order violation: acquiring \"%s\" while holding \"%s\"\n",
+                     nodes[next].name, nodes[held].name);
+        std::fprintf(stderr, "existing order:");
+        for (const void* p : path) std::fprintf(stderr, " \"%s\"", nodes[p].name);
+        std::fprintf(stderr, "\nthis acquisition:\n");
+        here.print();
+        // the first hop of the existing path is the opposite edge
+        if (path.size() >= 2) {
+            std::fprintf(stderr, "first seen \"%s\" -> \"%s\" at:\n", nodes[path[0]].name, nodes[path[1]].name);
+            nodes[path[0]].after[path[1]].print();
+        }
+    }
+
+    std::mutex m;
+    std::unordered_map<const void*, Node> nodes;
+    std::size_t violationCount = 0;
+};
+
+inline std::vector<const void*>& heldLocks() {
+    thread_local std::vector<const void*> held;
+    return held;
+}
+
+} // namespace lockorder
+
+class OrderedMutex {
+public:
+    explicit OrderedMutex(const char* name = "unnamed") { lockorder::Graph::instance().add(this, name); }
+    ~OrderedMutex() { lockorder::Graph::instance().remove(this); }
+
+    OrderedMutex(const OrderedMutex&) = delete;
+    OrderedMutex& operator=(const OrderedMutex&) = delete;
+
+    void lock() {
+        auto& held = lockorder::heldLocks();
+        if (!held.empty()) lockorder::Graph::instance().acquire(held, this);
+        m.lock();
+        held.push_back(this);
+    }
+
+    bool try_lock() {
+        // a failed try_lock cannot deadlock, so only successful ones are recorded
+        if (!m.try_lock()) return false;
+        lockorder::heldLocks().push_back(this);
+        return true;
+    }
+
+    void unlock() {
+        auto& held = lockorder::heldLocks();
+        auto it = std::find(held.rbegin(), held.rend(), this);
+        if (it != held.rend()) held.erase(std::next(it).base());
+        m.unlock();
+    }
+
+private:
+    std::mutex m;
+};
+
+#endif
+
+// Unlike std::scoped_lock, which locks one mutex and try_locks the rest
+// (backing off and retrying under contention), this never retries: every
+// caller walks the same address order, so no cycle can form.
+template <typename Mutex, std::size_t N>
+class ScopedMultiLock {
+public:
+    template <typename... Ms>
+    explicit ScopedMultiLock(Ms&... ms) : locks{&ms...} {
+        static_assert(sizeof...(Ms) == N, "one mutex per slot");
+        std::sort(locks.begin(), locks.end(), std::less<Mutex*>());
+        for (std::size_t i = 0; i < N; ++i) {
+            if (i == 0 || locks[i] != locks[i - 1]) locks[i]->lock();
+        }
+    }
+
+    ~ScopedMultiLock() {
+        for (std::size_t i = N; i-- > 0;) {
+            if (i == 0 || locks[i] != locks[i - 1]) locks[i]->unlock();
+        }
+    }
+
+    ScopedMultiLock(const ScopedMultiLock&) = delete;
+    ScopedMultiLock& operator=(const ScopedMultiLock&) = delete;
+
+private:
+    std::array<Mutex*, N> locks;
+};
+
+template <typename Mutex, typename... Rest>
+ScopedMultiLock(Mutex&, Rest&...) -> ScopedMultiLock<Mutex, 1 + sizeof...(Rest)>;
@@ -0,0 +1,49 @@
+
+// deadlock.cpp takes mutex1/mutex2 in opposite orders from two threads.
+// Here the threads run one after the other so the program never hangs, but a
+// debug build still reports the inverted order the first time it is seen.
+// The second half does the same work through ScopedMultiLock, which always
+// locks in address order and so reports nothing.
+#include <iostream>
+#include <thread>
+
+#include "lock_order.h"
+
+OrderedMutex mutex1("mutex1"), mutex2("mutex2");
+
+int main() {
+    std::thread t1([]() {
+        mutex1.lock();
+        mutex2.lock();
+        std::cout << "t1" << std::endl;
+        mutex2.unlock();
+        mutex1.unlock();
+    });
+    t1.join();
+
+    std::thread t2([]() {
+        mutex2.lock();
+        mutex1.lock(); // reported: opposite of t1
+        std::cout << "t2" << std::endl;
+        mutex1.unlock();
+        mutex2.unlock();
+    });
+    t2.join();
+
+    OrderedMutex a("a"), b("b");
+    std::thread t3([&]() {
+        ScopedMultiLock lock(a, b);
+        std::cout << "t3" << std::endl;
+    });
+    std::thread t4([&]() {
+        ScopedMultiLock lock(b, a);
+        std::cout << "t4" << std::endl;
+    });
+    t3.join();
+    t4.join();
+
+#ifndef NDEBUG
+    std::cout << "violations: " << lockorder::Graph::instance().violations() << std::endl;
+#endif
+    return 0;
+}
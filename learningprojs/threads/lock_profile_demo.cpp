@@ -0,0 +1,79 @@
+
+// the locks from mutex/recursive_mutex/spinlock examples, wrapped in
+// ProfiledLock. Prints the uncontended overhead against the raw locks, then
+// the contention report.
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "profiled_lock.h"
+#include "spinlock.h"
+
+ProfiledLock<std::mutex> counterMutex("counterMutex");
+ProfiledLock<std::recursive_mutex> recMutex("recMutex");
+ProfiledLock<Spinlock> spin("spinlock");
+
+// one counter per lock, each only touched under it
+long counter = 0;     // counterMutex
+long recCounter = 0;  // recMutex
+long spinCounter = 0; // spin
+
+void f1() {
+    std::lock_guard<ProfiledLock<std::recursive_mutex>> lock(recMutex);
+    ++recCounter;
+}
+
+void f2() {
+    std::lock_guard<ProfiledLock<std::recursive_mutex>> lock(recMutex);
+    f1();
+}
+
+template <typename Lock>
+double nsPerLockUnlock(Lock& lock, int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        lock.lock();
+        ++counter;
+        lock.unlock();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main() {
+    const int iterations = 5'000'000;
+    std::mutex raw;
+    ProfiledLock<std::mutex> wrapped("uncontended");
+    Spinlock rawSpin;
+    ProfiledLock<Spinlock> wrappedSpin("uncontended spin");
+    std::cout << "uncontended std::mutex: " << nsPerLockUnlock(raw, iterations) << " ns, profiled: "
+              << nsPerLockUnlock(wrapped, iterations) << " ns\n";
+    std::cout << "uncontended Spinlock:   " << nsPerLockUnlock(rawSpin, iterations) << " ns, profiled: "
+              << nsPerLockUnlock(wrappedSpin, iterations) << " ns\n";
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 20000; ++i) {
+                {
+                    std::lock_guard<ProfiledLock<std::mutex>> lock(counterMutex);
+                    ++counter;
+                }
+                if (i % 4 == 0) {
+                    PROFILED_LOCK_GUARD(slow, counterMutex); // reported as its own site
+                    std::this_thread::sleep_for(std::chrono::microseconds(5));
+                }
+                f2();
+                std::lock_guard<ProfiledLock<Spinlock>> lock(spin);
+                ++spinCounter;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    dumpLockReport(stdout);
+    lockprof::Registry::instance().reportAtExit(false);
+    return 0;
+}
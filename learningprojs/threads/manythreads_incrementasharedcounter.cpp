@@ -1,4 +1,5 @@
 
+#include <atomic>
 #include <iostream>
 #include <thread>
 
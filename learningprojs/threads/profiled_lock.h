@@ -0,0 +1,268 @@
+#pragma once
+
+// Instrumented drop-in wrappers for std::mutex, std::recursive_mutex and
+// Spinlock that record, per call site:
+//   - acquisitions and how many of them had to wait
+//   - wait time of contended acquisitions (every one)
+//   - hold time (1 in kHoldSampleEvery acquisitions at each site)
+// into log-linear ("HDR-style") histograms, and print a report at exit or on
+// dumpLockReport().
+//
+// The uncontended path is a try_lock and one increment of the site's
+// acquisition count, made while holding the lock so it is a relaxed load and
+// store rather than an atomic read-modify-write (exact for the lock's own
+// site; a PROFILED_LOCK_GUARD line used with several locks at once can lose
+// counts). Every kHoldSampleEvery-th count of a site also takes a hold-time
+// sample; clocks are read only then and when a thread has to wait. Nesting
+// depth is tracked for recursive mutexes only.
+//
+// Measured with lock_profile_demo at -O2 (GCC 12, glibc 2.36), per
+// uncontended lock/unlock pair: Spinlock ~12 ns either way (within noise);
+// std::mutex ~10 -> ~19 ns. About 7 ns of that is try_lock itself:
+// pthread_mutex_trylock costs ~17.5 ns against ~10.5 ns for
+// pthread_mutex_lock, and std::mutex has no cheaper way to find out whether
+// lock() would block, which is what tells a contended acquisition apart.
+//
+//   ProfiledLock<std::mutex> m("queue");      // site = declaration
+//   std::lock_guard<ProfiledLock<std::mutex>> g(m);
+//   PROFILED_LOCK_GUARD(g2, m);               // site = this line
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace lockprof {
+
+// 64 power-of-two ranges, each split into 8 linear sub-buckets: <= 12.5%
+// relative error, fixed 4 KiB per histogram, lock-free recording.
+class Histogram {
+public:
+    static constexpr int kSubBits = 3;
+    static constexpr int kSub = 1 << kSubBits;
+    static constexpr int kBuckets = 64 * kSub;
+
+    void record(std::uint64_t v) {
+        counts[index(v)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(v, std::memory_order_relaxed);
+        std::uint64_t m = maxValue.load(std::memory_order_relaxed);
+        while (v > m && !maxValue.compare_exchange_weak(m, v, std::memory_order_relaxed)) {}
+    }
+
+    std::uint64_t count() const {
+        std::uint64_t n = 0;
+        for (auto& c : counts) n += c.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    std::uint64_t sum() const { return total.load(std::memory_order_relaxed); }
+    std::uint64_t max() const { return maxValue.load(std::memory_order_relaxed); }
+
+    // upper bound of the bucket holding the q-th quantile
+    std::uint64_t percentile(double q) const {
+        const std::uint64_t n = count();
+        if (n == 0) return 0;
+        const std::uint64_t rank = static_cast<std::uint64_t>(q * (n - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank) return std::min(upperBound(i), max());
+        }
+        return max();
+    }
+
+private:
+    static int index(std::uint64_t v) {
+        if (v < kSub) return static_cast<int>(v);
+        const int exp = 63 - __builtin_clzll(v); // >= kSubBits
+        const int sub = static_cast<int>((v >> (exp - kSubBits)) & (kSub - 1));
+        return (exp - kSubBits + 1) * kSub + sub;
+    }
+
+    static std::uint64_t upperBound(int i) {
+        if (i < kSub) return i;
+        const int exp = i / kSub + kSubBits - 1;
+        const std::uint64_t sub = i % kSub;
+        return ((kSub + sub + 1) << (exp - kSubBits)) - 1;
+    }
+
+    std::atomic<std::uint64_t> counts[kBuckets] = {};
+    std::atomic<std::uint64_t> total{0};
+    std::atomic<std::uint64_t> maxValue{0};
+};
+
+struct Site {
+    std::string name;
+    std::string location;
+    std::atomic<std::uint64_t> acquisitions{0};
+    std::atomic<std::uint64_t> contended{0};
+    Histogram waitNs;
+    Histogram holdNs;
+};
+
+class Registry {
+public:
+    static Registry& instance() {
+        static Registry r;
+        return r;
+    }
+
+    Site& site(const std::string& name, const std::source_location& loc) {
+        auto s = std::make_unique<Site>();
+        s->name = name;
+        s->location = std::string(loc.file_name()) + ":" + std::to_string(loc.line());
+        std::lock_guard<std::mutex> guard(m);
+        sites.push_back(std::move(s));
+        return *sites.back();
+    }
+
+    // sites with the most total wait first
+    void report(std::FILE* out) {
+        std::lock_guard<std::mutex> guard(m);
+        std::vector<Site*> sorted;
+        for (auto& s : sites) {
+            if (s->acquisitions.load(std::memory_order_relaxed)) sorted.push_back(s.get());
+        }
+        std::sort(sorted.begin(), sorted.end(),
+                  [](Site* a, Site* b) { return a->waitNs.sum() > b->waitNs.sum(); });
+
+        std::fprintf(out, "%-20s %-32s %10s %7s %10s %10s %10s %10s %10s\n", "lock", "site", "acquires",
+                     "cont%", "wait_tot", "wait_p50", "wait_p99", "hold_p50", "hold_p99");
+        for (Site* s : sorted) {
+            const double acq = static_cast<double>(s->acquisitions.load(std::memory_order_relaxed));
+            std::fprintf(out, "%-20s %-32s %10.0f %6.2f%% %8.2fms %8lluns %8lluns %8lluns %8lluns\n",
+                         s->name.c_str(), shorten(s->location).c_str(), acq,
+                         100.0 * s->contended.load(std::memory_order_relaxed) / acq, s->waitNs.sum() / 1e6,
+                         static_cast<unsigned long long>(s->waitNs.percentile(0.50)),
+                         static_cast<unsigned long long>(s->waitNs.percentile(0.99)),
+                         static_cast<unsigned long long>(s->holdNs.percentile(0.50)),
+                         static_cast<unsigned long long>(s->holdNs.percentile(0.99)));
+        }
+    }
+
+    void reportAtExit(bool enabled) { atExit = enabled; }
+
+    ~Registry() {
+        if (atExit) report(stderr);
+    }
+
+private:
+    static std::string shorten(const std::string& path) {
+        auto slash = path.rfind('/');
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    std::mutex m;
+    std::vector<std::unique_ptr<Site>> sites;
+    bool atExit = true;
+};
+
+inline std::uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+constexpr unsigned kHoldSampleEvery = 64;
+
+} // namespace lockprof
+
+template <typename Mutex>
+class ProfiledLock {
+public:
+    explicit ProfiledLock(const char* name = "unnamed",
+                          std::source_location loc = std::source_location::current())
+        : defaultSite(&lockprof::Registry::instance().site(name, loc)) {}
+
+    ProfiledLock(const ProfiledLock&) = delete;
+    ProfiledLock& operator=(const ProfiledLock&) = delete;
+
+    void lock() { lock(*defaultSite); }
+    bool try_lock() { return try_lock(*defaultSite); }
+
+    void lock(lockprof::Site& site) {
+        if (!m.try_lock()) {
+            const std::uint64_t start = lockprof::nowNs();
+            m.lock();
+            site.contended.fetch_add(1, std::memory_order_relaxed);
+            site.waitNs.record(lockprof::nowNs() - start);
+        }
+        entered(site);
+    }
+
+    bool try_lock(lockprof::Site& site) {
+        if (!m.try_lock()) return false;
+        entered(site);
+        return true;
+    }
+
+    void unlock() {
+        // only the owner touches these, and only while it holds m
+        if constexpr (kRecursive) {
+            if (--depth != 0) {
+                m.unlock();
+                return;
+            }
+        }
+        if (holdSite) {
+            holdSite->holdNs.record(lockprof::nowNs() - holdStart);
+            holdSite = nullptr;
+        }
+        m.unlock();
+    }
+
+    lockprof::Site& site() { return *defaultSite; }
+
+private:
+    static constexpr bool kRecursive =
+        std::is_same_v<Mutex, std::recursive_mutex> || std::is_same_v<Mutex, std::recursive_timed_mutex>;
+
+    // called holding m, like everything that touches the fields below
+    void entered(lockprof::Site& site) {
+        const std::uint64_t n = site.acquisitions.load(std::memory_order_relaxed) + 1;
+        site.acquisitions.store(n, std::memory_order_relaxed);
+        if constexpr (kRecursive) {
+            if (depth++ != 0) return;
+        }
+        if ((n & (lockprof::kHoldSampleEvery - 1)) == 0) {
+            holdSite = &site;
+            holdStart = lockprof::nowNs();
+        }
+    }
+
+    Mutex m;
+    lockprof::Site* defaultSite;
+    // recursive mutexes only; hold time covers the outermost lock
+    unsigned depth = 0;
+    lockprof::Site* holdSite = nullptr;
+    std::uint64_t holdStart = 0;
+};
+
+template <typename Lock>
+class ProfiledGuard {
+public:
+    ProfiledGuard(Lock& l, lockprof::Site& site) : lock(l) { lock.lock(site); }
+    ~ProfiledGuard() { lock.unlock(); }
+
+    ProfiledGuard(const ProfiledGuard&) = delete;
+    ProfiledGuard& operator=(const ProfiledGuard&) = delete;
+
+private:
+    Lock& lock;
+};
+
+// lock_guard whose statistics are attributed to this line instead of to the
+// lock's declaration
+#define PROFILED_LOCK_GUARD(var, lockExpr)                                                          \
+    static lockprof::Site& var##_site =                                                             \
+        lockprof::Registry::instance().site(#lockExpr, std::source_location::current());            \
+    ProfiledGuard<std::remove_reference_t<decltype(lockExpr)>> var(lockExpr, var##_site)
+
+inline void dumpLockReport(std::FILE* out = stderr) { lockprof::Registry::instance().report(out); }
@@ -0,0 +1,326 @@
+#pragma once
+
+// Safe memory reclamation for lock-free containers.
+//
+// A lock-free reader may still be dereferencing a node that another thread
+// has just unlinked, so the unlinking thread cannot delete it right away
+// (that is use_after_free.cpp with extra steps). Both domains below take
+// ownership of unlinked nodes through retire() and only free them once no
+// reader can reach them any more.
+//
+// HazardDomain: readers publish the pointer they are about to use in a
+// per-thread hazard slot (protect()). Retired nodes are freed once no slot
+// holds them. Bounded garbage, one store + reload per protected load.
+//
+// EpochDomain: readers announce the global epoch while inside a Guard.
+// Nodes retired in epoch e are freed once every active reader has moved past
+// e + 1. Cheaper reads than hazard pointers, but one stalled reader holds
+// back all reclamation.
+//
+// Both use one process-wide domain (global()), like folly's default domains,
+// so per-thread state can live in a plain thread_local.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+namespace reclaim {
+
+struct Retired {
+    void* ptr;
+    void (*deleter)(void*);
+
+    void destroy() const { deleter(ptr); }
+};
+
+template <typename T>
+Retired makeRetired(T* p) {
+    return Retired{p, [](void* q) { delete static_cast<T*>(q); }};
+}
+
+class HazardDomain {
+public:
+    static constexpr int kSlotsPerThread = 4;
+
+    static HazardDomain& global() {
+        static HazardDomain domain;
+        return domain;
+    }
+
+    template <typename T>
+    void retire(T* p) {
+        auto& state = local();
+        state.retired.push_back(makeRetired(p));
+        if (state.retired.size() >= scanThreshold()) scan(state.retired);
+    }
+
+    // frees everything that is not currently protected
+    void collect() { scan(local().retired); }
+
+    ~HazardDomain() {
+        for (const Retired& r : orphans) r.destroy();
+        for (Record* rec = head.load(); rec;) {
+            Record* next = rec->next;
+            delete rec;
+            rec = next;
+        }
+    }
+
+private:
+    friend class HazardPointer;
+
+    struct Record {
+        std::atomic<const void*> hazards[kSlotsPerThread] = {};
+        std::atomic<bool> active{false};
+        unsigned usedSlots = 0; // owner thread only
+        Record* next = nullptr;
+    };
+
+    struct ThreadState {
+        Record* record = nullptr;
+        std::vector<Retired> retired;
+
+        ~ThreadState() {
+            auto& domain = HazardDomain::global();
+            domain.scan(retired);
+            if (!retired.empty()) {
+                std::lock_guard<std::mutex> guard(domain.orphanMutex);
+                domain.orphans.insert(domain.orphans.end(), retired.begin(), retired.end());
+            }
+            if (record) record->active.store(false, std::memory_order_release);
+        }
+    };
+
+    ThreadState& local() {
+        thread_local ThreadState state;
+        if (!state.record) state.record = acquireRecord();
+        return state;
+    }
+
+    Record* acquireRecord() {
+        for (Record* rec = head.load(std::memory_order_acquire); rec; rec = rec->next) {
+            bool expected = false;
+            if (!rec->active.load(std::memory_order_relaxed) &&
+                rec->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return rec;
+            }
+        }
+        Record* rec = new Record;
+        rec->active.store(true, std::memory_order_relaxed);
+        Record* old = head.load(std::memory_order_relaxed);
+        do {
+            rec->next = old;
+        } while (!head.compare_exchange_weak(old, rec, std::memory_order_release, std::memory_order_relaxed));
+        recordCount.fetch_add(1, std::memory_order_relaxed);
+        return rec;
+    }
+
+    // amortizes each scan over O(#hazards) retires
+    std::size_t scanThreshold() const {
+        return 2 * kSlotsPerThread * recordCount.load(std::memory_order_relaxed) + 64;
+    }
+
+    void scan(std::vector<Retired>& retired) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::vector<const void*> live;
+        for (Record* rec = head.load(std::memory_order_acquire); rec; rec = rec->next) {
+            for (auto& hz : rec->hazards) {
+                if (const void* p = hz.load(std::memory_order_acquire)) live.push_back(p);
+            }
+        }
+        std::sort(live.begin(), live.end());
+
+        auto keep = [&live](const Retired& r) { return std::binary_search(live.begin(), live.end(), r.ptr); };
+        auto split = std::partition(retired.begin(), retired.end(), keep);
+        for (auto it = split; it != retired.end(); ++it) it->destroy();
+        retired.erase(split, retired.end());
+
+        std::unique_lock<std::mutex> guard(orphanMutex, std::try_to_lock);
+        if (guard.owns_lock() && !orphans.empty()) {
+            auto orphanSplit = std::partition(orphans.begin(), orphans.end(), keep);
+            for (auto it = orphanSplit; it != orphans.end(); ++it) it->destroy();
+            orphans.erase(orphanSplit, orphans.end());
+        }
+    }
+
+    std::atomic<Record*> head{nullptr};
+    std::atomic<std::size_t> recordCount{0};
+    std::mutex orphanMutex;
+    std::vector<Retired> orphans;
+};
+
+// RAII owner of one hazard slot of the calling thread.
+class HazardPointer {
+public:
+    HazardPointer() : record(HazardDomain::global().local().record) {
+        for (slot = 0; slot < HazardDomain::kSlotsPerThread; ++slot) {
+            if (!(record->usedSlots & (1u << slot))) break;
+        }
+        if (slot == HazardDomain::kSlotsPerThread) std::terminate(); // too many live HazardPointers
+        record->usedSlots |= 1u << slot;
+    }
+
+    ~HazardPointer() {
+        reset();
+        record->usedSlots &= ~(1u << slot);
+    }
+
+    HazardPointer(const HazardPointer&) = delete;
+    HazardPointer& operator=(const HazardPointer&) = delete;
+
+    // loads src and keeps the result safe to dereference until reset()
+    template <typename T>
+    T* protect(const std::atomic<T*>& src) {
+        T* p = src.load(std::memory_order_relaxed);
+        for (;;) {
+            record->hazards[slot].store(p, std::memory_order_seq_cst);
+            T* again = src.load(std::memory_order_seq_cst);
+            if (again == p) return p;
+            p = again;
+        }
+    }
+
+    void reset() { record->hazards[slot].store(nullptr, std::memory_order_release); }
+
+private:
+    HazardDomain::Record* record;
+    int slot;
+};
+
+class EpochDomain {
+private:
+    struct Tagged {
+        std::uint64_t epoch;
+        Retired node;
+    };
+
+    struct Record {
+        // (epoch << 1) | 1 while the owner is inside a Guard, 0 otherwise
+        std::atomic<std::uint64_t> announced{0};
+        std::atomic<bool> active{false};
+        Record* next = nullptr;
+    };
+
+    struct ThreadState {
+        Record* record = nullptr;
+        int nesting = 0;
+        std::vector<Tagged> retired;
+
+        ~ThreadState() {
+            auto& domain = EpochDomain::global();
+            if (!retired.empty()) {
+                std::lock_guard<std::mutex> guard(domain.orphanMutex);
+                domain.orphans.insert(domain.orphans.end(), retired.begin(), retired.end());
+            }
+            if (record) record->active.store(false, std::memory_order_release);
+        }
+    };
+
+public:
+    static EpochDomain& global() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    // readers hold a Guard while they dereference shared nodes; guards nest
+    class Guard {
+    public:
+        Guard() : state(EpochDomain::global().local()) {
+            if (state.nesting++ == 0) {
+                auto& domain = EpochDomain::global();
+                const std::uint64_t e = domain.epoch.load(std::memory_order_relaxed);
+                // exchange rather than store + fence: a locked xchg is cheaper than mfence on x86
+                state.record->announced.exchange((e << 1) | 1, std::memory_order_seq_cst);
+            }
+        }
+
+        ~Guard() {
+            if (--state.nesting == 0) state.record->announced.store(0, std::memory_order_release);
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        ThreadState& state;
+    };
+
+    template <typename T>
+    void retire(T* p) {
+        auto& state = local();
+        // seq_cst orders the read after the unlink that made p unreachable;
+        // a relaxed one may see an older epoch and free p one epoch early
+        state.retired.push_back({epoch.load(std::memory_order_seq_cst), makeRetired(p)});
+        if (state.retired.size() >= 64) collect();
+    }
+
+    // tries to advance the epoch and frees whatever is two epochs old
+    void collect() {
+        tryAdvance();
+        const std::uint64_t safe = epoch.load(std::memory_order_acquire);
+        freeOlderThan(local().retired, safe);
+        std::unique_lock<std::mutex> guard(orphanMutex, std::try_to_lock);
+        if (guard.owns_lock()) freeOlderThan(orphans, safe);
+    }
+
+    ~EpochDomain() {
+        for (auto& r : orphans) r.node.destroy();
+        for (Record* rec = head.load(); rec;) {
+            Record* next = rec->next;
+            delete rec;
+            rec = next;
+        }
+    }
+
+private:
+    ThreadState& local() {
+        thread_local ThreadState state;
+        if (!state.record) state.record = acquireRecord();
+        return state;
+    }
+
+    Record* acquireRecord() {
+        for (Record* rec = head.load(std::memory_order_acquire); rec; rec = rec->next) {
+            bool expected = false;
+            if (!rec->active.load(std::memory_order_relaxed) &&
+                rec->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return rec;
+            }
+        }
+        Record* rec = new Record;
+        rec->active.store(true, std::memory_order_relaxed);
+        Record* old = head.load(std::memory_order_relaxed);
+        do {
+            rec->next = old;
+        } while (!head.compare_exchange_weak(old, rec, std::memory_order_release, std::memory_order_relaxed));
+        return rec;
+    }
+
+    void tryAdvance() {
+        std::uint64_t e = epoch.load(std::memory_order_seq_cst);
+        for (Record* rec = head.load(std::memory_order_acquire); rec; rec = rec->next) {
+            const std::uint64_t a = rec->announced.load(std::memory_order_seq_cst);
+            if ((a & 1) && (a >> 1) != e) return; // someone is still in an older epoch
+        }
+        epoch.compare_exchange_strong(e, e + 1, std::memory_order_acq_rel);
+    }
+
+    // a node retired in epoch r is unreachable once the global epoch reaches r + 2
+    static void freeOlderThan(std::vector<Tagged>& list, std::uint64_t current) {
+        auto split = std::partition(list.begin(), list.end(),
+                                    [current](const Tagged& t) { return t.epoch + 2 > current; });
+        for (auto it = split; it != list.end(); ++it) it->node.destroy();
+        list.erase(split, list.end());
+    }
+
+    std::atomic<std::uint64_t> epoch{0};
+    std::atomic<Record*> head{nullptr};
+    std::mutex orphanMutex;
+    std::vector<Tagged> orphans;
+};
+
+} // namespace reclaim
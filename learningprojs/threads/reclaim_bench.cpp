@@ -0,0 +1,181 @@
+
+// exercises reclaim.h two ways:
+//  1. a Treiber stack hammered by several threads, once per reclamation scheme.
+//     configure with -DSANITIZE=address or -DSANITIZE=thread to catch
+//     use-after-free and races (same flags memerrors/CMakeLists.txt uses).
+//  2. a read-heavy "current config" pointer that a writer keeps replacing,
+//     reporting reads/sec with no reclamation, hazard pointers and epochs.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "reclaim.h"
+
+using reclaim::EpochDomain;
+using reclaim::HazardDomain;
+using reclaim::HazardPointer;
+
+struct HazardPolicy {
+    struct Guard {};
+    struct Reader {
+        HazardPointer hp;
+        template <typename T>
+        T* load(const std::atomic<T*>& src) { return hp.protect(src); }
+    };
+    template <typename T>
+    static void retire(T* p) { HazardDomain::global().retire(p); }
+    static void collect() { HazardDomain::global().collect(); }
+};
+
+struct EpochPolicy {
+    using Guard = EpochDomain::Guard;
+    struct Reader {
+        template <typename T>
+        T* load(const std::atomic<T*>& src) { return src.load(std::memory_order_acquire); }
+    };
+    template <typename T>
+    static void retire(T* p) { EpochDomain::global().retire(p); }
+    static void collect() { EpochDomain::global().collect(); }
+};
+
+// baseline: no protection, the writer leaks old versions until the end
+struct NoReclaim {
+    struct Guard {};
+    struct Reader {
+        template <typename T>
+        T* load(const std::atomic<T*>& src) { return src.load(std::memory_order_acquire); }
+    };
+};
+
+template <typename Policy>
+class TreiberStack {
+    struct Node {
+        std::int64_t value;
+        Node* next;
+    };
+    std::atomic<Node*> top{nullptr};
+
+public:
+    ~TreiberStack() {
+        for (Node* n = top.load(); n;) {
+            Node* next = n->next;
+            delete n;
+            n = next;
+        }
+    }
+
+    void push(std::int64_t v) {
+        Node* n = new Node{v, top.load(std::memory_order_relaxed)};
+        while (!top.compare_exchange_weak(n->next, n, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    bool pop(std::int64_t& out) {
+        [[maybe_unused]] typename Policy::Guard guard;
+        typename Policy::Reader reader;
+        for (;;) {
+            Node* n = reader.load(top);
+            if (!n) return false;
+            // reading n->next is exactly the access that needs reclamation
+            Node* next = n->next;
+            if (top.compare_exchange_weak(n, next, std::memory_order_acq_rel)) {
+                out = n->value;
+                Policy::retire(n);
+                return true;
+            }
+        }
+    }
+};
+
+template <typename Policy>
+void stressStack(const std::string& name, int threads, int opsPerThread) {
+    TreiberStack<Policy> stack;
+    std::atomic<std::int64_t> pushed{0}, popped{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::int64_t in = 0, out = 0, v;
+            for (int i = 0; i < opsPerThread; ++i) {
+                std::int64_t value = static_cast<std::int64_t>(t) * opsPerThread + i;
+                stack.push(value);
+                in += value;
+                if (stack.pop(v)) out += v;
+            }
+            pushed += in;
+            popped += out;
+        });
+    }
+    for (auto& w : workers) w.join();
+    std::int64_t rest = 0, v;
+    while (stack.pop(v)) rest += v;
+    Policy::collect();
+    std::cout << name << " stack: " << (pushed == popped + rest ? "ok" : "MISMATCH") << "\n";
+}
+
+struct Config {
+    std::int64_t version;
+    std::int64_t payload[7];
+};
+
+template <typename Policy>
+void readHeavy(const std::string& name, int readers, std::chrono::milliseconds duration) {
+    std::atomic<Config*> current{new Config{0, {}}};
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> reads{0};
+    std::vector<Config*> leaked;
+
+    std::vector<std::thread> workers;
+    for (int r = 0; r < readers; ++r) {
+        workers.emplace_back([&] {
+            typename Policy::Reader reader;
+            std::uint64_t n = 0;
+            std::int64_t sink = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                [[maybe_unused]] typename Policy::Guard guard;
+                Config* c = reader.load(current);
+                sink += c->version + c->payload[3];
+                ++n;
+            }
+            reads += n + (sink == -1);
+        });
+    }
+    std::thread writer([&] {
+        for (std::int64_t v = 1; !stop.load(std::memory_order_relaxed); ++v) {
+            Config* old = current.exchange(new Config{v, {}});
+            if constexpr (std::is_same<Policy, NoReclaim>::value) {
+                leaked.push_back(old);
+            } else {
+                Policy::retire(old);
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    });
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto& w : workers) w.join();
+    writer.join();
+    for (Config* c : leaked) delete c;
+    delete current.load();
+    if constexpr (!std::is_same<Policy, NoReclaim>::value) Policy::collect();
+
+    double secs = std::chrono::duration<double>(duration).count();
+    std::cout << name << " read-heavy: " << static_cast<std::uint64_t>(reads / secs) << " reads/sec\n";
+}
+
+int main() {
+    int threads = std::max(4u, std::thread::hardware_concurrency());
+    stressStack<HazardPolicy>("hazard", threads, 200'000);
+    stressStack<EpochPolicy>("epoch ", threads, 200'000);
+
+    auto duration = std::chrono::milliseconds(500);
+    readHeavy<NoReclaim>("none  ", threads - 1, duration);
+    readHeavy<HazardPolicy>("hazard", threads - 1, duration);
+    readHeavy<EpochPolicy>("epoch ", threads - 1, duration);
+    return 0;
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+// Bounded ring-buffer queues for handing work between threads.
+//
+// SpscQueue: one producer, one consumer. Wait-free try_push/try_pop, each side
+// only writes its own index and keeps a cached copy of the other side's index
+// so the shared line is read only when the cached value says full/empty.
+//
+// MpmcQueue: Dmitry Vyukov's bounded MPMC queue. Every cell carries a sequence
+// number that tells producers/consumers whether the slot is free for their lap.
+//
+// Both queues put head and tail on separate cache lines, and offer blocking
+// push/pop built on C++20 atomic::wait, plus batch variants.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+constexpr std::size_t kCacheLine = 64;
+
+inline std::size_t roundUpPow2(std::size_t n) {
+    std::size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(std::size_t capacity)
+        : mask_(roundUpPow2(capacity < 2 ? 2 : capacity) - 1),
+          slots_(new Slot[mask_ + 1]) {}
+
+    ~SpscQueue() {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        for (std::size_t i = head_.load(std::memory_order_relaxed); i != tail; ++i) {
+            slots_[i & mask_].ptr()->~T();
+        }
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+    // producer side
+    template <typename U>
+    bool try_push(U&& value) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ > mask_) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ > mask_) return false;
+        }
+        new (slots_[tail & mask_].ptr()) T(std::forward<U>(value));
+        tail_.store(tail + 1, std::memory_order_release);
+        wakeConsumer();
+        return true;
+    }
+
+    template <typename U>
+    void push(U&& value) {
+        while (!try_push(std::forward<U>(value))) {
+            const std::size_t head = head_.load(std::memory_order_acquire);
+            if (tail_.load(std::memory_order_relaxed) - head <= mask_) continue;
+            producerWaiting_.store(true, std::memory_order_seq_cst);
+            head_.wait(head, std::memory_order_seq_cst);
+        }
+    }
+
+    // pushes up to n items, returns how many went in
+    std::size_t try_push_n(const T* items, std::size_t n) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t room = mask_ + 1 - (tail - headCache_);
+        if (room < n) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            room = mask_ + 1 - (tail - headCache_);
+        }
+        const std::size_t count = n < room ? n : room;
+        for (std::size_t i = 0; i < count; ++i) {
+            new (slots_[(tail + i) & mask_].ptr()) T(items[i]);
+        }
+        if (count) {
+            tail_.store(tail + count, std::memory_order_release);
+            wakeConsumer();
+        }
+        return count;
+    }
+
+    // consumer side
+    bool try_pop(T& out) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_) return false;
+        }
+        T* slot = slots_[head & mask_].ptr();
+        out = std::move(*slot);
+        slot->~T();
+        head_.store(head + 1, std::memory_order_release);
+        wakeProducer();
+        return true;
+    }
+
+    void pop(T& out) {
+        while (!try_pop(out)) {
+            const std::size_t tail = tail_.load(std::memory_order_acquire);
+            if (tail != head_.load(std::memory_order_relaxed)) continue;
+            consumerWaiting_.store(true, std::memory_order_seq_cst);
+            tail_.wait(tail, std::memory_order_seq_cst);
+        }
+    }
+
+    // pops up to n items, returns how many came out
+    std::size_t try_pop_n(T* out, std::size_t n) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t avail = tailCache_ - head;
+        if (avail < n) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            avail = tailCache_ - head;
+        }
+        const std::size_t count = n < avail ? n : avail;
+        for (std::size_t i = 0; i < count; ++i) {
+            T* slot = slots_[(head + i) & mask_].ptr();
+            out[i] = std::move(*slot);
+            slot->~T();
+        }
+        if (count) {
+            head_.store(head + count, std::memory_order_release);
+            wakeProducer();
+        }
+        return count;
+    }
+
+private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        T* ptr() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    // The fence orders our index store before the flag load; the sleeper does
+    // the mirror image (flag store, then index load inside wait()). The waker
+    // takes the flag, so a sleep costs one notify (a futex syscall) rather
+    // than one per push/pop until the sleeper gets around to clearing it.
+    void wakeConsumer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumerWaiting_.load(std::memory_order_relaxed) &&
+            consumerWaiting_.exchange(false, std::memory_order_relaxed)) {
+            tail_.notify_one();
+        }
+    }
+
+    void wakeProducer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (producerWaiting_.load(std::memory_order_relaxed) &&
+            producerWaiting_.exchange(false, std::memory_order_relaxed)) {
+            head_.notify_one();
+        }
+    }
+
+    const std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    // consumer-owned line
+    alignas(kCacheLine) std::atomic<std::size_t> head_{0};
+    std::size_t tailCache_ = 0;
+    std::atomic<bool> consumerWaiting_{false};
+
+    // producer-owned line
+    alignas(kCacheLine) std::atomic<std::size_t> tail_{0};
+    std::size_t headCache_ = 0;
+    std::atomic<bool> producerWaiting_{false};
+};
+
+template <typename T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(std::size_t capacity)
+        : mask_(roundUpPow2(capacity < 2 ? 2 : capacity) - 1),
+          cells_(new Cell[mask_ + 1]) {
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpmcQueue() {
+        const std::size_t tail = enqueuePos_.load(std::memory_order_relaxed);
+        for (std::size_t i = dequeuePos_.load(std::memory_order_relaxed); i != tail; ++i) {
+            cells_[i & mask_].ptr()->~T();
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+    template <typename U>
+    bool try_push(U&& value) {
+        std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            const std::size_t seq = cell.seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    publish(cell, pos, std::forward<U>(value));
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Claims a ticket unconditionally and then waits for that cell to come
+    // free, so blocked producers are served in FIFO order.
+    template <typename U>
+    void push(U&& value) {
+        const std::size_t pos = enqueuePos_.fetch_add(1, std::memory_order_relaxed);
+        Cell& cell = cells_[pos & mask_];
+        waitFor(cell, pos);
+        publish(cell, pos, std::forward<U>(value));
+    }
+
+    bool try_pop(T& out) {
+        std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            const std::size_t seq = cell.seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    consume(cell, pos, out);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // empty
+            } else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void pop(T& out) {
+        const std::size_t pos = dequeuePos_.fetch_add(1, std::memory_order_relaxed);
+        Cell& cell = cells_[pos & mask_];
+        waitFor(cell, pos + 1);
+        consume(cell, pos, out);
+    }
+
+    std::size_t try_push_n(const T* items, std::size_t n) {
+        std::size_t i = 0;
+        while (i < n && try_push(items[i])) ++i;
+        return i;
+    }
+
+    std::size_t try_pop_n(T* out, std::size_t n) {
+        std::size_t i = 0;
+        while (i < n && try_pop(out[i])) ++i;
+        return i;
+    }
+
+private:
+    struct alignas(kCacheLine) Cell {
+        std::atomic<std::size_t> seq;
+        std::atomic<std::uint32_t> waiters{0};
+        alignas(T) unsigned char storage[sizeof(T)];
+        T* ptr() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    template <typename U>
+    void publish(Cell& cell, std::size_t pos, U&& value) {
+        new (cell.ptr()) T(std::forward<U>(value));
+        cell.seq.store(pos + 1, std::memory_order_release);
+        wake(cell);
+    }
+
+    void consume(Cell& cell, std::size_t pos, T& out) {
+        T* slot = cell.ptr();
+        out = std::move(*slot);
+        slot->~T();
+        cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+        wake(cell);
+    }
+
+    void wake(Cell& cell) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (cell.waiters.load(std::memory_order_relaxed)) cell.seq.notify_all();
+    }
+
+    // Spin briefly, then park on the cell's sequence number until it equals
+    // want. The caller holds the ticket for this cell, so seq can't move
+    // past want before the caller itself stores the next value; "seq !=
+    // want" is the condition we sleep on.
+    void waitFor(Cell& cell, std::size_t want) {
+        for (int spin = 0; spin < 64; ++spin) {
+            if (cell.seq.load(std::memory_order_acquire) == want) return;
+        }
+        cell.waiters.fetch_add(1, std::memory_order_seq_cst);
+        for (;;) {
+            const std::size_t seq = cell.seq.load(std::memory_order_seq_cst);
+            if (seq == want) break;
+            cell.seq.wait(seq, std::memory_order_seq_cst);
+        }
+        cell.waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    const std::size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(kCacheLine) std::atomic<std::size_t> enqueuePos_{0};
+    alignas(kCacheLine) std::atomic<std::size_t> dequeuePos_{0};
+};
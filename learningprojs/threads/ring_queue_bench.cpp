@@ -0,0 +1,127 @@
+
+// compare the lock-free ring queues against a plain mutex + condvar queue.
+// each item carries the time it was pushed so consumers can sample latency.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ring_queue.h"
+
+using Clock = std::chrono::steady_clock;
+
+static std::uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+template <typename T>
+class MutexQueue {
+    std::mutex m;
+    std::condition_variable notEmpty, notFull;
+    std::deque<T> items;
+    std::size_t cap;
+public:
+    explicit MutexQueue(std::size_t capacity) : cap(capacity) {}
+
+    void push(const T& v) {
+        std::unique_lock<std::mutex> lock(m);
+        notFull.wait(lock, [this] { return items.size() < cap; });
+        items.push_back(v);
+        lock.unlock();
+        notEmpty.notify_one();
+    }
+
+    void pop(T& out) {
+        std::unique_lock<std::mutex> lock(m);
+        notEmpty.wait(lock, [this] { return !items.empty(); });
+        out = items.front();
+        items.pop_front();
+        lock.unlock();
+        notFull.notify_one();
+    }
+};
+
+template <typename Queue>
+void run(const std::string& name, int producers, int consumers, std::size_t opsPerProducer) {
+    Queue q(1024);
+    const std::size_t total = opsPerProducer * producers;
+    std::vector<std::vector<std::uint64_t>> samples(consumers);
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            for (std::size_t i = 0; i < opsPerProducer; ++i) q.push(nowNs());
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        // split the total so every consumer knows when to stop
+        std::size_t share = total / consumers + (c < static_cast<int>(total % consumers) ? 1 : 0);
+        threads.emplace_back([&q, &samples, c, share] {
+            std::uint64_t ts;
+            for (std::size_t i = 0; i < share; ++i) {
+                q.pop(ts);
+                if ((i & 63) == 0) samples[c].push_back(nowNs() - ts);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<std::uint64_t> lat;
+    for (auto& s : samples) lat.insert(lat.end(), s.begin(), s.end());
+    std::sort(lat.begin(), lat.end());
+    auto pct = [&lat](double p) { return lat.empty() ? 0 : lat[static_cast<std::size_t>(p * (lat.size() - 1))]; };
+
+    std::cout << name << " " << producers << "p/" << consumers << "c: "
+              << static_cast<std::uint64_t>(total / secs) << " ops/sec, latency p50="
+              << pct(0.50) << "ns p99=" << pct(0.99) << "ns\n";
+}
+
+int main(int argc, char** argv) {
+    std::size_t ops = argc > 1 ? std::stoull(argv[1]) : 2'000'000;
+
+    run<SpscQueue<std::uint64_t>>("spsc ", 1, 1, ops);
+    run<MutexQueue<std::uint64_t>>("mutex", 1, 1, ops);
+
+    run<MpmcQueue<std::uint64_t>>("mpmc ", 4, 4, ops / 4);
+    run<MutexQueue<std::uint64_t>>("mutex", 4, 4, ops / 4);
+
+    // batch API: move 64 items per index update
+    SpscQueue<std::uint64_t> q(1024);
+    auto start = Clock::now();
+    std::thread producer([&] {
+        std::uint64_t buf[64];
+        for (std::size_t sent = 0; sent < ops;) {
+            std::size_t n = std::min<std::size_t>(64, ops - sent);
+            for (std::size_t i = 0; i < n; ++i) buf[i] = sent + i;
+            std::size_t pushed = 0;
+            while (pushed < n) {
+                std::size_t k = q.try_push_n(buf + pushed, n - pushed);
+                if (k == 0) std::this_thread::yield();
+                pushed += k;
+            }
+            sent += n;
+        }
+    });
+    std::uint64_t buf[64];
+    std::uint64_t sum = 0;
+    for (std::size_t got = 0; got < ops;) {
+        std::size_t n = q.try_pop_n(buf, 64);
+        if (n == 0) std::this_thread::yield();
+        for (std::size_t i = 0; i < n; ++i) sum += buf[i];
+        got += n;
+    }
+    producer.join();
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "spsc batch 1p/1c: " << static_cast<std::uint64_t>(ops / secs) << " ops/sec (checksum "
+              << sum << ")\n";
+    return 0;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+// Primitives for read-mostly shared state.
+//
+// SeqLock<T>: for small trivially copyable snapshots. Readers never write to
+// shared memory; they copy the value and retry if a writer bumped the
+// sequence number meanwhile. Writers are serialized by a spinning flag.
+//
+// DistributedRWLock: a reader-writer lock whose reader counts are spread over
+// per-slot cache lines, so concurrent readers on different cores touch
+// different lines. Writers raise a flag and then wait for every slot to
+// drain, which makes writes more expensive than std::shared_mutex.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#include "ring_queue.h" // kCacheLine
+
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock copies T byte-wise");
+
+public:
+    SeqLock() = default;
+    explicit SeqLock(const T& initial) { store(initial); }
+
+    T read() const {
+        T out;
+        for (;;) {
+            const std::uint64_t before = seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            load(out);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == before) return out;
+        }
+    }
+
+    void write(const T& value) {
+        while (writing.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+        const std::uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        store(value);
+        seq.store(s + 2, std::memory_order_release);
+        writing.clear(std::memory_order_release);
+    }
+
+    // read-modify-write under the writer flag, e.g. bumping a counter
+    template <typename F>
+    void update(F&& f) {
+        while (writing.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+        T value;
+        load(value);
+        f(value);
+        const std::uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        store(value);
+        seq.store(s + 2, std::memory_order_release);
+        writing.clear(std::memory_order_release);
+    }
+
+private:
+    // the payload is kept in relaxed atomic words so a torn read is merely a
+    // retry and never a data race
+    static constexpr std::size_t kWords = (sizeof(T) + 7) / 8;
+
+    void load(T& out) const {
+        std::uint64_t tmp[kWords];
+        for (std::size_t i = 0; i < kWords; ++i) tmp[i] = data[i].load(std::memory_order_relaxed);
+        std::memcpy(&out, tmp, sizeof(T));
+    }
+
+    void store(const T& value) {
+        std::uint64_t tmp[kWords] = {};
+        std::memcpy(tmp, &value, sizeof(T));
+        for (std::size_t i = 0; i < kWords; ++i) data[i].store(tmp[i], std::memory_order_relaxed);
+    }
+
+    alignas(kCacheLine) std::atomic<std::uint64_t> seq{0};
+    std::atomic<std::uint64_t> data[kWords] = {};
+    std::atomic_flag writing = ATOMIC_FLAG_INIT;
+};
+
+class DistributedRWLock {
+public:
+    static constexpr std::size_t kSlots = 64;
+
+    DistributedRWLock() = default;
+    DistributedRWLock(const DistributedRWLock&) = delete;
+    DistributedRWLock& operator=(const DistributedRWLock&) = delete;
+
+    void lock_shared() {
+        std::atomic<int>& count = slots[mySlot()].readers;
+        for (;;) {
+            count.fetch_add(1, std::memory_order_seq_cst);
+            if (!writer.load(std::memory_order_seq_cst)) return;
+            // a writer is in or coming: back out so it can finish
+            count.fetch_sub(1, std::memory_order_release);
+            while (writer.load(std::memory_order_relaxed)) writer.wait(true, std::memory_order_relaxed);
+        }
+    }
+
+    void unlock_shared() { slots[mySlot()].readers.fetch_sub(1, std::memory_order_release); }
+
+    void lock() {
+        bool expected = false;
+        while (!writer.compare_exchange_weak(expected, true, std::memory_order_seq_cst)) {
+            writer.wait(true, std::memory_order_relaxed);
+            expected = false;
+        }
+        for (auto& slot : slots) {
+            while (slot.readers.load(std::memory_order_seq_cst) != 0) std::this_thread::yield();
+        }
+    }
+
+    void unlock() {
+        writer.store(false, std::memory_order_release);
+        writer.notify_all();
+    }
+
+private:
+    struct alignas(kCacheLine) Slot {
+        std::atomic<int> readers{0};
+    };
+
+    // threads get slots round-robin the first time they read
+    static std::size_t mySlot() {
+        static std::atomic<std::size_t> next{0};
+        thread_local std::size_t slot = next.fetch_add(1, std::memory_order_relaxed) % kSlots;
+        return slot;
+    }
+
+    Slot slots[kSlots];
+    alignas(kCacheLine) std::atomic<bool> writer{false};
+};
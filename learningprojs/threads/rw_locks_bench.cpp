@@ -0,0 +1,93 @@
+
+// read-mostly config/counters: std::shared_mutex vs DistributedRWLock vs SeqLock
+// at 90/10 and 99/1 read/write mixes.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rw_locks.h"
+
+struct Config {
+    std::int64_t requests;
+    std::int64_t errors;
+    std::int64_t bytes;
+    std::int64_t version;
+};
+
+template <typename Lock>
+struct Locked {
+    Lock lock;
+    Config cfg{};
+
+    Config read() {
+        std::shared_lock<Lock> guard(lock);
+        return cfg;
+    }
+
+    void write() {
+        std::lock_guard<Lock> guard(lock);
+        ++cfg.requests;
+        cfg.bytes += 128;
+        ++cfg.version;
+    }
+};
+
+struct Sequenced {
+    SeqLock<Config> seq{Config{}};
+
+    Config read() { return seq.read(); }
+
+    void write() {
+        seq.update([](Config& c) {
+            ++c.requests;
+            c.bytes += 128;
+            ++c.version;
+        });
+    }
+};
+
+template <typename Shared>
+void run(const std::string& name, int threads, int writeEvery, std::size_t opsPerThread) {
+    Shared shared;
+    std::atomic<std::int64_t> sink{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::int64_t local = 0;
+            for (std::size_t i = 0; i < opsPerThread; ++i) {
+                if ((i + t) % writeEvery == 0) {
+                    shared.write();
+                } else {
+                    local += shared.read().version;
+                }
+            }
+            sink += local;
+        });
+    }
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << " " << (100 - 100 / writeEvery) << "/" << 100 / writeEvery << ": "
+              << static_cast<std::uint64_t>(threads * opsPerThread / secs) << " ops/sec\n";
+}
+
+int main(int argc, char** argv) {
+    std::size_t ops = argc > 1 ? std::stoull(argv[1]) : 1'000'000;
+    int threads = std::max(4u, std::thread::hardware_concurrency());
+    std::cout << threads << " threads\n";
+
+    for (int writeEvery : {10, 100}) {
+        run<Locked<std::shared_mutex>>("std::shared_mutex", threads, writeEvery, ops);
+        run<Locked<DistributedRWLock>>("DistributedRWLock", threads, writeEvery, ops);
+        run<Sequenced>("SeqLock          ", threads, writeEvery, ops);
+    }
+    return 0;
+}
@@ -1,23 +1,10 @@
 
-// a lock implemented using atomic_flag by spinning/wasting CPU cycles
+// two threads contending on the Spinlock from spinlock.h
 
-#include <atomic>
 #include <thread>
 #include <iostream>
 
-class Spinlock {
-    std::atomic_flag flag;
-public:
-    Spinlock(): flag(ATOMIC_FLAG_INIT) {}
-
-    void lock() {
-        while (flag.test_and_set());
-    }
-
-    void unlock() {
-        flag.clear();
-    }
-};
+#include "spinlock.h"
 
 Spinlock spinlock;
 
@@ -0,0 +1,23 @@
+#pragma once
+
+// a lock implemented using atomic_flag by spinning/wasting CPU cycles
+
+#include <atomic>
+
+class Spinlock {
+    std::atomic_flag flag;
+public:
+    Spinlock(): flag(ATOMIC_FLAG_INIT) {}
+
+    void lock() {
+        while (flag.test_and_set(std::memory_order_acquire));
+    }
+
+    bool try_lock() {
+        return !flag.test_and_set(std::memory_order_acquire);
+    }
+
+    void unlock() {
+        flag.clear(std::memory_order_release);
+    }
+};
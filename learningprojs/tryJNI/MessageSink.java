@@ -0,0 +1,52 @@
+// MessageSink.java
+// The receiving end for jni_bench: MyJavaClass.printMessage without the
+// printing, so the benchmark times the calls and not System.out.
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.IntBuffer;
+import java.nio.charset.StandardCharsets;
+
+public class MessageSink {
+    private long messages;
+    private long chars;
+    private byte[] scratch = new byte[256];
+
+    public void acceptMessage(String message) {
+        ++messages;
+        chars += message.length();
+    }
+
+    // count messages packed by MessageBatch: a native-order int length,
+    // then that many UTF-8 bytes
+    public void acceptMessages(ByteBuffer batch, int count) {
+        ByteBuffer in = batch.duplicate().order(ByteOrder.nativeOrder());
+        for (int i = 0; i < count; ++i) {
+            int length = in.getInt();
+            if (length > scratch.length) scratch = new byte[Math.max(length, scratch.length * 2)];
+            in.get(scratch, 0, length);
+            acceptMessage(new String(scratch, 0, length, StandardCharsets.UTF_8));
+        }
+    }
+
+    public long sum(int[] values) {
+        long total = 0;
+        for (int v : values) total += v;
+        return total;
+    }
+
+    // the first count native-order ints of a direct buffer
+    public long sumBuffer(ByteBuffer values, int count) {
+        IntBuffer ints = values.duplicate().order(ByteOrder.nativeOrder()).asIntBuffer();
+        long total = 0;
+        for (int i = 0; i < count; ++i) total += ints.get(i);
+        return total;
+    }
+
+    public long messages() {
+        return messages;
+    }
+
+    public long chars() {
+        return chars;
+    }
+}
@@ -0,0 +1,180 @@
+// Calls per second from C++ into printMessage-style Java methods
+// (MessageSink.acceptMessage), done the way my_program.cpp did it and then
+// through jni_bridge.h, plus the ways of handing Java an int array.
+//
+//   javac MessageSink.java
+//   g++ -std=c++20 -O2 jni_bench.cpp jni_bridge.cpp -I$JAVA_HOME/include -I$JAVA_HOME/include/linux
+//       -L$JAVA_HOME/lib/server -Wl,-rpath,$JAVA_HOME/lib/server -ljvm -pthread -o jni_bench
+//   ./jni_bench [calls, default 1000000]
+//
+// The first rounds of each loop are run untimed so the JIT has compiled
+// the Java side before the clock starts.
+
+#include "jni_bridge.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsFor(const std::function<void()>& f) {
+    const auto start = Clock::now();
+    f();
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void report(const char* name, double secs, long calls) {
+    std::printf("%-44s %12.0f calls/s  %8.1f ns/call\n", name, static_cast<double>(calls) / secs,
+                secs * 1e9 / static_cast<double>(calls));
+    std::fflush(stdout);
+}
+
+// runs f(n) untimed to warm up, then timed
+void bench(const char* name, long calls, const std::function<void(long)>& f) {
+    f(calls / 10 + 1);
+    report(name, secondsFor([&] { f(calls); }), calls);
+}
+
+const char kMessage[] = "Hello from C++!";
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const long calls = argc > 1 ? std::atol(argv[1]) : 1000000;
+
+    try {
+        // what my_program.cpp paid before its one call
+        JvmSession* session = nullptr;
+        const double start = secondsFor([&] { session = &JvmSession::get({"-Djava.class.path=."}); });
+        std::printf("JNI_CreateJavaVM: %.1f ms, paid once per process\n\n", start * 1e3);
+        JvmSession& jvm = *session;
+        JNIEnv* env = jvm.env();
+
+        const GlobalRef sink = newInstance("MessageSink");
+        const Method accept = jvm.method("MessageSink", "acceptMessage", "(Ljava/lang/String;)V");
+        const Method acceptMessages = jvm.method("MessageSink", "acceptMessages", "(Ljava/nio/ByteBuffer;I)V");
+
+        std::printf("one message per call\n");
+        bench("FindClass + GetMethodID every call", calls, [&](long n) {
+            for (long i = 0; i < n; ++i) {
+                const jclass cls = env->FindClass("MessageSink");
+                const jmethodID id = env->GetMethodID(cls, "acceptMessage", "(Ljava/lang/String;)V");
+                const jstring message = env->NewStringUTF(kMessage);
+                env->CallVoidMethod(sink.get(), id, message);
+                env->DeleteLocalRef(message);
+                env->DeleteLocalRef(cls);
+            }
+            JvmSession::check(env, "uncached");
+        });
+        bench("cached method, new jstring each call", calls, [&](long n) {
+            for (long i = 0; i < n; ++i) {
+                const jstring message = env->NewStringUTF(kMessage);
+                env->CallVoidMethod(sink.get(), accept.id, message);
+                env->DeleteLocalRef(message);
+            }
+            JvmSession::check(env, "cached");
+        });
+        bench("cached method, one jstring reused", calls, [&](long n) {
+            const jstring message = env->NewStringUTF(kMessage);
+            for (long i = 0; i < n; ++i) env->CallVoidMethod(sink.get(), accept.id, message);
+            env->DeleteLocalRef(message);
+            JvmSession::check(env, "reused");
+        });
+
+        std::printf("\nbatched through a direct ByteBuffer (messages/s)\n");
+        for (const int perCall : {16, 256}) {
+            MessageBatch batch(static_cast<size_t>(perCall) * (sizeof(int32_t) + sizeof(kMessage)));
+            const std::string name = std::to_string(perCall) + " messages per call";
+            bench(name.c_str(), calls, [&](long n) {
+                for (long i = 0; i < n; ++i) {
+                    if (!batch.add(kMessage, sizeof(kMessage) - 1)) {
+                        batch.send(sink.get(), acceptMessages);
+                        batch.add(kMessage, sizeof(kMessage) - 1);
+                    }
+                }
+                batch.send(sink.get(), acceptMessages);
+            });
+        }
+
+        // a native thread: attached for every call, as code without a
+        // session has to, or once through env()
+        std::printf("\nfrom a native thread, cached method\n");
+        const long threadCalls = calls / 10 + 1;
+        bench("AttachCurrentThread / Detach per call", threadCalls, [&](long n) {
+            std::thread([&] {
+                for (long i = 0; i < n; ++i) {
+                    JNIEnv* e = nullptr;
+                    jvm.vm()->AttachCurrentThread(reinterpret_cast<void**>(&e), nullptr);
+                    const jstring message = e->NewStringUTF(kMessage);
+                    e->CallVoidMethod(sink.get(), accept.id, message);
+                    e->DeleteLocalRef(message);
+                    jvm.vm()->DetachCurrentThread();
+                }
+            }).join();
+        });
+        bench("attached once (JvmSession::env)", calls, [&](long n) {
+            std::thread([&] {
+                JNIEnv* e = jvm.env();
+                for (long i = 0; i < n; ++i) {
+                    const jstring message = e->NewStringUTF(kMessage);
+                    e->CallVoidMethod(sink.get(), accept.id, message);
+                    e->DeleteLocalRef(message);
+                }
+                JvmSession::check(e, "worker");
+            }).join();
+        });
+
+        // handing Java 1M ints and getting their sum back
+        constexpr jint kInts = 1 << 20;
+        const long arrayCalls = calls / 1000 + 1;
+        std::vector<jint> values(kInts);
+        std::iota(values.begin(), values.end(), 0);
+        const long long expected = std::accumulate(values.begin(), values.end(), 0LL);
+        const Method sum = jvm.method("MessageSink", "sum", "([I)J");
+        const Method sumBuffer = jvm.method("MessageSink", "sumBuffer", "(Ljava/nio/ByteBuffer;I)J");
+        const GlobalRef array(env, env->NewIntArray(kInts));
+        const auto ints = static_cast<jintArray>(array.get());
+        DirectBuffer direct(kInts * sizeof(jint));
+        long long got = 0;
+
+        std::printf("\n%d ints per call, summed in Java\n", kInts);
+        bench("SetIntArrayRegion (copy into the heap)", arrayCalls, [&](long n) {
+            for (long i = 0; i < n; ++i) {
+                env->SetIntArrayRegion(ints, 0, kInts, values.data());
+                got = env->CallLongMethod(sink.get(), sum.id, ints);
+            }
+        });
+        bench("GetPrimitiveArrayCritical (write in place)", arrayCalls, [&](long n) {
+            for (long i = 0; i < n; ++i) {
+                withCritical<jint>(env, ints, [&](jint* p) { std::iota(p, p + kInts, 0); });
+                got = env->CallLongMethod(sink.get(), sum.id, ints);
+            }
+        });
+        bench("direct ByteBuffer (shared memory)", arrayCalls, [&](long n) {
+            for (long i = 0; i < n; ++i) {
+                const auto p = reinterpret_cast<jint*>(direct.data());
+                std::iota(p, p + kInts, 0);
+                got = env->CallLongMethod(sink.get(), sumBuffer.id, direct.buffer(), kInts);
+            }
+        });
+        JvmSession::check(env, "arrays");
+        if (got != expected) std::printf("wrong sum: %lld, expected %lld\n", got, expected);
+
+        const Method messages = jvm.method("MessageSink", "messages", "()J");
+        std::printf("\nMessageSink saw %lld messages\n",
+                    static_cast<long long>(env->CallLongMethod(sink.get(), messages.id)));
+    } catch (const JavaError& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include "jni_bridge.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// detaches, at thread exit, a thread that env() attached
+struct Attachment {
+    JavaVM* vm = nullptr;
+    ~Attachment() {
+        if (vm) vm->DetachCurrentThread();
+    }
+};
+
+thread_local Attachment attachment;
+thread_local JNIEnv* threadEnv = nullptr;
+
+} // namespace
+
+JvmSession& JvmSession::get(const std::vector<std::string>& options) {
+    static JvmSession session(options);
+    return session;
+}
+
+JvmSession::JvmSession(const std::vector<std::string>& options) {
+    std::vector<JavaVMOption> vmOptions(options.size());
+    for (size_t i = 0; i < options.size(); ++i) vmOptions[i].optionString = const_cast<char*>(options[i].c_str());
+    JavaVMInitArgs args{};
+    args.version = JNI_VERSION_1_8;
+    args.nOptions = static_cast<jint>(vmOptions.size());
+    args.options = vmOptions.data();
+    args.ignoreUnrecognized = JNI_FALSE;
+    JNIEnv* env = nullptr;
+    if (JNI_CreateJavaVM(&vm_, reinterpret_cast<void**>(&env), &args) != JNI_OK)
+        throw JavaError("JNI_CreateJavaVM failed");
+    // the creating thread is attached already
+    threadEnv = env;
+}
+
+JvmSession::~JvmSession() {
+    JNIEnv* e = env();
+    for (auto& [name, cls] : classes_) e->DeleteGlobalRef(cls);
+    vm_->DestroyJavaVM();
+}
+
+JNIEnv* JvmSession::env() {
+    if (threadEnv) return threadEnv;
+    JNIEnv* e = nullptr;
+    const jint rc = vm_->GetEnv(reinterpret_cast<void**>(&e), JNI_VERSION_1_8);
+    if (rc == JNI_EDETACHED) {
+        if (vm_->AttachCurrentThreadAsDaemon(reinterpret_cast<void**>(&e), nullptr) != JNI_OK)
+            throw JavaError("AttachCurrentThread failed");
+        attachment.vm = vm_;
+    } else if (rc != JNI_OK) {
+        throw JavaError("GetEnv failed");
+    }
+    threadEnv = e;
+    return e;
+}
+
+void JvmSession::check(JNIEnv* env, const char* what) {
+    if (!env->ExceptionCheck()) return;
+    const jthrowable error = env->ExceptionOccurred();
+    env->ExceptionClear();
+    std::string message = what;
+    const jclass throwable = env->FindClass("java/lang/Throwable");
+    const jmethodID toString = env->GetMethodID(throwable, "toString", "()Ljava/lang/String;");
+    if (const auto text = static_cast<jstring>(env->CallObjectMethod(error, toString))) {
+        const char* chars = env->GetStringUTFChars(text, nullptr);
+        message += ": ";
+        message += chars;
+        env->ReleaseStringUTFChars(text, chars);
+        env->DeleteLocalRef(text);
+    }
+    env->ExceptionClear();
+    env->DeleteLocalRef(throwable);
+    env->DeleteLocalRef(error);
+    throw JavaError(message);
+}
+
+jclass JvmSession::findClass(const std::string& name) {
+    std::lock_guard lock(mutex_);
+    if (const auto it = classes_.find(name); it != classes_.end()) return it->second;
+    JNIEnv* e = env();
+    const jclass local = e->FindClass(name.c_str());
+    check(e, name.c_str());
+    const auto global = static_cast<jclass>(e->NewGlobalRef(local));
+    e->DeleteLocalRef(local);
+    classes_.emplace(name, global);
+    return global;
+}
+
+Method JvmSession::method(const std::string& cls, const char* name, const char* signature) {
+    const jclass c = findClass(cls);
+    JNIEnv* e = env();
+    const jmethodID id = e->GetMethodID(c, name, signature);
+    check(e, name);
+    return {c, id};
+}
+
+Method JvmSession::staticMethod(const std::string& cls, const char* name, const char* signature) {
+    const jclass c = findClass(cls);
+    JNIEnv* e = env();
+    const jmethodID id = e->GetStaticMethodID(c, name, signature);
+    check(e, name);
+    return {c, id};
+}
+
+GlobalRef::GlobalRef(JNIEnv* env, jobject local) : ref_(local ? env->NewGlobalRef(local) : nullptr) {
+    if (local) env->DeleteLocalRef(local);
+}
+
+GlobalRef& GlobalRef::operator=(GlobalRef&& other) noexcept {
+    if (this != &other) {
+        reset();
+        ref_ = other.ref_;
+        other.ref_ = nullptr;
+    }
+    return *this;
+}
+
+void GlobalRef::reset() {
+    if (ref_) JvmSession::get().env()->DeleteGlobalRef(ref_);
+    ref_ = nullptr;
+}
+
+GlobalRef newInstance(const std::string& cls) {
+    JvmSession& jvm = JvmSession::get();
+    const Method ctor = jvm.method(cls, "<init>", "()V");
+    JNIEnv* env = jvm.env();
+    const jobject object = env->NewObject(ctor.cls, ctor.id);
+    JvmSession::check(env, cls.c_str());
+    return GlobalRef(env, object);
+}
+
+LocalFrame::LocalFrame(JNIEnv* env, jint capacity) : env_(env) {
+    if (env_->PushLocalFrame(capacity) < 0) {
+        JvmSession::check(env_, "PushLocalFrame");
+        throw JavaError("PushLocalFrame failed");
+    }
+}
+
+DirectBuffer::DirectBuffer(size_t capacity)
+    : data_(static_cast<char*>(std::aligned_alloc(64, (capacity + 63) / 64 * 64))), capacity_(capacity) {
+    if (!data_) throw std::bad_alloc();
+    JNIEnv* env = JvmSession::get().env();
+    const jobject buffer = env->NewDirectByteBuffer(data_.get(), static_cast<jlong>(capacity_));
+    JvmSession::check(env, "NewDirectByteBuffer");
+    if (!buffer) throw JavaError("direct buffers not supported by this VM");
+    buffer_ = GlobalRef(env, buffer);
+}
+
+bool MessageBatch::add(const char* text, size_t length) {
+    if (length > INT32_MAX || buffer_.capacity() - used_ < sizeof(int32_t) + length) return false;
+    const auto n = static_cast<int32_t>(length);
+    std::memcpy(buffer_.data() + used_, &n, sizeof(n));
+    std::memcpy(buffer_.data() + used_ + sizeof(n), text, length);
+    used_ += sizeof(n) + length;
+    ++count_;
+    return true;
+}
+
+void MessageBatch::send(jobject target, const Method& method) {
+    if (count_ == 0) return;
+    JNIEnv* env = JvmSession::get().env();
+    env->CallVoidMethod(target, method.id, buffer_.buffer(), static_cast<jint>(count_));
+    used_ = 0;
+    count_ = 0;
+    JvmSession::check(env, "batch");
+}
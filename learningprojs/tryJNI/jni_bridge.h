@@ -0,0 +1,157 @@
+#pragma once
+
+// A JNI bridge that keeps one JVM for the life of the process.
+//
+// my_program.cpp pays for everything on every run: JNI_CreateJavaVM (tens
+// of milliseconds), FindClass and GetMethodID (name lookups), then
+// DestroyJavaVM. A process can only ever create one VM anyway, so
+// JvmSession starts it on first use and keeps it. Classes are looked up
+// once and held as global references; Method keeps the jmethodID, which
+// stays valid as long as its class is loaded. Both may be used from any
+// thread.
+//
+// Native threads must be attached to the VM before calling into Java.
+// env() attaches a thread on its first call and detaches it when the
+// thread exits, rather than once per call.
+//
+// A pending Java exception is turned into JavaError (and cleared) by
+// check().
+
+#include <jni.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct JavaError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// a method looked up once: env->Call<Type>Method(object, id, args...)
+struct Method {
+    jclass cls;
+    jmethodID id;
+};
+
+class JvmSession {
+public:
+    // the process's VM, started by the first call with that call's options
+    static JvmSession& get(const std::vector<std::string>& options = {"-Djava.class.path=."});
+
+    JavaVM* vm() const { return vm_; }
+
+    // the calling thread's JNIEnv, attaching the thread (as a daemon, so
+    // it does not keep the VM alive) the first time
+    JNIEnv* env();
+
+    // global reference to the class, e.g. "java/lang/String"
+    jclass findClass(const std::string& name);
+    Method method(const std::string& cls, const char* name, const char* signature);
+    Method staticMethod(const std::string& cls, const char* name, const char* signature);
+
+    // throws JavaError carrying the exception's toString() if one is pending
+    static void check(JNIEnv* env, const char* what);
+
+private:
+    explicit JvmSession(const std::vector<std::string>& options);
+    ~JvmSession();
+    JvmSession(const JvmSession&) = delete;
+    JvmSession& operator=(const JvmSession&) = delete;
+
+    JavaVM* vm_ = nullptr;
+    std::mutex mutex_;
+    std::unordered_map<std::string, jclass> classes_;
+};
+
+// Owns a global reference, e.g. to an object kept across calls and threads.
+class GlobalRef {
+public:
+    GlobalRef() = default;
+    // takes over local (a local reference, deleted here)
+    GlobalRef(JNIEnv* env, jobject local);
+    ~GlobalRef() { reset(); }
+    GlobalRef(GlobalRef&& other) noexcept : ref_(other.ref_) { other.ref_ = nullptr; }
+    GlobalRef& operator=(GlobalRef&& other) noexcept;
+
+    jobject get() const { return ref_; }
+    void reset();
+
+private:
+    jobject ref_ = nullptr;
+};
+
+// `new cls()` through its no-argument constructor
+GlobalRef newInstance(const std::string& cls);
+
+// Pops every local reference made in its scope, for loops that make them
+// (a thread's local reference table is small and only freed on return to Java).
+class LocalFrame {
+public:
+    explicit LocalFrame(JNIEnv* env, jint capacity = 16);
+    ~LocalFrame() { env_->PopLocalFrame(nullptr); }
+    LocalFrame(const LocalFrame&) = delete;
+    LocalFrame& operator=(const LocalFrame&) = delete;
+
+private:
+    JNIEnv* env_;
+};
+
+// Native memory that Java sees as a direct java.nio.ByteBuffer: what one
+// side writes the other reads in place, with no copy in either direction.
+class DirectBuffer {
+public:
+    explicit DirectBuffer(size_t capacity);
+
+    char* data() { return data_.get(); }
+    size_t capacity() const { return capacity_; }
+    jobject buffer() const { return buffer_.get(); }
+
+private:
+    struct Free {
+        void operator()(char* p) const { std::free(p); }
+    };
+    std::unique_ptr<char, Free> data_;
+    size_t capacity_;
+    GlobalRef buffer_;
+};
+
+// Messages packed for one call: each a native-order int32 length and its
+// UTF-8 bytes, as MessageSink.acceptMessages reads them.
+class MessageBatch {
+public:
+    explicit MessageBatch(size_t capacity) : buffer_(capacity) {}
+
+    // false when the message does not fit; send() and start over
+    bool add(const char* text, size_t length);
+    // calls target.method(buffer, count) and empties the batch
+    void send(jobject target, const Method& method);
+
+    int count() const { return count_; }
+
+private:
+    DirectBuffer buffer_;
+    size_t used_ = 0;
+    int count_ = 0;
+};
+
+// Runs f(pointer) on the elements of a primitive Java array in place,
+// without copying them out and back. Between Get and Release the GC may be
+// held off: f must be short, must not block and must not call JNI.
+template <typename T, typename F>
+void withCritical(JNIEnv* env, jarray array, F&& f) {
+    struct Release {
+        JNIEnv* env;
+        jarray array;
+        void* p;
+        ~Release() { env->ReleasePrimitiveArrayCritical(array, p, 0); }
+    };
+    void* p = env->GetPrimitiveArrayCritical(array, nullptr);
+    if (!p) throw JavaError("GetPrimitiveArrayCritical failed");
+    Release release{env, array, p};
+    f(static_cast<T*>(p));
+}
@@ -1,45 +1,27 @@
 #include <iostream>
-#include <jni.h>
 
-int main() {
-    // Initialize the Java Virtual Machine (JVM)
-    JavaVM *jvm;
-    JNIEnv *env;
-
-    JavaVMInitArgs vmArgs;
-    JavaVMOption options[1];
-    options[0].optionString = "-Djava.class.path=</Users/jayshah/Documents/programming/cppwork/learningprojs/tryJNI>";  // Set the classpath
-    vmArgs.version = JNI_VERSION_1_8;
-    vmArgs.nOptions = 1;
-    vmArgs.options = options;
-    vmArgs.ignoreUnrecognized = JNI_FALSE;
-
-    JNI_CreateJavaVM(&jvm, (void**)&env, &vmArgs);
-
-    // Find the class
-    jclass javaClass = env->FindClass("MyJavaClass");
-
-    if (javaClass != nullptr) {
-        // Find the method
-        jmethodID methodId = env->GetMethodID(javaClass, "printMessage", "(Ljava/lang/String;)V");
+#include "jni_bridge.h"
 
-        if (methodId != nullptr) {
-            // Call the method
-            jstring message = env->NewStringUTF("Hello from C++!");
-            env->CallVoidMethod(javaClass, methodId, message);
+int main() {
+    try {
+        // Start the JVM (once per process) with the current directory as classpath
+        JvmSession& jvm = JvmSession::get({"-Djava.class.path=."});
+
+        // Look up the method once; printMessage is an instance method, so it
+        // needs a MyJavaClass object, not the class
+        const Method printMessage = jvm.method("MyJavaClass", "printMessage", "(Ljava/lang/String;)V");
+        const GlobalRef object = newInstance("MyJavaClass");
+
+        JNIEnv* env = jvm.env();
+        for (const char* text : {"Hello from C++!", "Same VM, same method ID."}) {
+            jstring message = env->NewStringUTF(text);
+            env->CallVoidMethod(object.get(), printMessage.id, message);
             env->DeleteLocalRef(message);
-        } else {
-            std::cerr << "Method not found" << std::endl;
+            JvmSession::check(env, "printMessage");
         }
-
-        // Release the class reference
-        env->DeleteLocalRef(javaClass);
-    } else {
-        std::cerr << "Class not found" << std::endl;
+    } catch (const JavaError& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
-
-    // Destroy the JVM
-    jvm->DestroyJavaVM();
-
     return 0;
 }
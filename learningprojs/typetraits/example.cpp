@@ -1,10 +1,16 @@
 #include <iostream>
 #include <type_traits>
 
+#include "records.h"
+#include "serialize.h"
+
+// `if constexpr` picks the branch when the template is instantiated, so
+// only the one for T is compiled in (and the other may not even compile
+// for T); a plain `if` on a trait keeps both and tests a constant at run time.
 template <typename T>
-void checkIntegral(T t)
+void checkIntegral(T)
 {
-    if (std::is_integral<T>::value)
+    if constexpr (std::is_integral_v<T>)
     {
         std::cout << "T is an integral type" << std::endl;
     }
@@ -17,9 +23,13 @@ void checkIntegral(T t)
 template <typename T>
 void checkIfPointer(T t)
 {
-    if (std::is_pointer<T>::value)
+    if constexpr (std::is_pointer_v<T>)
     {
         std::cout << "T is a pointer type" << std::endl;
+        if constexpr (!std::is_void_v<std::remove_pointer_t<T>>)
+        {
+            std::cout << "  and points to " << *t << std::endl;
+        }
     }
     else
     {
@@ -27,6 +37,32 @@ void checkIfPointer(T t)
     }
 }
 
+// serialize.h is built the same way: each type takes one path
+template <typename T>
+void showBytes(const char* what, const T& value)
+{
+    const std::string bytes = serial::serialize(value);
+    std::cout << what << ": " << bytes.size() << " bytes, reads back "
+              << (serial::deserialize<T>(bytes) == value ? "equal" : "DIFFERENT") << std::endl;
+}
+
+// found at compile time: a pointer in an aggregate, at any depth, doesn't
+// compile (serial::serialize(Link{}) is an error), and a view isn't copied
+// as bytes but writes what it refers to
+struct Link
+{
+    int value;
+    int* next;
+};
+struct Chain
+{
+    Link first;
+    int length;
+};
+static_assert(serial::detail::holdsPointer<Link>() && serial::detail::holdsPointer<Chain>());
+static_assert(!serial::detail::isRaw<Chain> && !serial::detail::isRaw<std::string_view>);
+static_assert(serial::detail::isRaw<pixel> && !serial::detail::holdsPointer<Person>());
+
 int main()
 {
     checkIntegral(5);
@@ -34,6 +70,17 @@ int main()
     checkIfPointer(5);
     checkIfPointer(nullptr);
     checkIfPointer("Hello");
-    checkIfPointer(new int(5));
+    int* p = new int(5);
+    checkIfPointer(p);
+    delete p;
+
+    showBytes("int 5 (varint)", 5);
+    showBytes("int -300 (zig-zag varint)", -300);
+    showBytes("pixel (memcpy)", pixel{255, 128, 0});
+    std::cout << "string_view \"hello\": " << serial::serialize(std::string_view{"hello"}).size()
+              << " bytes, as std::string: " << serial::serialize(std::string{"hello"}).size() << std::endl;
+    showBytes("Customer (fields)", Customer{"Ada", {1, 2, 3, 1'000'000}});
+    showBytes("Person (fields, nested)",
+              Person{"Grace", 37, 1.68, std::vector<pixel>(16, pixel{10, 20, 30}), {"Grace's", {7}}});
     return 0;
-}
\ No newline at end of file
+}
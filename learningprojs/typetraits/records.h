@@ -0,0 +1,33 @@
+#pragma once
+
+// Plain-data versions of types elsewhere in learningprojs, for serialize.h:
+// aggregates, so serial can see their fields.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// as in mikeshahchap1/include/pixel.h: trivially copyable, so written whole
+struct pixel {
+    unsigned char r, g, b;
+
+    bool operator==(const pixel&) const = default;
+};
+
+// the data of cppmove's Customer
+struct Customer {
+    std::string name;
+    std::vector<int> values;
+
+    bool operator==(const Customer&) const = default;
+};
+
+struct Person {
+    std::string name;
+    std::uint16_t age;
+    double height;
+    std::vector<pixel> avatar;
+    Customer account;
+
+    bool operator==(const Person&) const = default;
+};
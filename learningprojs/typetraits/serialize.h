@@ -0,0 +1,433 @@
+#pragma once
+
+// serial: binary serialization chosen per type at compile time with type
+// traits and `if constexpr`, so each type compiles down to the one path it
+// takes and nothing is decided at run time.
+//
+//   serial::Writer out;
+//   out << person << pixels;              // or serial::serialize(person)
+//   serial::Reader in(out.view());
+//   in >> person >> pixels;               // or serial::deserialize<Person>(bytes)
+//
+// How a T is written, the first that applies:
+//   bool, 1-byte integers, floating point   its bytes
+//   other integers                          varint, 7 bits a byte (zig-zag
+//                                           first if signed, so -1 is 1 byte)
+//   enums                                   as the underlying integer
+//   sized ranges                            varint size, then the elements;
+//                                           one memcpy for all of them if the
+//                                           range is contiguous and they are
+//                                           trivially copyable (std::string,
+//                                           std::vector<pixel>, std::array<int, 4>).
+//                                           Views write what they refer to:
+//                                           a std::string_view like a std::string
+//   other trivially copyable types          its bytes, in one memcpy (pixel)
+//   pairs and tuples                        each element
+//   aggregates                              each field, found with a
+//                                           structured binding
+// Anything else doesn't compile. Neither does a pointer, or an aggregate
+// holding one at any depth: its target would be lost. (An aggregate holding
+// a view isn't copied as bytes either; it is written field by field.) The
+// check can't see inside classes that aren't aggregates (private members),
+// or aggregates of more than 64 fields and array elements; those are
+// copied whole, unchecked, when trivially copyable.
+//
+// The format is for the same program on the same kind of machine: memcpy'd
+// values are in host byte order and layout (padding included). Aggregates
+// written field by field (those that aren't trivially copyable) may have up
+// to 8 fields, no base classes and no C array fields. Reader throws
+// std::runtime_error on input that ends early or doesn't fit the type.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace serial {
+
+namespace detail {
+
+template <typename T>
+inline constexpr bool alwaysFalse = false;
+
+template <typename T>
+inline constexpr bool isBytes = std::is_same_v<T, bool> || std::is_floating_point_v<T> ||
+                                (std::is_integral_v<T> && sizeof(T) == 1);
+
+template <typename T>
+concept TupleLike = requires { std::tuple_size<T>::value; };
+
+// converts to any field type, so T{AnyField{}, ...} compiles with as many
+// as T has fields (a C array field takes one per element, hence none of
+// those for field-by-field writing). Counts stop past MaxFields.
+struct AnyField {
+    template <typename T>
+    operator T() const;
+};
+
+inline constexpr std::size_t MaxFields = 64;
+
+template <typename T, typename... Fields>
+constexpr std::size_t fieldCount() {
+    if constexpr (sizeof...(Fields) <= MaxFields && requires { T{Fields{}..., AnyField{}}; })
+        return fieldCount<T, Fields..., AnyField>();
+    else
+        return sizeof...(Fields);
+}
+
+// calls f with every field of the aggregate value
+template <typename T, typename F>
+void visitFields(T& value, F&& f) {
+    constexpr std::size_t n = fieldCount<std::remove_const_t<T>>();
+    if constexpr (n == 0) {
+        f();
+    } else if constexpr (n == 1) {
+        auto& [a] = value;
+        f(a);
+    } else if constexpr (n == 2) {
+        auto& [a, b] = value;
+        f(a, b);
+    } else if constexpr (n == 3) {
+        auto& [a, b, c] = value;
+        f(a, b, c);
+    } else if constexpr (n == 4) {
+        auto& [a, b, c, d] = value;
+        f(a, b, c, d);
+    } else if constexpr (n == 5) {
+        auto& [a, b, c, d, e] = value;
+        f(a, b, c, d, e);
+    } else if constexpr (n == 6) {
+        auto& [a, b, c, d, e, g] = value;
+        f(a, b, c, d, e, g);
+    } else if constexpr (n == 7) {
+        auto& [a, b, c, d, e, g, h] = value;
+        f(a, b, c, d, e, g, h);
+    } else if constexpr (n == 8) {
+        auto& [a, b, c, d, e, g, h, i] = value;
+        f(a, b, c, d, e, g, h, i);
+    } else {
+        static_assert(alwaysFalse<T>, "serial: aggregates may have up to 8 fields");
+    }
+}
+
+template <typename T>
+constexpr bool holdsPointer();
+
+// converts to any type without a pointer in it; conversion to one is
+// deleted rather than missing, so an aggregate field of such a type isn't
+// initialized through brace elision instead
+struct NoPointer {
+    template <typename T>
+        requires(!holdsPointer<T>())
+    operator T() const;
+    template <typename T>
+        requires(holdsPointer<T>())
+    operator T() const = delete;
+};
+
+template <std::size_t>
+using NoPointerAt = NoPointer;
+
+template <typename T, std::size_t... I>
+constexpr bool fieldsHoldPointer(std::index_sequence<I...>) {
+    return !requires { T{NoPointerAt<I>{}...}; };
+}
+
+template <typename T, std::size_t... I>
+constexpr bool elementsHoldPointer(std::index_sequence<I...>) {
+    return (holdsPointer<std::tuple_element_t<I, T>>() || ...);
+}
+
+// whether T has a pointer in it that serial can find: T itself, its
+// elements, or its fields at any depth (views count, they are pointers in
+// all but name)
+template <typename T>
+constexpr bool holdsPointer() {
+    if constexpr (std::is_pointer_v<T> || std::is_member_pointer_v<T> || std::ranges::view<T>) {
+        return true;
+    } else if constexpr (std::is_array_v<T>) {
+        return holdsPointer<std::remove_extent_t<T>>();
+    } else if constexpr (TupleLike<T>) {
+        return elementsHoldPointer<T>(std::make_index_sequence<std::tuple_size_v<T>>{});
+    } else if constexpr (std::is_class_v<T> && std::is_aggregate_v<T>) {
+        constexpr std::size_t n = fieldCount<T>();
+        if constexpr (n <= MaxFields)
+            return fieldsHoldPointer<T>(std::make_index_sequence<n>{});
+        else
+            return false;
+    } else {
+        return false;
+    }
+}
+
+// copied as bytes
+template <typename T>
+constexpr bool rawCopyable() {
+    if constexpr (std::is_trivially_copyable_v<T>)
+        return !holdsPointer<T>();
+    else
+        return false;
+}
+
+template <typename T>
+inline constexpr bool isRaw = rawCopyable<T>();
+
+// what a container's elements are read into: a map's pair<const K, V> as pair<K, V>
+template <typename T>
+struct Stored {
+    using type = T;
+};
+template <typename K, typename V>
+struct Stored<std::pair<const K, V>> {
+    using type = std::pair<K, V>;
+};
+
+inline std::uint64_t zigzag(std::int64_t v) {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+inline std::int64_t unzigzag(std::uint64_t v) {
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+} // namespace detail
+
+class Writer {
+public:
+    explicit Writer(std::size_t capacity = 4096) { grow(capacity); }
+
+    template <typename T>
+    Writer& write(const T& value);
+
+    template <typename T>
+    Writer& operator<<(const T& value) { return write(value); }
+
+    void writeBytes(const void* bytes, std::size_t n) {
+        if (n == 0) return;
+        std::memcpy(room(n), bytes, n);
+        size_ += n;
+    }
+
+    void writeVarint(std::uint64_t v) {
+        char* const start = room(10);
+        char* p = start;
+        for (; v >= 0x80; v >>= 7) *p++ = static_cast<char>(v | 0x80);
+        *p++ = static_cast<char>(v);
+        size_ += p - start;
+    }
+
+    // what has been written; valid until the next write
+    std::string_view view() const { return {data_.get(), size_}; }
+    std::size_t size() const { return size_; }
+    // starts over, keeping the buffer
+    void clear() { size_ = 0; }
+
+private:
+    // n bytes of space at the end, not yet counted in size_
+    char* room(std::size_t n) {
+        if (capacity_ - size_ < n) grow(size_ + n);
+        return data_.get() + size_;
+    }
+
+    void grow(std::size_t needed) {
+        const std::size_t capacity = std::max(needed, capacity_ * 2);
+        auto data = std::make_unique_for_overwrite<char[]>(capacity);
+        if (size_) std::memcpy(data.get(), data_.get(), size_);
+        data_ = std::move(data);
+        capacity_ = capacity;
+    }
+
+    std::unique_ptr<char[]> data_;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view bytes) : pos_(bytes.data()), end_(bytes.data() + bytes.size()) {}
+
+    template <typename T>
+    Reader& read(T& value);
+
+    template <typename T>
+    T read() {
+        T value{};
+        read(value);
+        return value;
+    }
+
+    template <typename T>
+    Reader& operator>>(T& value) { return read(value); }
+
+    void readBytes(void* bytes, std::size_t n) {
+        need(n);
+        if (n == 0) return;
+        std::memcpy(bytes, pos_, n);
+        pos_ += n;
+    }
+
+    std::uint64_t readVarint() {
+        std::uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            need(1);
+            const auto byte = static_cast<unsigned char>(*pos_++);
+            // the 10th byte holds only bit 63; more would be shifted out
+            if (shift == 63 && (byte & 0x7e))
+                throw std::runtime_error("serial: varint larger than 64 bits");
+            v |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (byte < 0x80) return v;
+        }
+        throw std::runtime_error("serial: varint longer than 10 bytes");
+    }
+
+    std::size_t remaining() const { return end_ - pos_; }
+    bool atEnd() const { return pos_ == end_; }
+
+private:
+    void need(std::size_t n) const {
+        if (remaining() < n) throw std::runtime_error("serial: input ends in the middle of a value");
+    }
+
+    // a size read from the input, checked against what is left of it so a
+    // corrupt one can't ask for a huge allocation
+    std::size_t readSize(std::size_t elementSize) {
+        const std::uint64_t n = readVarint();
+        if (n > remaining() / std::max<std::size_t>(elementSize, 1))
+            throw std::runtime_error("serial: size larger than the input");
+        return static_cast<std::size_t>(n);
+    }
+
+    const char* pos_;
+    const char* end_;
+};
+
+template <typename T>
+Writer& Writer::write(const T& value) {
+    static_assert(!std::is_pointer_v<T> && !std::is_member_pointer_v<T>,
+                  "serial: a pointer's target would not be written; write what it points to");
+    if constexpr (detail::isBytes<T>) {
+        writeBytes(&value, sizeof value);
+    } else if constexpr (std::is_integral_v<T>) {
+        if constexpr (std::is_signed_v<T>)
+            writeVarint(detail::zigzag(value));
+        else
+            writeVarint(value);
+    } else if constexpr (std::is_enum_v<T>) {
+        write(static_cast<std::underlying_type_t<T>>(value));
+    } else if constexpr (std::ranges::sized_range<const T>) {
+        using Element = std::ranges::range_value_t<const T>;
+        const std::size_t n = std::ranges::size(value);
+        writeVarint(n);
+        if constexpr (std::ranges::contiguous_range<const T> && detail::isRaw<Element>) {
+            writeBytes(std::ranges::data(value), n * sizeof(Element));
+        } else {
+            for (const auto& element : value) write(element);
+        }
+    } else if constexpr (detail::isRaw<T>) {
+        writeBytes(&value, sizeof value);
+    } else if constexpr (detail::TupleLike<T>) {
+        std::apply([this](const auto&... elements) { (write(elements), ...); }, value);
+    } else if constexpr (std::is_aggregate_v<T>) {
+        detail::visitFields(value, [this](const auto&... fields) { (write(fields), ...); });
+    } else {
+        static_assert(detail::alwaysFalse<T>, "serial: no way to write this type");
+    }
+    return *this;
+}
+
+template <typename T>
+Reader& Reader::read(T& value) {
+    static_assert(!std::is_pointer_v<T> && !std::is_member_pointer_v<T>,
+                  "serial: a pointer's target would not be read; read what it points to");
+    static_assert(!std::is_const_v<T>, "serial: can't read into a const value");
+    if constexpr (detail::isBytes<T>) {
+        readBytes(&value, sizeof value);
+        if constexpr (std::is_same_v<T, bool>) {
+            // any other byte would make a bool that is neither true nor false
+            if (*reinterpret_cast<const unsigned char*>(&value) > 1)
+                throw std::runtime_error("serial: bool that is neither 0 nor 1");
+        }
+    } else if constexpr (std::is_integral_v<T>) {
+        if constexpr (std::is_signed_v<T>) {
+            const std::int64_t v = detail::unzigzag(readVarint());
+            if (v < std::numeric_limits<T>::min() || v > std::numeric_limits<T>::max())
+                throw std::runtime_error("serial: integer out of range for its type");
+            value = static_cast<T>(v);
+        } else {
+            const std::uint64_t v = readVarint();
+            if (v > std::numeric_limits<T>::max())
+                throw std::runtime_error("serial: integer out of range for its type");
+            value = static_cast<T>(v);
+        }
+    } else if constexpr (std::is_enum_v<T>) {
+        std::underlying_type_t<T> v;
+        read(v);
+        value = static_cast<T>(v);
+    } else if constexpr (std::ranges::sized_range<T>) {
+        static_assert(!std::ranges::view<T>, "serial: can't read into a view; read into a container that owns its elements");
+        using Element = std::ranges::range_value_t<T>;
+        using Stored = typename detail::Stored<Element>::type;
+        constexpr bool bulk = std::ranges::contiguous_range<T> && detail::isRaw<Element>;
+        if constexpr (bulk && requires { value.resize(std::size_t{}); }) {
+            const std::size_t n = readSize(sizeof(Element));
+            value.resize(n);
+            readBytes(std::ranges::data(value), n * sizeof(Element));
+        } else if constexpr (bulk) {
+            // fixed size, like std::array<int, 4>
+            if (readVarint() != std::ranges::size(value))
+                throw std::runtime_error("serial: wrong number of elements for a fixed-size range");
+            readBytes(std::ranges::data(value), std::ranges::size(value) * sizeof(Element));
+        } else if constexpr (requires(Stored element) { value.insert(value.end(), std::move(element)); }) {
+            const std::size_t n = readSize(1);
+            value.clear();
+            if constexpr (requires { value.reserve(n); }) value.reserve(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                Stored element{};
+                read(element);
+                value.insert(value.end(), std::move(element));
+            }
+        } else {
+            // fixed size, like std::array<std::string, 3>
+            if (readVarint() != std::ranges::size(value))
+                throw std::runtime_error("serial: wrong number of elements for a fixed-size range");
+            for (auto& element : value) read(element);
+        }
+    } else if constexpr (detail::isRaw<T>) {
+        readBytes(&value, sizeof value);
+    } else if constexpr (detail::TupleLike<T>) {
+        std::apply([this](auto&... elements) { (read(elements), ...); }, value);
+    } else if constexpr (std::is_aggregate_v<T>) {
+        detail::visitFields(value, [this](auto&... fields) { (read(fields), ...); });
+    } else {
+        static_assert(detail::alwaysFalse<T>, "serial: no way to read this type");
+    }
+    return *this;
+}
+
+template <typename T>
+std::string serialize(const T& value) {
+    Writer out;
+    out.write(value);
+    return std::string(out.view());
+}
+
+// throws std::runtime_error unless bytes hold exactly one T
+template <typename T>
+T deserialize(std::string_view bytes) {
+    Reader in(bytes);
+    T value{};
+    in.read(value);
+    if (!in.atEnd()) throw std::runtime_error("serial: bytes left over after the value");
+    return value;
+}
+
+} // namespace serial
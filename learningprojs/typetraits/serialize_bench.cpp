@@ -0,0 +1,123 @@
+// Writes and reads back a batch of Persons with serialize.h and with
+// iostreams (text through std::ostringstream / std::istringstream, one
+// field after another), and checks both read back what was written.
+//
+//   g++ -std=c++20 -O2 serialize_bench.cpp -o serialize_bench
+//   ./serialize_bench [persons, default 200000] [rounds, default 5]
+
+#include "records.h"
+#include "serialize.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// the fastest of rounds runs
+double secondsFor(int rounds, const std::function<void()>& f) {
+    double best = 1e9;
+    for (int i = 0; i < rounds; ++i) {
+        const auto start = Clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+std::vector<Person> makePersons(std::size_t count) {
+    std::mt19937 rng(42);
+    auto name = [&] {
+        std::string s(5 + rng() % 15, ' ');
+        for (char& c : s) c = static_cast<char>('a' + rng() % 26);
+        return s;
+    };
+    std::vector<Person> persons(count);
+    for (Person& p : persons) {
+        p.name = name();
+        p.age = static_cast<std::uint16_t>(rng() % 100);
+        p.height = 1.5 + (rng() % 500) / 1000.0;
+        p.avatar.resize(16);
+        for (pixel& px : p.avatar) px = {static_cast<unsigned char>(rng()), static_cast<unsigned char>(rng()),
+                                         static_cast<unsigned char>(rng())};
+        p.account.name = name();
+        p.account.values.resize(rng() % 10);
+        for (int& v : p.account.values) v = static_cast<int>(rng() % 100'000) - 50'000;
+    }
+    return persons;
+}
+
+void writeText(std::ostream& os, const Person& p) {
+    os << p.name << ' ' << p.age << ' ' << p.height << ' ' << p.avatar.size();
+    for (const pixel& px : p.avatar) os << ' ' << int(px.r) << ' ' << int(px.g) << ' ' << int(px.b);
+    os << ' ' << p.account.name << ' ' << p.account.values.size();
+    for (int v : p.account.values) os << ' ' << v;
+    os << '\n';
+}
+
+void readText(std::istream& is, Person& p) {
+    std::size_t n;
+    is >> p.name >> p.age >> p.height >> n;
+    p.avatar.resize(n);
+    for (pixel& px : p.avatar) {
+        int r, g, b;
+        is >> r >> g >> b;
+        px = {static_cast<unsigned char>(r), static_cast<unsigned char>(g), static_cast<unsigned char>(b)};
+    }
+    is >> p.account.name >> n;
+    p.account.values.resize(n);
+    for (int& v : p.account.values) is >> v;
+}
+
+void report(const char* name, double secs, std::size_t bytes, std::size_t count, double baseline) {
+    std::printf("%-24s %8.1f ms %8.1f MB %8.0f ns/person %7.1fx\n", name, secs * 1e3, bytes / 1e6,
+                secs * 1e9 / count, baseline / secs);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200'000;
+    const int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+    const std::vector<Person> persons = makePersons(count);
+    bool ok = true;
+
+    std::string text;
+    const double streamWrite = secondsFor(rounds, [&] {
+        std::ostringstream os;
+        os.precision(17); // so height reads back exactly, as it does from serial
+        for (const Person& p : persons) writeText(os, p);
+        text = std::move(os).str();
+    });
+    serial::Writer out;
+    const double serialWrite = secondsFor(rounds, [&] {
+        out.clear();
+        out << persons;
+    });
+
+    std::vector<Person> fromText(count);
+    const double streamRead = secondsFor(rounds, [&] {
+        std::istringstream is(text);
+        for (Person& p : fromText) readText(is, p);
+    });
+    ok = ok && fromText == persons;
+    std::vector<Person> fromSerial;
+    const double serialRead = secondsFor(rounds, [&] { serial::Reader(out.view()) >> fromSerial; });
+    ok = ok && fromSerial == persons;
+
+    std::printf("%zu persons, best of %d\n", count, rounds);
+    report("write ostringstream", streamWrite, text.size(), count, streamWrite);
+    report("write serial::Writer", serialWrite, out.size(), count, streamWrite);
+    report("read istringstream", streamRead, text.size(), count, streamRead);
+    report("read serial::Reader", serialRead, out.size(), count, streamRead);
+    std::printf("round trips %s\n", ok ? "match" : "DIFFER");
+    return ok ? 0 : 1;
+}
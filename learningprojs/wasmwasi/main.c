@@ -2,16 +2,7 @@
 #include<stdio.h>
 #include<stdlib.h>
 
-typedef enum {
-	INST_PUSH,
-	INST_ADD,
-	INST_PRINT
-} Inst_Type;
-
-typedef struct {
-	Inst_Type type;
-	int operand;
-} Inst; // single instruction
+#include "vm.h"
 
 Inst program[] = {
 	{.type = INST_PUSH, .operand = 35},
@@ -21,6 +12,20 @@ Inst program[] = {
 };
 
 int main() {
+	Vm_Program prepared;
+	size_t bad;
+	Vm_Status status = vm_prepare(program, sizeof(program) / sizeof(program[0]), &prepared, &bad);
+	if (status != VM_OK) {
+		fprintf(stderr, "instruction %zu: %s\n", bad, vm_status_name(status));
+		return 1;
+	}
+
+	static Vm vm;
+	vm_init(&vm);
+	status = vm_run(&vm, &prepared);
+	if (status != VM_OK) fprintf(stderr, "instruction %zu: %s\n", vm.pc, vm_status_name(status));
 
-	return 0;
+	vm_free(&vm);
+	vm_program_free(&prepared);
+	return status == VM_OK ? 0 : 1;
 }
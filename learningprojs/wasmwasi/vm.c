@@ -0,0 +1,162 @@
+#include "vm.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const inst_names[INST_COUNT] = {
+#define X(name, kind, kind2) #name,
+	INST_LIST(X)
+#undef X
+};
+
+static const Operand_Kind operand_kinds[INST_COUNT] = {
+#define X(name, kind, kind2) kind,
+	INST_LIST(X)
+#undef X
+};
+
+static const Operand_Kind operand2_kinds[INST_COUNT] = {
+#define X(name, kind, kind2) kind2,
+	INST_LIST(X)
+#undef X
+};
+
+const char *vm_inst_name(Inst_Type type)
+{
+	return (unsigned)type < INST_COUNT ? inst_names[type] : "?";
+}
+
+Operand_Kind vm_operand_kind(Inst_Type type)
+{
+	return (unsigned)type < INST_COUNT ? operand_kinds[type] : OPERAND_NONE;
+}
+
+Operand_Kind vm_operand2_kind(Inst_Type type)
+{
+	return (unsigned)type < INST_COUNT ? operand2_kinds[type] : OPERAND_NONE;
+}
+
+static int operand_ok(Operand_Kind kind, int operand, size_t count)
+{
+	switch (kind) {
+	case OPERAND_TARGET: return operand >= 0 && (size_t)operand <= count; // count: the appended HALT
+	case OPERAND_LOCAL: return operand >= 0 && operand < VM_FRAME_LOCALS;
+	default: return 1;
+	}
+}
+
+const char *vm_status_name(Vm_Status status)
+{
+	switch (status) {
+	case VM_OK: return "ok";
+	case VM_BAD_INST: return "bad instruction";
+	case VM_BAD_OPERAND: return "bad operand";
+	case VM_STACK_OVERFLOW: return "stack overflow";
+	case VM_STACK_UNDERFLOW: return "stack underflow";
+	case VM_CALL_OVERFLOW: return "call stack overflow";
+	case VM_DIV_BY_ZERO: return "division by zero";
+	case VM_BAD_ADDRESS: return "bad memory address";
+	}
+	return "?";
+}
+
+Vm_Status vm_prepare(const Inst *code, size_t count, Vm_Program *out, size_t *bad_index)
+{
+	out->code = NULL;
+	out->count = 0;
+	for (size_t i = 0; i < count; ++i) {
+		Vm_Status status = VM_OK;
+		if ((unsigned)code[i].type >= INST_COUNT) {
+			status = VM_BAD_INST;
+		} else if (!operand_ok(operand_kinds[code[i].type], code[i].operand, count) ||
+		           !operand_ok(operand2_kinds[code[i].type], code[i].operand2, count)) {
+			status = VM_BAD_OPERAND;
+		}
+		if (status != VM_OK) {
+			if (bad_index) *bad_index = i;
+			return status;
+		}
+	}
+
+	out->code = malloc((count + 1) * sizeof(Inst));
+	if (!out->code) return VM_BAD_INST;
+	memcpy(out->code, code, count * sizeof(Inst));
+	out->code[count] = (Inst){.type = INST_HALT};
+	out->count = count + 1;
+	return VM_OK;
+}
+
+void vm_program_free(Vm_Program *program)
+{
+	free(program->code);
+	program->code = NULL;
+	program->count = 0;
+}
+
+void vm_init(Vm *vm)
+{
+	memset(vm, 0, sizeof(*vm));
+	vm->memory = calloc(VM_MEMORY_MAX, sizeof(int64_t)); // LOADM/STOREM fail if NULL
+}
+
+void vm_free(Vm *vm)
+{
+	free(vm->memory);
+	vm->memory = NULL;
+}
+
+#if defined(__GNUC__) && !defined(VM_NO_COMPUTED_GOTO)
+
+// token threading: every handler ends in its own indirect jump, so the
+// branch predictor sees one jump per opcode instead of one shared switch
+#define VM_RUN_NAME vm_run_threaded
+#define OP(name) op_##name:
+#define DISPATCH do { ++executed; goto *labels[pc->type]; } while (0)
+#define DISPATCH_BEGIN                                   \
+	static void *const labels[INST_COUNT] = {            \
+		INST_LIST(VM_LABEL)                              \
+	};                                                   \
+	DISPATCH;
+#define VM_LABEL(name, kind, kind2) [INST_##name] = &&op_##name,
+#define DISPATCH_END
+
+#include "vm_interp.inc"
+
+#undef VM_RUN_NAME
+#undef OP
+#undef DISPATCH
+#undef DISPATCH_BEGIN
+#undef VM_LABEL
+#undef DISPATCH_END
+
+#define VM_HAVE_THREADED 1
+#endif
+
+#define VM_RUN_NAME vm_run_switched
+#define OP(name) case INST_##name:
+#define DISPATCH goto dispatch
+#define DISPATCH_BEGIN dispatch: ++executed; switch (pc->type) {
+#define DISPATCH_END default: FAIL(VM_BAD_INST); }
+
+#include "vm_interp.inc"
+
+#undef VM_RUN_NAME
+#undef OP
+#undef DISPATCH
+#undef DISPATCH_BEGIN
+#undef DISPATCH_END
+
+Vm_Status vm_run(Vm *vm, const Vm_Program *program)
+{
+#ifdef VM_HAVE_THREADED
+	return vm_run_threaded(vm, program);
+#else
+	return vm_run_switched(vm, program);
+#endif
+}
+
+Vm_Status vm_run_switch(Vm *vm, const Vm_Program *program)
+{
+	return vm_run_switched(vm, program);
+}
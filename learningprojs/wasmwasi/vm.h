@@ -0,0 +1,159 @@
+#ifndef VM_H
+#define VM_H
+
+// Stack machine for the Inst programs in main.c.
+//
+// Values are int64_t. Jump and call operands are instruction indices.
+// Each call gets a fresh window of VM_FRAME_LOCALS locals. Arguments travel
+// on the operand stack, and the callee STOREs them into locals.
+// LOADM/STOREM read and write a flat array of VM_MEMORY_MAX cells.
+//
+//   gcc -O2 main.c vm.c -o vm
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// X(name, operand kind, operand2 kind)
+#define INST_LIST(X)                                  \
+	X(PUSH, OPERAND_VALUE, OPERAND_NONE)              \
+	X(ADD, OPERAND_NONE, OPERAND_NONE)                \
+	X(PRINT, OPERAND_NONE, OPERAND_NONE)              \
+	X(SUB, OPERAND_NONE, OPERAND_NONE)                \
+	X(MUL, OPERAND_NONE, OPERAND_NONE)                \
+	X(DIV, OPERAND_NONE, OPERAND_NONE)                \
+	X(MOD, OPERAND_NONE, OPERAND_NONE)                \
+	X(EQ, OPERAND_NONE, OPERAND_NONE)                 \
+	X(NE, OPERAND_NONE, OPERAND_NONE)                 \
+	X(LT, OPERAND_NONE, OPERAND_NONE)                 \
+	X(LE, OPERAND_NONE, OPERAND_NONE)                 \
+	X(GT, OPERAND_NONE, OPERAND_NONE)                 \
+	X(GE, OPERAND_NONE, OPERAND_NONE)                 \
+	X(DUP, OPERAND_NONE, OPERAND_NONE)                \
+	X(DROP, OPERAND_NONE, OPERAND_NONE)               \
+	X(SWAP, OPERAND_NONE, OPERAND_NONE)               \
+	X(JMP, OPERAND_TARGET, OPERAND_NONE)              \
+	X(JZ, OPERAND_TARGET, OPERAND_NONE)               \
+	X(JNZ, OPERAND_TARGET, OPERAND_NONE)              \
+	X(LOAD, OPERAND_LOCAL, OPERAND_NONE)              \
+	X(STORE, OPERAND_LOCAL, OPERAND_NONE)             \
+	X(LOADM, OPERAND_NONE, OPERAND_NONE)              \
+	X(STOREM, OPERAND_NONE, OPERAND_NONE)             \
+	X(CALL, OPERAND_TARGET, OPERAND_NONE)             \
+	X(RET, OPERAND_NONE, OPERAND_NONE)                \
+	X(HALT, OPERAND_NONE, OPERAND_NONE)               \
+	/* superinstructions, produced by vm_optimize */  \
+	X(ADDI, OPERAND_VALUE, OPERAND_NONE)              \
+	X(MULI, OPERAND_VALUE, OPERAND_NONE)              \
+	X(ADDL, OPERAND_LOCAL, OPERAND_NONE)              \
+	X(LOAD2, OPERAND_LOCAL, OPERAND_LOCAL)            \
+	X(INCL, OPERAND_LOCAL, OPERAND_VALUE)             \
+	VM_BRANCHES(X, EQ)                                \
+	VM_BRANCHES(X, NE)                                \
+	VM_BRANCHES(X, LT)                                \
+	VM_BRANCHES(X, LE)                                \
+	VM_BRANCHES(X, GT)                                \
+	VM_BRANCHES(X, GE)
+
+// compare-and-branch, each popping a and jumping when `a cmp b`:
+//   BR_cmp  target      b popped from the stack
+//   BRI_cmp k, target   b = k
+//   BRL_cmp n, target   b = locals[n]
+#define VM_BRANCHES(X, cmp)                           \
+	X(BR_##cmp, OPERAND_TARGET, OPERAND_NONE)         \
+	X(BRI_##cmp, OPERAND_VALUE, OPERAND_TARGET)       \
+	X(BRL_##cmp, OPERAND_LOCAL, OPERAND_TARGET)
+
+typedef enum {
+#define X(name, kind, kind2) INST_##name,
+	INST_LIST(X)
+#undef X
+	INST_COUNT
+} Inst_Type;
+
+typedef enum {
+	OPERAND_NONE,
+	OPERAND_VALUE,
+	OPERAND_TARGET,
+	OPERAND_LOCAL
+} Operand_Kind;
+
+typedef struct {
+	Inst_Type type;
+	int operand;
+	int operand2; // only used by superinstructions
+} Inst; // single instruction
+
+typedef enum {
+	VM_OK,
+	VM_BAD_INST,
+	VM_BAD_OPERAND,
+	VM_STACK_OVERFLOW,
+	VM_STACK_UNDERFLOW,
+	VM_CALL_OVERFLOW,
+	VM_DIV_BY_ZERO,
+	VM_BAD_ADDRESS
+} Vm_Status;
+
+#define VM_STACK_MAX 1024
+#define VM_CALL_MAX 1024
+#define VM_FRAME_LOCALS 16
+#define VM_MEMORY_MAX (1 << 20)
+
+// A validated program: every opcode and local index is in range, every jump
+// target is inside the code, and the code ends in HALT, so the interpreter
+// needs no bounds checks on pc.
+typedef struct {
+	Inst *code;
+	size_t count;
+} Vm_Program;
+
+typedef struct {
+	// stack[1..depth] after a run; stack[0] is scratch for the cached top
+	int64_t stack[VM_STACK_MAX + 1];
+	size_t depth;
+	int64_t locals[VM_CALL_MAX * VM_FRAME_LOCALS];
+	int64_t *memory;   // VM_MEMORY_MAX cells, allocated by vm_init
+	uint64_t executed; // instructions dispatched by the last run
+	size_t pc;         // where the last run stopped
+	FILE *out;         // PRINT target, stdout if NULL
+} Vm;
+
+const char *vm_inst_name(Inst_Type type);
+Operand_Kind vm_operand_kind(Inst_Type type);
+Operand_Kind vm_operand2_kind(Inst_Type type);
+const char *vm_status_name(Vm_Status status);
+
+// copies and validates; on failure *bad_index is the offending instruction
+Vm_Status vm_prepare(const Inst *code, size_t count, Vm_Program *out, size_t *bad_index);
+void vm_program_free(Vm_Program *program);
+
+void vm_init(Vm *vm);
+void vm_free(Vm *vm);
+
+// runs from instruction 0 until HALT or a RET with no caller
+Vm_Status vm_run(Vm *vm, const Vm_Program *program);
+// the same with a plain switch loop, for comparison
+Vm_Status vm_run_switch(Vm *vm, const Vm_Program *program);
+
+// Peephole pass over a prepared program, writing a new prepared program.
+//   VM_OPT_FOLD  constant folding, dead push elimination, jumps to the next
+//                instruction and constant conditional jumps
+//   VM_OPT_FUSE  fusion of common sequences into the superinstructions above
+// Nothing is rewritten across a jump target. The result computes the same
+// values as the input, but it can get past a stack overflow or underflow
+// the input would hit (PUSH 0; ADD on an empty stack is simply removed).
+enum { VM_OPT_FOLD = 1, VM_OPT_FUSE = 2, VM_OPT_ALL = 3 };
+Vm_Status vm_optimize(const Vm_Program *in, Vm_Program *out, unsigned flags);
+
+// x86-64 template JIT. Returns NULL when the program uses an instruction
+// without a template (PRINT) or on other targets; run the interpreter then.
+// vm_jit_run leaves executed at 0 and otherwise updates vm like vm_run.
+typedef struct Vm_Jit Vm_Jit;
+Vm_Jit *vm_jit_compile(const Vm_Program *program);
+Vm_Status vm_jit_run(Vm *vm, const Vm_Jit *jit);
+void vm_jit_free(Vm_Jit *jit);
+
+static inline int64_t vm_top(const Vm *vm) { return vm->depth ? vm->stack[vm->depth] : 0; }
+
+#endif
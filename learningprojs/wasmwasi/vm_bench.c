@@ -0,0 +1,237 @@
+// Runs fib, a counting loop and a sieve on the Inst VM and reports
+// instructions per second for each dispatch strategy, and how much
+// vm_optimize cuts the number of dispatches and the run time. The jit rows
+// run compiled code, which dispatches nothing; their Minstr/s is in
+// interpreter instructions of the same program.
+//
+//   gcc -O2 vm_bench.c vm.c vm_opt.c vm_jit.c -o vm_bench && ./vm_bench
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "vm.h"
+
+#define ARG (-0x7fff0000) // replaced with the benchmark's parameter
+#define I(t, ...) {.type = INST_##t, __VA_ARGS__}
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+// fib(n), recursively
+static const Inst fib_code[] = {
+	/*  0 */ I(PUSH, .operand = ARG),
+	/*  1 */ I(CALL, .operand = 3),
+	/*  2 */ I(HALT),
+	/*  3 */ I(STORE, .operand = 0),
+	/*  4 */ I(LOAD, .operand = 0),
+	/*  5 */ I(PUSH, .operand = 2),
+	/*  6 */ I(LT),
+	/*  7 */ I(JZ, .operand = 10),
+	/*  8 */ I(LOAD, .operand = 0),
+	/*  9 */ I(RET),
+	/* 10 */ I(LOAD, .operand = 0),
+	/* 11 */ I(PUSH, .operand = 1),
+	/* 12 */ I(SUB),
+	/* 13 */ I(CALL, .operand = 3),
+	/* 14 */ I(LOAD, .operand = 0),
+	/* 15 */ I(PUSH, .operand = 2),
+	/* 16 */ I(SUB),
+	/* 17 */ I(CALL, .operand = 3),
+	/* 18 */ I(ADD),
+	/* 19 */ I(RET),
+};
+
+// sum of 0..n-1; locals: 0 = i, 1 = sum
+static const Inst loop_code[] = {
+	/*  0 */ I(PUSH, .operand = 0),
+	/*  1 */ I(STORE, .operand = 0),
+	/*  2 */ I(PUSH, .operand = 0),
+	/*  3 */ I(STORE, .operand = 1),
+	/*  4 */ I(LOAD, .operand = 0),
+	/*  5 */ I(PUSH, .operand = ARG),
+	/*  6 */ I(LT),
+	/*  7 */ I(JZ, .operand = 17),
+	/*  8 */ I(LOAD, .operand = 1),
+	/*  9 */ I(LOAD, .operand = 0),
+	/* 10 */ I(ADD),
+	/* 11 */ I(STORE, .operand = 1),
+	/* 12 */ I(LOAD, .operand = 0),
+	/* 13 */ I(PUSH, .operand = 1),
+	/* 14 */ I(ADD),
+	/* 15 */ I(STORE, .operand = 0),
+	/* 16 */ I(JMP, .operand = 4),
+	/* 17 */ I(LOAD, .operand = 1),
+};
+
+// number of primes below n, marking composites in memory[];
+// locals: 0 = i, 1 = j, 2 = count
+static const Inst sieve_code[] = {
+	/*  0 */ I(PUSH, .operand = 2),
+	/*  1 */ I(STORE, .operand = 0),
+	/*  2 */ I(PUSH, .operand = 0),
+	/*  3 */ I(STORE, .operand = 2),
+	/*  4 */ I(LOAD, .operand = 0),
+	/*  5 */ I(PUSH, .operand = ARG),
+	/*  6 */ I(LT),
+	/*  7 */ I(JZ, .operand = 36),
+	/*  8 */ I(LOAD, .operand = 0),
+	/*  9 */ I(LOADM),
+	/* 10 */ I(JNZ, .operand = 31),
+	/* 11 */ I(LOAD, .operand = 2),
+	/* 12 */ I(PUSH, .operand = 1),
+	/* 13 */ I(ADD),
+	/* 14 */ I(STORE, .operand = 2),
+	/* 15 */ I(LOAD, .operand = 0),
+	/* 16 */ I(LOAD, .operand = 0),
+	/* 17 */ I(MUL),
+	/* 18 */ I(STORE, .operand = 1),
+	/* 19 */ I(LOAD, .operand = 1),
+	/* 20 */ I(PUSH, .operand = ARG),
+	/* 21 */ I(LT),
+	/* 22 */ I(JZ, .operand = 31),
+	/* 23 */ I(LOAD, .operand = 1),
+	/* 24 */ I(PUSH, .operand = 1),
+	/* 25 */ I(STOREM),
+	/* 26 */ I(LOAD, .operand = 1),
+	/* 27 */ I(LOAD, .operand = 0),
+	/* 28 */ I(ADD),
+	/* 29 */ I(STORE, .operand = 1),
+	/* 30 */ I(JMP, .operand = 19),
+	/* 31 */ I(LOAD, .operand = 0),
+	/* 32 */ I(PUSH, .operand = 1),
+	/* 33 */ I(ADD),
+	/* 34 */ I(STORE, .operand = 0),
+	/* 35 */ I(JMP, .operand = 4),
+	/* 36 */ I(LOAD, .operand = 2),
+};
+
+static int64_t fib_expected(int n)
+{
+	int64_t a = 0, b = 1;
+	for (int i = 0; i < n; ++i) {
+		int64_t t = a + b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+static int64_t loop_expected(int n) { return (int64_t)n * (n - 1) / 2; }
+
+static int64_t sieve_expected(int n)
+{
+	char *composite = calloc((size_t)n, 1);
+	int64_t count = 0;
+	for (int64_t i = 2; i < n; ++i) {
+		if (composite[i]) continue;
+		++count;
+		for (int64_t j = i * i; j < n; j += i) composite[j] = 1;
+	}
+	free(composite);
+	return count;
+}
+
+typedef struct {
+	const char *name;
+	const Inst *code;
+	size_t count;
+	int arg;
+	int64_t (*expected)(int);
+	int uses_memory; // memory[0..arg) is cleared before each run
+} Benchmark;
+
+typedef struct {
+	const char *name;
+	Vm_Status (*run)(Vm *, const Vm_Program *);
+	unsigned optimize; // VM_OPT_* flags, 0 for the program as written
+	int jit;
+} Engine;
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static Vm vm;
+
+int main(int argc, char **argv)
+{
+	const int reps = argc > 1 ? atoi(argv[1]) : 5;
+	const Benchmark benchmarks[] = {
+		{"fib", fib_code, COUNT(fib_code), 27, fib_expected, 0},
+		{"loop", loop_code, COUNT(loop_code), 10000000, loop_expected, 0},
+		{"sieve", sieve_code, COUNT(sieve_code), 1000000, sieve_expected, 1},
+	};
+	const Engine engines[] = {
+		{"threaded", vm_run, 0, 0},
+		{"switch", vm_run_switch, 0, 0},
+		{"+fold", vm_run, VM_OPT_FOLD, 0},
+		{"+fuse", vm_run, VM_OPT_FUSE, 0},
+		{"+both", vm_run, VM_OPT_ALL, 0},
+		{"jit", NULL, 0, 1},
+		{"jit+both", NULL, VM_OPT_ALL, 1},
+	};
+
+	vm_init(&vm);
+	printf("%-8s %-10s %5s %14s %10s %12s %9s\n", "program", "engine", "size", "dispatches", "ms/run", "Minstr/s",
+	       "speedup");
+	for (size_t b = 0; b < COUNT(benchmarks); ++b) {
+		const Benchmark *bench = &benchmarks[b];
+		Inst code[64];
+		memcpy(code, bench->code, bench->count * sizeof(Inst));
+		for (size_t i = 0; i < bench->count; ++i)
+			if (code[i].operand == ARG) code[i].operand = bench->arg;
+
+		Vm_Program program;
+		size_t bad;
+		Vm_Status status = vm_prepare(code, bench->count, &program, &bad);
+		if (status != VM_OK) {
+			fprintf(stderr, "%s: instruction %zu: %s\n", bench->name, bad, vm_status_name(status));
+			return 1;
+		}
+		const int64_t expected = bench->expected(bench->arg);
+
+		double baseline = 0;
+		uint64_t instructions = 0; // dispatches of the program as written
+		for (size_t e = 0; e < COUNT(engines); ++e) {
+			Vm_Program optimized = program;
+			if (engines[e].optimize) vm_optimize(&program, &optimized, engines[e].optimize);
+			Vm_Jit *jit = engines[e].jit ? vm_jit_compile(&optimized) : NULL;
+
+			if (engines[e].jit && !jit) {
+				printf("%-8s %-10s not compiled on this target\n", bench->name, engines[e].name);
+			} else {
+				double best = 1e30;
+				for (int r = -1; r < reps; ++r) { // r == -1 warms caches and memory pages
+					if (bench->uses_memory) memset(vm.memory, 0, (size_t)bench->arg * sizeof(int64_t));
+					double start = now_seconds();
+					status = jit ? vm_jit_run(&vm, jit) : engines[e].run(&vm, &optimized);
+					double elapsed = now_seconds() - start;
+					if (r >= 0 && elapsed < best) best = elapsed;
+					if (status != VM_OK || vm_top(&vm) != expected) {
+						fprintf(stderr, "%s/%s: %s, got %" PRId64 " expected %" PRId64 "\n", bench->name,
+						        engines[e].name, vm_status_name(status), vm_top(&vm), expected);
+						return 1;
+					}
+				}
+				if (e == 0) {
+					baseline = best;
+					instructions = vm.executed;
+				}
+				const uint64_t counted = jit ? instructions : vm.executed;
+				printf("%-8s %-10s %5zu %14" PRIu64 " %10.2f %12.1f %8.2fx\n", bench->name, engines[e].name,
+				       optimized.count, vm.executed, best * 1e3, (double)counted / best * 1e-6, baseline / best);
+			}
+			vm_jit_free(jit);
+			if (engines[e].optimize) vm_program_free(&optimized);
+		}
+		vm_program_free(&program);
+	}
+	vm_free(&vm);
+	return 0;
+}
@@ -0,0 +1,516 @@
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS
+
+#include "vm.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Template JIT for x86-64. Every opcode has a fixed machine-code template
+// (the byte strings below). Compiling copies those templates back to back
+// and patches in operands and branch offsets. The VM state lives in
+// registers the whole time:
+//
+//   rbx  sp        r12  tos          r13  locals of the current frame
+//   r14  memory    r15  call depth   rbp  Jit_Context
+//   r8   stack + 1 (lowest sp with one element)
+//   r11  stack + 2 (lowest sp with two elements)
+//   r9   stack end        r10  memory size
+//
+// VM CALL/RET become native call/ret. Failed checks jump to a per-site stub
+// that loads the status and instruction index and leaves through one exit.
+// Programs that PRINT are not compiled: vm_jit_compile returns NULL and
+// the caller runs the interpreter instead.
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__)) && !defined(VM_NO_JIT)
+
+#include <stddef.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+typedef struct {
+	int64_t *sp;
+	int64_t tos;
+	int64_t *locals;
+	int64_t *memory;
+	uint64_t memory_size;
+	int64_t *need1;
+	int64_t *need2;
+	int64_t *stack_end;
+	void *saved_rsp;
+	int32_t pc;
+} Jit_Context;
+
+struct Vm_Jit {
+	uint8_t *code;
+	size_t size;
+};
+
+typedef struct {
+	size_t at;     // offset of the rel32
+	int to_stub;   // else to an instruction
+	size_t target; // stub or instruction index
+} Fixup;
+
+typedef struct {
+	Vm_Status status;
+	size_t pc;
+} Stub;
+
+typedef struct {
+	uint8_t *buf;
+	size_t len, cap;
+	Fixup *fixups;
+	size_t nfixups, fixups_cap;
+	Stub *stubs;
+	size_t nstubs, stubs_cap;
+	int failed; // out of memory
+} Asm;
+
+static void *grow(void *p, size_t *cap, size_t need, size_t elem)
+{
+	if (need <= *cap) return p;
+	size_t n = *cap ? *cap * 2 : 256;
+	while (n < need) n *= 2;
+	void *q = realloc(p, n * elem);
+	if (q) *cap = n;
+	return q;
+}
+
+static void emit(Asm *a, const void *bytes, size_t n)
+{
+	uint8_t *b = grow(a->buf, &a->cap, a->len + n, 1);
+	if (!b) {
+		a->failed = 1;
+		return;
+	}
+	a->buf = b;
+	memcpy(a->buf + a->len, bytes, n);
+	a->len += n;
+}
+
+#define T(a, bytes) emit(a, bytes, sizeof(bytes) - 1)
+
+static void emit32(Asm *a, int32_t v) { emit(a, &v, 4); }
+
+static void fixup(Asm *a, int to_stub, size_t target)
+{
+	Fixup *f = grow(a->fixups, &a->fixups_cap, a->nfixups + 1, sizeof(Fixup));
+	if (!f) {
+		a->failed = 1;
+		return;
+	}
+	a->fixups = f;
+	a->fixups[a->nfixups++] = (Fixup){a->len, to_stub, target};
+	emit32(a, 0);
+}
+
+// jcc (or jmp when cc is 0) to a new stub that exits with status at pc
+static void fail_if(Asm *a, uint8_t cc, Vm_Status status, size_t pc)
+{
+	Stub *s = grow(a->stubs, &a->stubs_cap, a->nstubs + 1, sizeof(Stub));
+	if (!s) {
+		a->failed = 1;
+		return;
+	}
+	a->stubs = s;
+	a->stubs[a->nstubs] = (Stub){status, pc};
+	if (cc) {
+		const uint8_t op[2] = {0x0f, cc};
+		emit(a, op, 2);
+	} else {
+		T(a, "\xe9");
+	}
+	fixup(a, 1, a->nstubs++);
+}
+
+static void branch(Asm *a, uint8_t cc, size_t target)
+{
+	if (cc) {
+		const uint8_t op[2] = {0x0f, cc};
+		emit(a, op, 2);
+	} else {
+		T(a, "\xe9");
+	}
+	fixup(a, 0, target);
+}
+
+enum { JB = 0x82, JAE = 0x83, JE = 0x84, JNE = 0x85 };
+
+// setcc / jcc condition for each compare, EQ..GE order
+static const uint8_t compare_cc[] = {0x4, 0x5, 0xc, 0xe, 0xf, 0xd};
+
+static void need1(Asm *a, size_t pc)
+{
+	T(a, "\x4c\x39\xc3"); // cmp rbx, r8
+	fail_if(a, JB, VM_STACK_UNDERFLOW, pc);
+}
+
+static void need2(Asm *a, size_t pc)
+{
+	T(a, "\x4c\x39\xdb"); // cmp rbx, r11
+	fail_if(a, JB, VM_STACK_UNDERFLOW, pc);
+}
+
+static void room(Asm *a, size_t pc)
+{
+	T(a, "\x4c\x39\xcb"); // cmp rbx, r9
+	fail_if(a, JAE, VM_STACK_OVERFLOW, pc);
+}
+
+static void spill_tos(Asm *a)
+{
+	T(a, "\x4c\x89\x23"); // mov [rbx], r12
+	T(a, "\x48\x83\xc3\x08"); // add rbx, 8
+}
+
+static void pop_tos(Asm *a)
+{
+	T(a, "\x48\x83\xeb\x08"); // sub rbx, 8
+	T(a, "\x4c\x8b\x23"); // mov r12, [rbx]
+}
+
+static void local_disp(Asm *a, int local) { emit32(a, local * (int32_t)sizeof(int64_t)); }
+
+static int compile_inst(Asm *a, const Inst *in, size_t pc)
+{
+	const Inst_Type type = in->type;
+	if (type >= INST_BR_EQ && type <= INST_BRL_GE) {
+		const int kind = (type - INST_BR_EQ) % 3; // BR_, BRI_, BRL_
+		const uint8_t cc = 0x80 | compare_cc[(type - INST_BR_EQ) / 3];
+		if (kind == 0) {
+			need2(a, pc);
+			T(a, "\x4c\x39\x63\xf8"); // cmp [rbx-8], r12
+			T(a, "\x4c\x8b\x63\xf0"); // mov r12, [rbx-16]
+			T(a, "\x48\x8d\x5b\xf0"); // lea rbx, [rbx-16]
+			branch(a, cc, (size_t)in->operand);
+			return 1;
+		}
+		need1(a, pc);
+		if (kind == 1) {
+			T(a, "\x49\x81\xfc"); // cmp r12, imm32
+			emit32(a, in->operand);
+		} else {
+			T(a, "\x4d\x3b\xa5"); // cmp r12, [r13+disp32]
+			local_disp(a, in->operand);
+		}
+		T(a, "\x4c\x8b\x63\xf8"); // mov r12, [rbx-8]
+		T(a, "\x48\x8d\x5b\xf8"); // lea rbx, [rbx-8]
+		branch(a, cc, (size_t)in->operand2);
+		return 1;
+	}
+
+	switch (type) {
+	case INST_PUSH:
+		room(a, pc);
+		spill_tos(a);
+		T(a, "\x49\xc7\xc4"); // mov r12, imm32
+		emit32(a, in->operand);
+		return 1;
+	case INST_ADD:
+		need2(a, pc);
+		T(a, "\x48\x83\xeb\x08"); // sub rbx, 8
+		T(a, "\x4c\x03\x23"); // add r12, [rbx]
+		return 1;
+	case INST_SUB:
+		need2(a, pc);
+		T(a, "\x48\x83\xeb\x08"); // sub rbx, 8
+		T(a, "\x48\x8b\x03"); // mov rax, [rbx]
+		T(a, "\x4c\x29\xe0"); // sub rax, r12
+		T(a, "\x49\x89\xc4"); // mov r12, rax
+		return 1;
+	case INST_MUL:
+		need2(a, pc);
+		T(a, "\x48\x83\xeb\x08"); // sub rbx, 8
+		T(a, "\x4c\x0f\xaf\x23"); // imul r12, [rbx]
+		return 1;
+	case INST_DIV:
+	case INST_MOD:
+		need2(a, pc);
+		T(a, "\x4d\x85\xe4"); // test r12, r12
+		fail_if(a, JE, VM_DIV_BY_ZERO, pc);
+		T(a, "\x48\x83\xeb\x08"); // sub rbx, 8
+		T(a, "\x48\x8b\x03"); // mov rax, [rbx]
+		T(a, "\x49\x83\xfc\xff"); // cmp r12, -1 (idiv would trap on INT64_MIN / -1)
+		if (type == INST_DIV) {
+			T(a, "\x75\x05"); // jne 1f
+			T(a, "\x48\xf7\xd8"); // neg rax
+			T(a, "\xeb\x05"); // jmp 2f
+			T(a, "\x48\x99"); // 1: cqo
+			T(a, "\x49\xf7\xfc"); // idiv r12
+			T(a, "\x49\x89\xc4"); // 2: mov r12, rax
+		} else {
+			T(a, "\x75\x04"); // jne 1f
+			T(a, "\x31\xd2"); // xor edx, edx
+			T(a, "\xeb\x05"); // jmp 2f
+			T(a, "\x48\x99"); // 1: cqo
+			T(a, "\x49\xf7\xfc"); // idiv r12
+			T(a, "\x49\x89\xd4"); // 2: mov r12, rdx
+		}
+		return 1;
+	case INST_EQ:
+	case INST_NE:
+	case INST_LT:
+	case INST_LE:
+	case INST_GT:
+	case INST_GE: {
+		need2(a, pc);
+		T(a, "\x48\x83\xeb\x08"); // sub rbx, 8
+		T(a, "\x4c\x39\x23"); // cmp [rbx], r12
+		const uint8_t setcc[3] = {0x0f, (uint8_t)(0x90 | compare_cc[type - INST_EQ]), 0xc0};
+		emit(a, setcc, 3); // setcc al
+		T(a, "\x0f\xb6\xc0"); // movzx eax, al
+		T(a, "\x49\x89\xc4"); // mov r12, rax
+		return 1;
+	}
+	case INST_DUP:
+		need1(a, pc);
+		room(a, pc);
+		spill_tos(a);
+		return 1;
+	case INST_DROP:
+		need1(a, pc);
+		pop_tos(a);
+		return 1;
+	case INST_SWAP:
+		need2(a, pc);
+		T(a, "\x48\x8b\x43\xf8"); // mov rax, [rbx-8]
+		T(a, "\x4c\x89\x63\xf8"); // mov [rbx-8], r12
+		T(a, "\x49\x89\xc4"); // mov r12, rax
+		return 1;
+	case INST_JMP:
+		branch(a, 0, (size_t)in->operand);
+		return 1;
+	case INST_JZ:
+	case INST_JNZ:
+		need1(a, pc);
+		T(a, "\x4c\x89\xe0"); // mov rax, r12
+		pop_tos(a);
+		T(a, "\x48\x85\xc0"); // test rax, rax
+		branch(a, type == INST_JZ ? JE : JNE, (size_t)in->operand);
+		return 1;
+	case INST_LOAD:
+		room(a, pc);
+		spill_tos(a);
+		T(a, "\x4d\x8b\xa5"); // mov r12, [r13+disp32]
+		local_disp(a, in->operand);
+		return 1;
+	case INST_STORE:
+		need1(a, pc);
+		T(a, "\x4d\x89\xa5"); // mov [r13+disp32], r12
+		local_disp(a, in->operand);
+		pop_tos(a);
+		return 1;
+	case INST_LOADM:
+		need1(a, pc);
+		T(a, "\x4d\x39\xd4"); // cmp r12, r10
+		fail_if(a, JAE, VM_BAD_ADDRESS, pc);
+		T(a, "\x4f\x8b\x24\xe6"); // mov r12, [r14+r12*8]
+		return 1;
+	case INST_STOREM:
+		need2(a, pc);
+		T(a, "\x48\x8b\x43\xf8"); // mov rax, [rbx-8]
+		T(a, "\x4c\x39\xd0"); // cmp rax, r10
+		fail_if(a, JAE, VM_BAD_ADDRESS, pc);
+		T(a, "\x4d\x89\x24\xc6"); // mov [r14+rax*8], r12
+		T(a, "\x48\x83\xeb\x10"); // sub rbx, 16
+		T(a, "\x4c\x8b\x23"); // mov r12, [rbx]
+		return 1;
+	case INST_CALL:
+		T(a, "\x49\x81\xff"); // cmp r15, VM_CALL_MAX - 1
+		emit32(a, VM_CALL_MAX - 1);
+		fail_if(a, JAE, VM_CALL_OVERFLOW, pc);
+		T(a, "\x49\xff\xc7"); // inc r15
+		T(a, "\x49\x81\xc5"); // add r13, frame size
+		emit32(a, VM_FRAME_LOCALS * (int32_t)sizeof(int64_t));
+		T(a, "\xe8"); // call target
+		fixup(a, 0, (size_t)in->operand);
+		return 1;
+	case INST_RET:
+		T(a, "\x4d\x85\xff"); // test r15, r15
+		fail_if(a, JE, VM_OK, pc); // returning from the entry frame ends the run
+		T(a, "\x49\xff\xcf"); // dec r15
+		T(a, "\x49\x81\xed"); // sub r13, frame size
+		emit32(a, VM_FRAME_LOCALS * (int32_t)sizeof(int64_t));
+		T(a, "\xc3"); // ret
+		return 1;
+	case INST_HALT:
+		fail_if(a, 0, VM_OK, pc);
+		return 1;
+	case INST_ADDI:
+		need1(a, pc);
+		T(a, "\x49\x81\xc4"); // add r12, imm32
+		emit32(a, in->operand);
+		return 1;
+	case INST_MULI:
+		need1(a, pc);
+		T(a, "\x4d\x69\xe4"); // imul r12, r12, imm32
+		emit32(a, in->operand);
+		return 1;
+	case INST_ADDL:
+		need1(a, pc);
+		T(a, "\x4d\x03\xa5"); // add r12, [r13+disp32]
+		local_disp(a, in->operand);
+		return 1;
+	case INST_LOAD2:
+		T(a, "\x48\x8d\x43\x08"); // lea rax, [rbx+8]
+		T(a, "\x4c\x39\xc8"); // cmp rax, r9
+		fail_if(a, JAE, VM_STACK_OVERFLOW, pc);
+		T(a, "\x4c\x89\x23"); // mov [rbx], r12
+		T(a, "\x49\x8b\x85"); // mov rax, [r13+disp32]
+		local_disp(a, in->operand);
+		T(a, "\x48\x89\x43\x08"); // mov [rbx+8], rax
+		T(a, "\x48\x83\xc3\x10"); // add rbx, 16
+		T(a, "\x4d\x8b\xa5"); // mov r12, [r13+disp32]
+		local_disp(a, in->operand2);
+		return 1;
+	case INST_INCL:
+		T(a, "\x49\x81\x85"); // add qword [r13+disp32], imm32
+		local_disp(a, in->operand);
+		emit32(a, in->operand2);
+		return 1;
+	default:
+		return 0; // PRINT: needs stdio, left to the interpreter
+	}
+}
+
+Vm_Jit *vm_jit_compile(const Vm_Program *program)
+{
+	Asm a = {0};
+	size_t *offsets = malloc(program->count * sizeof(size_t));
+	Vm_Jit *jit = NULL;
+	if (!offsets) return NULL;
+
+	// prologue: save callee-saved registers, load the VM state
+	T(&a, "\x53\x55\x41\x54\x41\x55\x41\x56\x41\x57"); // push rbx, rbp, r12-r15
+	T(&a, "\x48\x89\xfd"); // mov rbp, rdi
+#define CTX(bytes, field) do { T(&a, bytes); const uint8_t d = offsetof(Jit_Context, field); emit(&a, &d, 1); } while (0)
+	CTX("\x48\x89\x65", saved_rsp); // mov [rbp+d], rsp
+	CTX("\x48\x8b\x5d", sp);        // mov rbx, [rbp+d]
+	CTX("\x4c\x8b\x65", tos);       // mov r12, [rbp+d]
+	CTX("\x4c\x8b\x6d", locals);    // mov r13, [rbp+d]
+	CTX("\x4c\x8b\x75", memory);    // mov r14, [rbp+d]
+	CTX("\x4c\x8b\x45", need1);     // mov r8, [rbp+d]
+	CTX("\x4c\x8b\x4d", stack_end); // mov r9, [rbp+d]
+	CTX("\x4c\x8b\x55", memory_size); // mov r10, [rbp+d]
+	CTX("\x4c\x8b\x5d", need2);     // mov r11, [rbp+d]
+	T(&a, "\x45\x31\xff"); // xor r15d, r15d
+
+	int ok = 1;
+	for (size_t i = 0; i < program->count && ok; ++i) {
+		offsets[i] = a.len;
+		ok = compile_inst(&a, &program->code[i], i);
+	}
+	if (!ok || a.failed) goto out;
+
+	// stubs: mov eax, status; mov edx, pc; jmp exit
+	size_t *stub_offsets = malloc((a.nstubs ? a.nstubs : 1) * sizeof(size_t));
+	if (!stub_offsets) goto out;
+	size_t exit_fixups_start = a.len;
+	for (size_t i = 0; i < a.nstubs; ++i) {
+		stub_offsets[i] = a.len;
+		T(&a, "\xb8");
+		emit32(&a, (int32_t)a.stubs[i].status);
+		T(&a, "\xba");
+		emit32(&a, (int32_t)a.stubs[i].pc);
+		T(&a, "\xe9");
+		emit32(&a, 0); // patched below
+	}
+
+	// exit: unwind any VM calls, store the state back, restore registers
+	const size_t exit_at = a.len;
+	CTX("\x48\x8b\x65", saved_rsp); // mov rsp, [rbp+d]
+	CTX("\x48\x89\x5d", sp);        // mov [rbp+d], rbx
+	CTX("\x4c\x89\x65", tos);       // mov [rbp+d], r12
+	CTX("\x89\x55", pc);            // mov [rbp+d], edx
+	T(&a, "\x41\x5f\x41\x5e\x41\x5d\x41\x5c\x5d\x5b\xc3"); // pop r15-r12, rbp, rbx; ret
+#undef CTX
+	if (a.failed) {
+		free(stub_offsets);
+		goto out;
+	}
+
+	for (size_t i = 0; i < a.nstubs; ++i) {
+		const size_t at = exit_fixups_start + i * 15 + 11;
+		const int32_t rel = (int32_t)(exit_at - (at + 4));
+		memcpy(a.buf + at, &rel, 4);
+	}
+	for (size_t i = 0; i < a.nfixups; ++i) {
+		const Fixup *f = &a.fixups[i];
+		const size_t dest = f->to_stub ? stub_offsets[f->target] : offsets[f->target];
+		const int32_t rel = (int32_t)(dest - (f->at + 4));
+		memcpy(a.buf + f->at, &rel, 4);
+	}
+	free(stub_offsets);
+
+	const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t size = (a.len + page - 1) / page * page;
+	void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED) goto out;
+	memcpy(mem, a.buf, a.len);
+	if (mprotect(mem, size, PROT_READ | PROT_EXEC) != 0 || !(jit = malloc(sizeof(*jit)))) {
+		munmap(mem, size);
+		goto out;
+	}
+	jit->code = mem;
+	jit->size = size;
+
+out:
+	free(offsets);
+	free(a.buf);
+	free(a.fixups);
+	free(a.stubs);
+	return jit;
+}
+
+void vm_jit_free(Vm_Jit *jit)
+{
+	if (!jit) return;
+	munmap(jit->code, jit->size);
+	free(jit);
+}
+
+Vm_Status vm_jit_run(Vm *vm, const Vm_Jit *jit)
+{
+	Jit_Context ctx = {
+		.sp = vm->stack,
+		.tos = 0,
+		.locals = vm->locals,
+		.memory = vm->memory,
+		.memory_size = vm->memory ? VM_MEMORY_MAX : 0,
+		.need1 = vm->stack + 1,
+		.need2 = vm->stack + 2,
+		.stack_end = vm->stack + VM_STACK_MAX,
+	};
+	int (*entry)(Jit_Context *);
+	memcpy(&entry, &jit->code, sizeof(entry)); // object to function pointer
+	const Vm_Status status = (Vm_Status)entry(&ctx);
+
+	vm->depth = (size_t)(ctx.sp - vm->stack);
+	vm->stack[vm->depth] = ctx.tos;
+	vm->executed = 0; // not counted by compiled code
+	vm->pc = (size_t)ctx.pc;
+	return status;
+}
+
+#else
+
+struct Vm_Jit {
+	int unused;
+};
+
+Vm_Jit *vm_jit_compile(const Vm_Program *program)
+{
+	(void)program;
+	return NULL;
+}
+
+void vm_jit_free(Vm_Jit *jit) { (void)jit; }
+
+Vm_Status vm_jit_run(Vm *vm, const Vm_Jit *jit)
+{
+	(void)vm;
+	(void)jit;
+	return VM_BAD_INST;
+}
+
+#endif
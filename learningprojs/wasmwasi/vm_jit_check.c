@@ -0,0 +1,217 @@
+// Differential check: random Inst programs run through the interpreter and
+// the JIT, both as written and after vm_optimize, must end in the same
+// state (status, stack, first frame of locals, low memory, or failing pc).
+//
+//   gcc -O2 vm_jit_check.c vm.c vm_opt.c vm_jit.c -o vm_jit_check && ./vm_jit_check [programs] [seed]
+//
+// Programs only jump and call forward, and their loops are counted down
+// from a small constant in local 15, so every program terminates.
+
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vm.h"
+
+#define MAX_CODE 64
+#define LOOP_COUNTER 15
+#define CHECKED_MEMORY 64
+
+static uint64_t rng = 88172645463325252ull;
+
+static uint32_t next_random(void)
+{
+	rng ^= rng << 13;
+	rng ^= rng >> 7;
+	rng ^= rng << 17;
+	return (uint32_t)(rng >> 16);
+}
+
+static uint32_t below(uint32_t n) { return next_random() % n; }
+
+static int random_value(void)
+{
+	static const int edges[] = {0, 1, -1, 2, INT_MIN, INT_MAX, INT_MIN + 1, 1 << 30};
+	switch (below(4)) {
+	case 0: return edges[below(sizeof(edges) / sizeof(edges[0]))];
+	case 1: return (int)next_random();
+	default: return (int)below(CHECKED_MEMORY + 8) - 4; // small, often a valid address
+	}
+}
+
+// a straight-line instruction: no jumps, calls or loop counter writes
+static Inst random_simple(void)
+{
+	static const Inst_Type plain[] = {INST_ADD, INST_SUB, INST_MUL, INST_DIV, INST_MOD, INST_EQ,
+	                                  INST_NE, INST_LT, INST_LE, INST_GT, INST_GE, INST_DUP,
+	                                  INST_DROP, INST_SWAP, INST_LOADM, INST_STOREM};
+	switch (below(8)) {
+	case 0:
+	case 1:
+	case 2: return (Inst){.type = INST_PUSH, .operand = random_value()};
+	case 3: return (Inst){.type = INST_LOAD, .operand = (int)below(VM_FRAME_LOCALS)};
+	case 4: return (Inst){.type = INST_STORE, .operand = (int)below(LOOP_COUNTER)};
+	default: return (Inst){.type = plain[below(sizeof(plain) / sizeof(plain[0]))]};
+	}
+}
+
+// fills code and returns its length; boundary[i] marks where a block starts,
+// the only places forward jumps and calls may land
+static size_t random_program(Inst *code)
+{
+	char boundary[MAX_CODE + 1] = {0};
+	const size_t want = 8 + below(MAX_CODE - 24);
+	size_t n = 0;
+	// start with a few values so most programs get past their first ops
+	for (uint32_t k = below(5); k > 0; --k) {
+		boundary[n] = 1;
+		code[n++] = (Inst){.type = INST_PUSH, .operand = random_value()};
+	}
+	while (n < want) {
+		boundary[n] = 1;
+		const uint32_t pick = below(100);
+		if (pick < 6) {
+			// PUSH k; STORE 15; body...; LOAD 15; PUSH 1; SUB; DUP; STORE 15; JNZ body
+			code[n++] = (Inst){.type = INST_PUSH, .operand = 1 + (int)below(5)};
+			code[n++] = (Inst){.type = INST_STORE, .operand = LOOP_COUNTER};
+			const size_t body = n;
+			for (uint32_t k = 1 + below(4); k > 0; --k) code[n++] = random_simple();
+			code[n++] = (Inst){.type = INST_LOAD, .operand = LOOP_COUNTER};
+			code[n++] = (Inst){.type = INST_PUSH, .operand = 1};
+			code[n++] = (Inst){.type = INST_SUB};
+			code[n++] = (Inst){.type = INST_DUP};
+			code[n++] = (Inst){.type = INST_STORE, .operand = LOOP_COUNTER};
+			code[n++] = (Inst){.type = INST_JNZ, .operand = (int)body};
+		} else if (pick < 16) {
+			static const Inst_Type jumps[] = {INST_JMP, INST_JZ, INST_JNZ, INST_CALL};
+			code[n++] = (Inst){.type = jumps[below(4)], .operand = -1}; // target chosen below
+		} else if (pick < 19) {
+			code[n++] = (Inst){.type = below(3) ? INST_RET : INST_HALT};
+		} else if (pick < 20) {
+			code[n++] = (Inst){.type = INST_PRINT};
+		} else {
+			code[n++] = random_simple();
+		}
+	}
+	boundary[n] = 1;
+
+	for (size_t i = 0; i < n; ++i) {
+		if (code[i].operand != -1 || vm_operand_kind(code[i].type) != OPERAND_TARGET) continue;
+		size_t target = i + 1 + below((uint32_t)(n - i));
+		while (!boundary[target]) ++target;
+		code[i].operand = (int)target;
+	}
+	return n;
+}
+
+typedef struct {
+	Vm vm;
+	Vm_Status status;
+} Run;
+
+static Run runs[4]; // interpreter, JIT, optimized interpreter, optimized JIT
+
+static int same(const Run *a, const Run *b)
+{
+	if (a->status != b->status) return 0;
+	if (a->status != VM_OK) return a->vm.pc == b->vm.pc;
+	return a->vm.depth == b->vm.depth &&
+	       memcmp(a->vm.stack + 1, b->vm.stack + 1, a->vm.depth * sizeof(int64_t)) == 0 &&
+	       memcmp(a->vm.locals, b->vm.locals, VM_FRAME_LOCALS * sizeof(int64_t)) == 0 &&
+	       memcmp(a->vm.memory, b->vm.memory, CHECKED_MEMORY * sizeof(int64_t)) == 0;
+}
+
+static void describe(const char *what, const Run *r)
+{
+	printf("  %-16s %s at %zu, depth %zu, top %" PRId64 "\n", what, vm_status_name(r->status), r->vm.pc,
+	       r->vm.depth, vm_top(&r->vm));
+}
+
+static void dump(const Vm_Program *p)
+{
+	for (size_t i = 0; i < p->count; ++i)
+		printf("  %3zu %-8s %d %d\n", i, vm_inst_name(p->code[i].type), p->code[i].operand, p->code[i].operand2);
+}
+
+// the fallback the JIT API asks for: interpret whatever it cannot compile
+static Vm_Status run_jit(Vm *vm, const Vm_Program *program, int *fell_back)
+{
+	Vm_Jit *jit = vm_jit_compile(program);
+	if (!jit) {
+		*fell_back = 1;
+		return vm_run(vm, program);
+	}
+	const Vm_Status status = vm_jit_run(vm, jit);
+	vm_jit_free(jit);
+	return status;
+}
+
+int main(int argc, char **argv)
+{
+	const long programs = argc > 1 ? atol(argv[1]) : 20000;
+	if (argc > 2) rng = strtoull(argv[2], NULL, 0) | 1;
+
+	FILE *devnull = fopen("/dev/null", "w");
+	for (int r = 0; r < 4; ++r) {
+		vm_init(&runs[r].vm);
+		runs[r].vm.out = devnull;
+	}
+
+	long compiled = 0, fallbacks = 0, status_counts[VM_BAD_ADDRESS + 1] = {0};
+	for (long i = 0; i < programs; ++i) {
+		Inst code[MAX_CODE];
+		const size_t n = random_program(code);
+		Vm_Program program, optimized;
+		size_t bad;
+		if (vm_prepare(code, n, &program, &bad) != VM_OK) {
+			printf("generator produced an invalid program (instruction %zu)\n", bad);
+			return 1;
+		}
+		vm_optimize(&program, &optimized, VM_OPT_ALL);
+
+		// every run starts from the same locals and low memory, where the
+		// generated addresses mostly land (a call chain is at most MAX_CODE deep)
+		for (int r = 0; r < 4; ++r) {
+			memset(runs[r].vm.locals, 0, MAX_CODE * VM_FRAME_LOCALS * sizeof(int64_t));
+			memset(runs[r].vm.memory, 0, CHECKED_MEMORY * sizeof(int64_t));
+		}
+
+		int fell_back = 0;
+		runs[0].status = vm_run(&runs[0].vm, &program);
+		runs[1].status = run_jit(&runs[1].vm, &program, &fell_back);
+		runs[2].status = vm_run(&runs[2].vm, &optimized);
+		runs[3].status = run_jit(&runs[3].vm, &optimized, &fell_back);
+		fallbacks += fell_back;
+		compiled += !fell_back;
+		++status_counts[runs[0].status];
+
+		// optimized code may get past a stack error the original hits, and it
+		// fails at different indices, so it is compared with the original
+		// only when that ran cleanly
+		const int ok = same(&runs[0], &runs[1]) && same(&runs[2], &runs[3]) &&
+		               (runs[0].status != VM_OK || same(&runs[0], &runs[2]));
+		if (!ok) {
+			printf("mismatch on program %ld:\n", i);
+			describe("interpreter", &runs[0]);
+			describe("jit", &runs[1]);
+			describe("opt interpreter", &runs[2]);
+			describe("opt jit", &runs[3]);
+			printf("program:\n");
+			dump(&program);
+			printf("optimized:\n");
+			dump(&optimized);
+			return 1;
+		}
+		vm_program_free(&program);
+		vm_program_free(&optimized);
+	}
+
+	printf("%ld programs agree (%ld compiled, %ld fell back to the interpreter)\n", programs, compiled, fallbacks);
+	for (int s = 0; s <= VM_BAD_ADDRESS; ++s)
+		if (status_counts[s]) printf("  %-20s %ld\n", vm_status_name((Vm_Status)s), status_counts[s]);
+	for (int r = 0; r < 4; ++r) vm_free(&runs[r].vm);
+	fclose(devnull);
+	return 0;
+}
@@ -0,0 +1,230 @@
+#include "vm.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Each pass scans the program once and tries the patterns below at every
+// instruction, longest first. A pattern only matches if no instruction after
+// its first is a jump target, so control never lands inside a rewrite.
+// Removed instructions map to whatever comes next, which is where a jump to
+// them has to go. Passes repeat until nothing changes, because folding
+// exposes more folding (PUSH 1; PUSH 2; ADD; PUSH 3; MUL -> PUSH 9).
+
+typedef struct {
+	const Inst *code;
+	size_t left;         // instructions from here to the end
+	const char *leader;  // leader[k]: code[k] is a jump target
+} Window;
+
+// the next n instructions exist and none but the first is a jump target
+static int fits(const Window *w, size_t n)
+{
+	if (n > w->left) return 0;
+	for (size_t k = 1; k < n; ++k)
+		if (w->leader[k]) return 0;
+	return 1;
+}
+
+static int is_type(const Window *w, size_t k, Inst_Type type) { return w->code[k].type == type; }
+
+static int is_compare(Inst_Type type) { return type >= INST_EQ && type <= INST_GE; }
+
+// EQ..GE -> BR_EQ..BR_GE; BRI_ and BRL_ follow at +1 and +2
+static Inst_Type branch_for(Inst_Type compare, int negate)
+{
+	static const Inst_Type inverse[] = {INST_NE, INST_EQ, INST_GE, INST_GT, INST_LE, INST_LT};
+	if (negate) compare = inverse[compare - INST_EQ];
+	return (Inst_Type)(INST_BR_EQ + 3 * (compare - INST_EQ));
+}
+
+static int fold_binary(Inst_Type type, int64_t a, int64_t b, int *out)
+{
+	int64_t r;
+	switch (type) {
+	case INST_ADD: r = (int64_t)((uint64_t)a + (uint64_t)b); break;
+	case INST_SUB: r = (int64_t)((uint64_t)a - (uint64_t)b); break;
+	case INST_MUL: r = (int64_t)((uint64_t)a * (uint64_t)b); break;
+	case INST_DIV: if (b == 0) return 0; r = b == -1 ? (int64_t)(0 - (uint64_t)a) : a / b; break;
+	case INST_MOD: if (b == 0) return 0; r = b == -1 ? 0 : a % b; break;
+	case INST_EQ: r = a == b; break;
+	case INST_NE: r = a != b; break;
+	case INST_LT: r = a < b; break;
+	case INST_LE: r = a <= b; break;
+	case INST_GT: r = a > b; break;
+	case INST_GE: r = a >= b; break;
+	default: return 0;
+	}
+	if (r < INT_MIN || r > INT_MAX) return 0; // PUSH only carries an int
+	*out = (int)r;
+	return 1;
+}
+
+// returns how many instructions were consumed (0: no match); the
+// replacement goes to repl[0..*nrepl)
+static size_t fold(const Window *w, size_t index, Inst *repl, size_t *nrepl)
+{
+	const Inst *c = w->code;
+	*nrepl = 0;
+
+	if (fits(w, 3) && is_type(w, 0, INST_PUSH) && is_type(w, 1, INST_PUSH) &&
+	    fold_binary(c[2].type, c[0].operand, c[1].operand, &repl[0].operand)) {
+		repl[0].type = INST_PUSH;
+		*nrepl = 1;
+		return 3;
+	}
+	if (fits(w, 2) && is_type(w, 0, INST_PUSH)) {
+		const int k = c[0].operand;
+		switch (c[1].type) {
+		case INST_DROP:
+			return 2;
+		case INST_JZ:
+		case INST_JNZ:
+			if ((k == 0) == (c[1].type == INST_JZ)) {
+				repl[0] = (Inst){.type = INST_JMP, .operand = c[1].operand};
+				*nrepl = 1;
+			}
+			return 2;
+		case INST_ADD:
+		case INST_SUB:
+			if (k == 0) return 2;
+			break;
+		case INST_MUL:
+		case INST_DIV:
+			if (k == 1) return 2;
+			break;
+		default:
+			break;
+		}
+	}
+	if (is_type(w, 0, INST_JMP) && (size_t)c[0].operand == index + 1) return 1;
+	return 0;
+}
+
+static size_t fuse(const Window *w, Inst *repl, size_t *nrepl)
+{
+	const Inst *c = w->code;
+	*nrepl = 1;
+
+	// LOAD n; PUSH k; ADD; STORE n -> INCL n, k
+	if (fits(w, 4) && is_type(w, 0, INST_LOAD) && is_type(w, 1, INST_PUSH) && is_type(w, 2, INST_ADD) &&
+	    is_type(w, 3, INST_STORE) && c[3].operand == c[0].operand) {
+		repl[0] = (Inst){.type = INST_INCL, .operand = c[0].operand, .operand2 = c[1].operand};
+		return 4;
+	}
+	// (PUSH k | LOAD n); cmp; JZ/JNZ t -> BRI_/BRL_ k|n, t
+	if (fits(w, 3) && (is_type(w, 0, INST_PUSH) || is_type(w, 0, INST_LOAD)) && is_compare(c[1].type) &&
+	    (is_type(w, 2, INST_JZ) || is_type(w, 2, INST_JNZ))) {
+		const Inst_Type br = branch_for(c[1].type, is_type(w, 2, INST_JZ));
+		repl[0] = (Inst){.type = (Inst_Type)(br + (is_type(w, 0, INST_PUSH) ? 1 : 2)),
+		                 .operand = c[0].operand,
+		                 .operand2 = c[2].operand};
+		return 3;
+	}
+	// cmp; JZ/JNZ t -> BR_ t
+	if (fits(w, 2) && is_compare(c[0].type) && (is_type(w, 1, INST_JZ) || is_type(w, 1, INST_JNZ))) {
+		repl[0] = (Inst){.type = branch_for(c[0].type, is_type(w, 1, INST_JZ)), .operand = c[1].operand};
+		return 2;
+	}
+	if (fits(w, 2) && is_type(w, 0, INST_PUSH)) {
+		const int k = c[0].operand;
+		if (is_type(w, 1, INST_ADD)) {
+			repl[0] = (Inst){.type = INST_ADDI, .operand = k};
+			return 2;
+		}
+		if (is_type(w, 1, INST_SUB) && k != INT_MIN) {
+			repl[0] = (Inst){.type = INST_ADDI, .operand = -k};
+			return 2;
+		}
+		if (is_type(w, 1, INST_MUL)) {
+			repl[0] = (Inst){.type = INST_MULI, .operand = k};
+			return 2;
+		}
+	}
+	if (fits(w, 2) && is_type(w, 0, INST_LOAD)) {
+		if (is_type(w, 1, INST_ADD)) {
+			repl[0] = (Inst){.type = INST_ADDL, .operand = c[0].operand};
+			return 2;
+		}
+		if (is_type(w, 1, INST_LOAD)) {
+			repl[0] = (Inst){.type = INST_LOAD2, .operand = c[0].operand, .operand2 = c[1].operand};
+			return 2;
+		}
+	}
+	*nrepl = 0;
+	return 0;
+}
+
+static void remap(Operand_Kind kind, int *operand, const size_t *map)
+{
+	if (kind == OPERAND_TARGET) *operand = (int)map[*operand];
+}
+
+// one pass over p, in place; returns the number of rewrites
+static size_t rewrite(Vm_Program *p, unsigned flags, char *leader, size_t *map, Inst *out)
+{
+	const size_t n = p->count;
+	memset(leader, 0, n);
+	for (size_t i = 0; i < n; ++i) {
+		if (vm_operand_kind(p->code[i].type) == OPERAND_TARGET) leader[p->code[i].operand] = 1;
+		if (vm_operand2_kind(p->code[i].type) == OPERAND_TARGET) leader[p->code[i].operand2] = 1;
+	}
+
+	size_t rewrites = 0, o = 0;
+	for (size_t i = 0; i < n;) {
+		const Window w = {p->code + i, n - i, leader + i};
+		Inst repl[1] = {{0}};
+		size_t nrepl = 0, used = 0;
+		if (flags & VM_OPT_FOLD) used = fold(&w, i, repl, &nrepl);
+		if (!used && (flags & VM_OPT_FUSE)) used = fuse(&w, repl, &nrepl);
+		if (used) {
+			++rewrites;
+		} else {
+			repl[0] = p->code[i];
+			nrepl = used = 1;
+		}
+		for (size_t k = 0; k < used; ++k) map[i + k] = o;
+		memcpy(out + o, repl, nrepl * sizeof(Inst));
+		o += nrepl;
+		i += used;
+	}
+
+	for (size_t i = 0; i < o; ++i) {
+		remap(vm_operand_kind(out[i].type), &out[i].operand, map);
+		remap(vm_operand2_kind(out[i].type), &out[i].operand2, map);
+	}
+	memcpy(p->code, out, o * sizeof(Inst));
+	p->count = o;
+	return rewrites;
+}
+
+Vm_Status vm_optimize(const Vm_Program *in, Vm_Program *out, unsigned flags)
+{
+	const size_t n = in->count;
+	out->code = malloc(n * sizeof(Inst));
+	Inst *scratch = malloc(n * sizeof(Inst));
+	char *leader = malloc(n);
+	size_t *map = malloc(n * sizeof(size_t));
+	if (!out->code || !scratch || !leader || !map) {
+		free(out->code);
+		free(scratch);
+		free(leader);
+		free(map);
+		out->code = NULL;
+		out->count = 0;
+		return VM_BAD_INST;
+	}
+	memcpy(out->code, in->code, n * sizeof(Inst));
+	out->count = n;
+
+	// fold to a fixed point first so fusion sees the simplest code
+	if (flags & VM_OPT_FOLD)
+		while (rewrite(out, VM_OPT_FOLD, leader, map, scratch)) {}
+	if (flags & VM_OPT_FUSE)
+		while (rewrite(out, VM_OPT_FUSE, leader, map, scratch)) {}
+
+	free(scratch);
+	free(leader);
+	free(map);
+	return VM_OK;
+}
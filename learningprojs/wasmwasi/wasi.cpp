@@ -0,0 +1,111 @@
+#include "wasi.h"
+
+#include <cstring>
+
+namespace wasm {
+
+namespace {
+
+constexpr const char* kModule = "wasi_snapshot_preview1";
+
+// WASI errno values
+constexpr uint32_t kSuccess = 0;
+constexpr uint32_t kBadF = 8;
+constexpr uint32_t kFault = 21;
+
+struct Fault {};
+
+// guest memory [offset, offset + size), or Fault
+uint8_t* guest(Instance& instance, uint64_t offset, uint64_t size) {
+    const std::span<uint8_t> mem = instance.memory();
+    if (offset + size > mem.size()) throw Fault{};
+    return mem.data() + offset;
+}
+
+uint32_t load32(Instance& instance, uint64_t offset) {
+    uint32_t v;
+    std::memcpy(&v, guest(instance, offset, 4), 4);
+    return v;
+}
+
+void store32(Instance& instance, uint64_t offset, uint32_t v) { std::memcpy(guest(instance, offset, 4), &v, 4); }
+
+// argv/environ style: a count and a total size including terminators
+uint32_t sizesGet(Instance& instance, const std::vector<std::string>& strings, uint32_t countAt, uint32_t sizeAt) {
+    uint32_t size = 0;
+    for (const std::string& s : strings) size += static_cast<uint32_t>(s.size() + 1);
+    store32(instance, countAt, static_cast<uint32_t>(strings.size()));
+    store32(instance, sizeAt, size);
+    return kSuccess;
+}
+
+// pointers to the strings at pointersAt, the strings themselves at bufferAt
+uint32_t stringsGet(Instance& instance, const std::vector<std::string>& strings, uint32_t pointersAt, uint32_t bufferAt) {
+    uint64_t at = bufferAt;
+    for (size_t i = 0; i < strings.size(); ++i) {
+        const std::string& s = strings[i];
+        std::memcpy(guest(instance, at, s.size() + 1), s.c_str(), s.size() + 1);
+        store32(instance, pointersAt + 4 * i, static_cast<uint32_t>(at));
+        at += s.size() + 1;
+    }
+    return kSuccess;
+}
+
+const FuncType kI32x2{{ValType::I32, ValType::I32}, {ValType::I32}};
+
+} // namespace
+
+void addWasi(Imports& imports, const WasiOptions& options) {
+    const WasiOptions* opts = &options;
+    // every function returns an errno; a bad guest pointer becomes EFAULT
+    auto add = [&](const char* name, FuncType type, auto body) {
+        auto fn = [body](Instance& instance, std::span<const uint64_t> args, std::span<uint64_t> results) {
+            uint32_t status;
+            try {
+                status = body(instance, args);
+            } catch (const Fault&) {
+                status = kFault;
+            }
+            results[0] = status;
+        };
+        imports[{kModule, name}] = HostImport{std::move(type), fn};
+    };
+
+    // fd_write(fd, iovs, iovs_len, nwritten) -> errno
+    add("fd_write", FuncType{{ValType::I32, ValType::I32, ValType::I32, ValType::I32}, {ValType::I32}},
+        [opts](Instance& instance, std::span<const uint64_t> args) {
+            const uint32_t fd = static_cast<uint32_t>(args[0]);
+            std::FILE* file = fd == 1 ? opts->out : fd == 2 ? opts->err : nullptr;
+            if (!file) return kBadF;
+            const uint32_t iovs = static_cast<uint32_t>(args[1]);
+            uint32_t written = 0;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(args[2]); ++i) {
+                const uint32_t base = load32(instance, iovs + 8ull * i);
+                const uint32_t len = load32(instance, iovs + 8ull * i + 4);
+                written += static_cast<uint32_t>(std::fwrite(guest(instance, base, len), 1, len, file));
+            }
+            store32(instance, static_cast<uint32_t>(args[3]), written);
+            return kSuccess;
+        });
+
+    // proc_exit(code) does not return
+    auto procExit = [](Instance&, std::span<const uint64_t> args, std::span<uint64_t>) {
+        throw Exit{static_cast<int32_t>(args[0])};
+    };
+    imports[{kModule, "proc_exit"}] = HostImport{FuncType{{ValType::I32}, {}}, procExit};
+
+    add("args_sizes_get", kI32x2, [opts](Instance& instance, std::span<const uint64_t> args) {
+        return sizesGet(instance, opts->args, static_cast<uint32_t>(args[0]), static_cast<uint32_t>(args[1]));
+    });
+    add("args_get", kI32x2, [opts](Instance& instance, std::span<const uint64_t> args) {
+        return stringsGet(instance, opts->args, static_cast<uint32_t>(args[0]), static_cast<uint32_t>(args[1]));
+    });
+    add("environ_sizes_get", kI32x2, [opts](Instance& instance, std::span<const uint64_t> args) {
+        return sizesGet(instance, opts->env, static_cast<uint32_t>(args[0]), static_cast<uint32_t>(args[1]));
+    });
+    add("environ_get", kI32x2, [opts](Instance& instance, std::span<const uint64_t> args) {
+        return stringsGet(instance, opts->env, static_cast<uint32_t>(args[0]), static_cast<uint32_t>(args[1]));
+    });
+}
+
+} // namespace wasm
@@ -0,0 +1,25 @@
+#pragma once
+
+// The slice of WASI preview 1 ("wasi_snapshot_preview1") that hello-world
+// style programs import: fd_write to stdout/stderr, proc_exit, and the
+// argument/environment queries their startup code makes.
+
+#include "wasm.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace wasm {
+
+struct WasiOptions {
+    std::vector<std::string> args;
+    std::vector<std::string> env; // "NAME=value"
+    std::FILE* out = stdout;
+    std::FILE* err = stderr;
+};
+
+// registers the WASI functions in imports; the options must outlive them
+void addWasi(Imports& imports, const WasiOptions& options);
+
+} // namespace wasm
@@ -0,0 +1,164 @@
+#pragma once
+
+// A small WebAssembly engine: decode() checks a .wasm binary and compiles
+// each function body into a flat internal bytecode. That step validates
+// types and resolves every branch to a target pc plus the stack height to
+// cut back to, so the interpreter does no checking of its own beyond what
+// wasm defines as traps (bounds, division, call depth).
+//
+// Supported: the MVP plus multi-value blocks, sign extension, saturating
+// truncation and memory.copy/fill/init. Imports must be functions. Not
+// supported: reference types beyond funcref tables, SIMD, threads.
+//
+//   g++ -std=c++20 -O2 wasm_decode.cpp wasm_exec.cpp wasi.cpp wasm_run.cpp -o wasm_run
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace wasm {
+
+enum class ValType : uint8_t { I32 = 0x7f, I64 = 0x7e, F32 = 0x7d, F64 = 0x7c };
+
+struct FuncType {
+    std::vector<ValType> params;
+    std::vector<ValType> results;
+
+    bool operator==(const FuncType&) const = default;
+};
+
+struct Limits {
+    uint32_t min = 0;
+    std::optional<uint32_t> max;
+};
+
+enum class ExternKind : uint8_t { Func = 0, Table = 1, Memory = 2, Global = 3 };
+
+struct Import {
+    std::string module;
+    std::string name;
+    uint32_t typeIndex; // imports are functions only
+};
+
+struct Export {
+    std::string name;
+    ExternKind kind;
+    uint32_t index;
+};
+
+struct Global {
+    ValType type;
+    bool isMutable;
+    uint64_t init;
+};
+
+struct Function {
+    uint32_t typeIndex;
+    uint32_t numLocals; // params included
+    uint32_t maxStack;  // deepest operand stack the body reaches
+    std::vector<uint32_t> code;
+};
+
+struct DataSegment {
+    bool active;
+    uint32_t offset;
+    std::vector<uint8_t> bytes;
+};
+
+struct ElemSegment {
+    uint32_t offset;
+    std::vector<uint32_t> funcs;
+};
+
+struct Module {
+    std::vector<FuncType> types;
+    std::vector<Import> imports;
+    std::vector<Function> functions; // function index - imports.size()
+    std::optional<Limits> table;
+    std::optional<Limits> memory;
+    std::vector<Global> globals;
+    std::vector<Export> exports;
+    std::optional<uint32_t> start;
+    std::vector<ElemSegment> elements;
+    std::vector<DataSegment> data;
+
+    const FuncType& funcType(uint32_t funcIndex) const {
+        return types[funcIndex < imports.size() ? imports[funcIndex].typeIndex
+                                                : functions[funcIndex - imports.size()].typeIndex];
+    }
+    std::optional<uint32_t> findExport(std::string_view name, ExternKind kind) const;
+};
+
+struct DecodeError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+struct Trap : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// thrown by a host function to end the program, e.g. WASI proc_exit
+struct Exit {
+    int code;
+};
+
+Module decode(std::span<const uint8_t> bytes);
+
+class Instance;
+
+// arguments in args, results written to results; values are raw bits,
+// i32/f32 in the low 32 bits
+using HostFunction = std::function<void(Instance&, std::span<const uint64_t> args, std::span<uint64_t> results)>;
+
+struct HostImport {
+    FuncType type;
+    HostFunction fn;
+};
+
+// keyed by (module, name)
+using Imports = std::map<std::pair<std::string, std::string>, HostImport>;
+
+class Instance {
+public:
+    static constexpr uint32_t kPageSize = 65536;
+    static constexpr size_t kStackSlots = 1 << 20;
+    static constexpr size_t kMaxCallDepth = 20000;
+
+    // links imports, sets up memory, table, globals and data, runs start
+    Instance(const Module& module, const Imports& imports);
+
+    std::vector<uint64_t> invoke(std::string_view exportName, std::span<const uint64_t> args = {});
+    std::vector<uint64_t> call(uint32_t funcIndex, std::span<const uint64_t> args);
+
+    std::span<uint8_t> memory() { return {mem.data(), mem.size()}; }
+    const Module& module() const { return mod; }
+
+private:
+    struct Frame {
+        const uint32_t* ret; // caller pc
+        uint64_t* fp;
+        const Function* func;
+    };
+
+    void execute(uint32_t funcIndex, uint64_t* args);
+    void callHost(uint32_t importIndex, uint64_t* sp);
+    int64_t growMemory(uint32_t pages);
+
+    const Module& mod;
+    std::vector<const HostImport*> hosts;
+    std::vector<uint8_t> mem;
+    std::vector<uint64_t> globals;
+    std::vector<std::optional<uint32_t>> table;
+    std::vector<bool> droppedData;
+    std::vector<uint64_t> stack;
+    std::vector<Frame> frames;
+};
+
+} // namespace wasm
@@ -0,0 +1,92 @@
+// Decode and execution speed of the wasm engine on the built-in sample
+// modules, plus decode speed of any .wasm files given on the command line.
+//
+//   g++ -std=c++20 -O2 wasm_decode.cpp wasm_exec.cpp wasm_bench.cpp -o wasm_bench
+//   ./wasm_bench [module.wasm...]
+
+#include "wasm.h"
+#include "wasm_samples.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+
+// best time of reps runs of fn
+template <typename Fn>
+double best(int reps, Fn&& fn) {
+    double result = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        const auto start = Clock::now();
+        fn();
+        result = std::min(result, seconds(Clock::now() - start));
+    }
+    return result;
+}
+
+void benchDecode(const char* name, const std::vector<uint8_t>& bytes) {
+    size_t codeWords = 0;
+    const int iterations = static_cast<int>(std::max<size_t>(1, 20'000'000 / (bytes.size() + 64)));
+    const double t = best(3, [&] {
+        for (int i = 0; i < iterations; ++i) {
+            const wasm::Module m = wasm::decode(bytes);
+            codeWords = 0;
+            for (const wasm::Function& f : m.functions) codeWords += f.code.size();
+        }
+    });
+    std::printf("%-10s %8zu %10zu %12.2f %10.1f\n", name, bytes.size(), codeWords * 4, t / iterations * 1e6,
+                bytes.size() * iterations / t * 1e-6);
+}
+
+struct Run {
+    const char* name;
+    std::vector<uint8_t> bytes;
+    const char* exportName;
+    uint64_t arg;
+    uint64_t expected;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<Run> runs = {
+        {"fib", wasm::samples::fib(), "fib", 27, 196418},
+        {"loop", wasm::samples::loopSum(), "sum", 10'000'000, 49'999'995'000'000},
+        {"sieve", wasm::samples::sieve(), "sieve", 1'000'000, 78498},
+    };
+
+    std::printf("%-10s %8s %10s %12s %10s\n", "decode", "bytes", "code bytes", "us/module", "MB/s");
+    benchDecode("hello", wasm::samples::hello());
+    for (const Run& run : runs) benchDecode(run.name, run.bytes);
+    for (int i = 1; i < argc; ++i) {
+        std::ifstream in(argv[i], std::ios::binary);
+        const std::vector<uint8_t> bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+        try {
+            benchDecode(argv[i], bytes);
+        } catch (const wasm::DecodeError& e) {
+            std::printf("%-10s %s\n", argv[i], e.what());
+        }
+    }
+
+    std::printf("\n%-10s %12s %10s\n", "execute", "result", "ms/run");
+    for (const Run& run : runs) {
+        const wasm::Module module = wasm::decode(run.bytes);
+        wasm::Instance instance(module, {});
+        uint64_t result = 0;
+        const uint64_t args[] = {run.arg};
+        const double t = best(5, [&] { result = instance.invoke(run.exportName, args)[0]; });
+        if (result != run.expected) {
+            std::fprintf(stderr, "%s: got %llu, expected %llu\n", run.name, static_cast<unsigned long long>(result),
+                         static_cast<unsigned long long>(run.expected));
+            return 1;
+        }
+        std::printf("%-10s %12llu %10.2f\n", run.name, static_cast<unsigned long long>(result), t * 1e3);
+    }
+    return 0;
+}
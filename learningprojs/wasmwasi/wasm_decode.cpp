@@ -0,0 +1,841 @@
+#include "wasm.h"
+#include "wasm_ops.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace wasm {
+
+namespace {
+
+[[noreturn]] void fail(const std::string& what, size_t offset) {
+    throw DecodeError(what + " at offset " + std::to_string(offset));
+}
+
+class Reader {
+public:
+    Reader(const uint8_t* begin, const uint8_t* end, const uint8_t* base) : p(begin), end(end), base(base) {}
+
+    size_t offset() const { return static_cast<size_t>(p - base); }
+    bool done() const { return p == end; }
+    [[noreturn]] void error(const std::string& what) const { fail(what, offset()); }
+
+    uint8_t u8() {
+        if (p == end) error("unexpected end");
+        return *p++;
+    }
+
+    uint32_t u32() { return static_cast<uint32_t>(leb(32, false)); }
+    int32_t s32() { return static_cast<int32_t>(leb(32, true)); }
+    int64_t s33() { return leb(33, true); }
+    int64_t s64() { return leb(64, true); }
+
+    uint32_t fixed32() {
+        uint32_t v;
+        std::memcpy(&v, take(4), 4);
+        return v;
+    }
+
+    uint64_t fixed64() {
+        uint64_t v;
+        std::memcpy(&v, take(8), 8);
+        return v;
+    }
+
+    const uint8_t* take(size_t n) {
+        if (static_cast<size_t>(end - p) < n) error("unexpected end");
+        const uint8_t* at = p;
+        p += n;
+        return at;
+    }
+
+    std::string name() {
+        const uint32_t n = u32();
+        const char* s = reinterpret_cast<const char*>(take(n));
+        return std::string(s, n);
+    }
+
+    ValType valType() {
+        const uint8_t b = u8();
+        if (b < 0x7c || b > 0x7f) error("unsupported value type");
+        return static_cast<ValType>(b);
+    }
+
+    // a nested reader over the next n bytes
+    Reader sub(size_t n) {
+        const uint8_t* at = take(n);
+        return Reader(at, at + n, base);
+    }
+
+private:
+    int64_t leb(unsigned bits, bool isSigned) {
+        uint64_t result = 0;
+        unsigned shift = 0;
+        uint8_t byte;
+        do {
+            if (shift >= (bits + 6) / 7 * 7) error("LEB128 too long");
+            byte = u8();
+            result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        if (shift < 64 && isSigned && (byte & 0x40)) result |= ~uint64_t{0} << shift;
+        // the unused bits of the last byte must match the sign / be zero
+        if (shift > bits) {
+            const int64_t v = static_cast<int64_t>(result);
+            const bool fits = isSigned ? (bits == 64 || (v >= -(int64_t{1} << (bits - 1)) && v < (int64_t{1} << (bits - 1))))
+                                       : (bits == 64 || result < (uint64_t{1} << bits));
+            if (!fits) error("LEB128 out of range");
+        }
+        return static_cast<int64_t>(result);
+    }
+
+    const uint8_t* p;
+    const uint8_t* end;
+    const uint8_t* base;
+};
+
+Limits readLimits(Reader& r) {
+    const uint8_t flag = r.u8();
+    if (flag > 1) r.error("unsupported limits flag");
+    Limits l;
+    l.min = r.u32();
+    if (flag == 1) {
+        l.max = r.u32();
+        if (*l.max < l.min) r.error("limits max below min");
+    }
+    return l;
+}
+
+// constant expression: one const or global.get, then end
+uint64_t readConstExpr(Reader& r, const Module& m, ValType expected) {
+    const uint8_t opcode = r.u8();
+    uint64_t value = 0;
+    ValType type;
+    switch (opcode) {
+    case op::kI32Const: value = static_cast<uint32_t>(r.s32()); type = ValType::I32; break;
+    case op::kI64Const: value = static_cast<uint64_t>(r.s64()); type = ValType::I64; break;
+    case op::kF32Const: value = r.fixed32(); type = ValType::F32; break;
+    case op::kF64Const: value = r.fixed64(); type = ValType::F64; break;
+    case op::kGlobalGet: {
+        const uint32_t index = r.u32();
+        if (index >= m.globals.size() || m.globals[index].isMutable) r.error("bad global in constant expression");
+        value = m.globals[index].init;
+        type = m.globals[index].type;
+        break;
+    }
+    default: r.error("unsupported constant expression");
+    }
+    if (type != expected) r.error("constant expression type mismatch");
+    if (r.u8() != 0x0b) r.error("constant expression not terminated");
+    return value;
+}
+
+struct NumericSig {
+    ValType in1;
+    std::optional<ValType> in2;
+    ValType out;
+};
+
+// signature of a numeric opcode (0x45..0xc4, or 0x100+ for the saturating
+// truncations); nullopt if it is not one
+std::optional<NumericSig> numericSig(uint32_t code) {
+    using V = ValType;
+    auto un = [](V in, V out) { return NumericSig{in, std::nullopt, out}; };
+    auto bin = [](V in, V out) { return NumericSig{in, in, out}; };
+    if (code == 0x45) return un(V::I32, V::I32);
+    if (code >= 0x46 && code <= 0x4f) return bin(V::I32, V::I32);
+    if (code == 0x50) return un(V::I64, V::I32);
+    if (code >= 0x51 && code <= 0x5a) return bin(V::I64, V::I32);
+    if (code >= 0x5b && code <= 0x60) return bin(V::F32, V::I32);
+    if (code >= 0x61 && code <= 0x66) return bin(V::F64, V::I32);
+    if (code >= 0x67 && code <= 0x69) return un(V::I32, V::I32);
+    if (code >= 0x6a && code <= 0x78) return bin(V::I32, V::I32);
+    if (code >= 0x79 && code <= 0x7b) return un(V::I64, V::I64);
+    if (code >= 0x7c && code <= 0x8a) return bin(V::I64, V::I64);
+    if (code >= 0x8b && code <= 0x91) return un(V::F32, V::F32);
+    if (code >= 0x92 && code <= 0x98) return bin(V::F32, V::F32);
+    if (code >= 0x99 && code <= 0x9f) return un(V::F64, V::F64);
+    if (code >= 0xa0 && code <= 0xa6) return bin(V::F64, V::F64);
+    switch (code) {
+    case 0xa7: return un(V::I64, V::I32);
+    case 0xa8: case 0xa9: return un(V::F32, V::I32);
+    case 0xaa: case 0xab: return un(V::F64, V::I32);
+    case 0xac: case 0xad: return un(V::I32, V::I64);
+    case 0xae: case 0xaf: return un(V::F32, V::I64);
+    case 0xb0: case 0xb1: return un(V::F64, V::I64);
+    case 0xb2: case 0xb3: return un(V::I32, V::F32);
+    case 0xb4: case 0xb5: return un(V::I64, V::F32);
+    case 0xb6: return un(V::F64, V::F32);
+    case 0xb7: case 0xb8: return un(V::I32, V::F64);
+    case 0xb9: case 0xba: return un(V::I64, V::F64);
+    case 0xbb: return un(V::F32, V::F64);
+    case 0xbc: return un(V::F32, V::I32);
+    case 0xbd: return un(V::F64, V::I64);
+    case 0xbe: return un(V::I32, V::F32);
+    case 0xbf: return un(V::I64, V::F64);
+    case 0xc0: case 0xc1: return un(V::I32, V::I32);
+    case 0xc2: case 0xc3: case 0xc4: return un(V::I64, V::I64);
+    case op::kPrefixFC + 0: case op::kPrefixFC + 1: return un(V::F32, V::I32);
+    case op::kPrefixFC + 2: case op::kPrefixFC + 3: return un(V::F64, V::I32);
+    case op::kPrefixFC + 4: case op::kPrefixFC + 5: return un(V::F32, V::I64);
+    case op::kPrefixFC + 6: case op::kPrefixFC + 7: return un(V::F64, V::I64);
+    }
+    return std::nullopt;
+}
+
+struct MemAccess {
+    ValType type;
+    uint32_t maxAlign; // log2 of the access size
+    bool store;
+};
+
+std::optional<MemAccess> memAccess(uint8_t op) {
+    using V = ValType;
+    static const MemAccess table[] = {
+        {V::I32, 2, false}, {V::I64, 3, false}, {V::F32, 2, false}, {V::F64, 3, false}, // 0x28
+        {V::I32, 0, false}, {V::I32, 0, false}, {V::I32, 1, false}, {V::I32, 1, false}, // 0x2c
+        {V::I64, 0, false}, {V::I64, 0, false}, {V::I64, 1, false}, {V::I64, 1, false}, // 0x30
+        {V::I64, 2, false}, {V::I64, 2, false},                                         // 0x34
+        {V::I32, 2, true},  {V::I64, 3, true},  {V::F32, 2, true},  {V::F64, 3, true},  // 0x36
+        {V::I32, 0, true},  {V::I32, 1, true},  {V::I64, 0, true},  {V::I64, 1, true},  // 0x3a
+        {V::I64, 2, true},                                                              // 0x3e
+    };
+    if (op < 0x28 || op > 0x3e) return std::nullopt;
+    return table[op - 0x28];
+}
+
+// Validates one function body and emits its internal bytecode, following
+// the validation algorithm from the spec appendix. Operand heights known
+// here become the height/arity immediates of branches.
+class BodyCompiler {
+public:
+    BodyCompiler(const Module& m, std::optional<uint32_t> dataCount, Reader& r, Function& f)
+        : m(m), dataCount(dataCount), r(r), f(f), code(f.code) {}
+
+    void compile() {
+        const FuncType& type = m.types[f.typeIndex];
+        locals = type.params;
+        const uint32_t groups = r.u32();
+        for (uint32_t g = 0; g < groups; ++g) {
+            const uint32_t n = r.u32();
+            const ValType t = r.valType();
+            if (locals.size() + n > 50000) r.error("too many locals");
+            locals.insert(locals.end(), n, t);
+        }
+        f.numLocals = static_cast<uint32_t>(locals.size());
+        f.maxStack = 0;
+
+        pushCtrl(0x02, {}, type.results);
+        while (!ctrls.empty()) step();
+        if (!r.done()) r.error("code after function end");
+    }
+
+private:
+    using Operand = std::optional<ValType>; // nullopt: unknown, after unreachable code
+
+    struct Ctrl {
+        uint8_t opcode; // 0x02 block (also the function), 0x03 loop, 0x04 if, 0x05 else
+        std::vector<ValType> params;
+        std::vector<ValType> results;
+        size_t height;
+        bool unreachable = false;
+        uint32_t loopPc = 0;
+        std::vector<size_t> fixups; // immediates to patch with the end pc
+        size_t elseFixup = SIZE_MAX;
+    };
+
+    void push(Operand t) {
+        vals.push_back(t);
+        f.maxStack = std::max(f.maxStack, static_cast<uint32_t>(vals.size()));
+    }
+
+    Operand pop() {
+        const Ctrl& c = ctrls.back();
+        if (vals.size() == c.height) {
+            if (c.unreachable) return std::nullopt;
+            r.error("operand stack underflow");
+        }
+        Operand t = vals.back();
+        vals.pop_back();
+        return t;
+    }
+
+    Operand pop(ValType expected) {
+        Operand t = pop();
+        if (t && *t != expected) r.error("type mismatch");
+        return t ? t : expected;
+    }
+
+    void popAll(const std::vector<ValType>& types) {
+        for (size_t i = types.size(); i-- > 0;) pop(types[i]);
+    }
+
+    void pushAll(const std::vector<ValType>& types) {
+        for (ValType t : types) push(t);
+    }
+
+    void pushCtrl(uint8_t opcode, std::vector<ValType> params, std::vector<ValType> results) {
+        Ctrl& c = ctrls.emplace_back();
+        c.opcode = opcode;
+        c.params = std::move(params);
+        c.results = std::move(results);
+        c.height = vals.size();
+        c.loopPc = pc();
+        pushAll(ctrls.back().params);
+    }
+
+    void checkEnd(const Ctrl& c) {
+        popAll(c.results);
+        if (vals.size() != c.height) r.error("values left on stack at end of block");
+    }
+
+    void setUnreachable() {
+        vals.resize(ctrls.back().height);
+        ctrls.back().unreachable = true;
+    }
+
+    const std::vector<ValType>& labelTypes(const Ctrl& c) const { return c.opcode == 0x03 ? c.params : c.results; }
+
+    Ctrl& label(uint32_t depth) {
+        if (depth >= ctrls.size()) r.error("branch depth out of range");
+        return ctrls[ctrls.size() - 1 - depth];
+    }
+
+    uint32_t pc() const { return static_cast<uint32_t>(code.size()); }
+    void emit(uint32_t w) { code.push_back(w); }
+
+    void emitTarget(Ctrl& c) {
+        if (c.opcode == 0x03) {
+            emit(c.loopPc);
+        } else {
+            c.fixups.push_back(code.size());
+            emit(0);
+        }
+    }
+
+    // emits kBr/kBrIf (or kJmp/kJnz when no values move), with the label's
+    // values on top of the current stack
+    void emitBranch(uint32_t depth, bool conditional) {
+        Ctrl& c = label(depth);
+        const uint32_t arity = static_cast<uint32_t>(labelTypes(c).size());
+        const uint32_t height = static_cast<uint32_t>(locals.size() + c.height);
+        const bool moves = locals.size() + vals.size() - arity != height;
+        if (moves) {
+            emit(conditional ? op::kBrIf : op::kBr);
+            emitTarget(c);
+            emit(height);
+            emit(arity);
+        } else {
+            emit(conditional ? op::kJnz : op::kJmp);
+            emitTarget(c);
+        }
+    }
+
+    std::pair<std::vector<ValType>, std::vector<ValType>> blockType() {
+        const int64_t t = r.s33();
+        if (t == -0x40) return {}; // 0x40: empty
+        if (t < 0) {
+            const uint8_t b = static_cast<uint8_t>(t & 0x7f);
+            if (b < 0x7c || b > 0x7f) r.error("bad block type");
+            return {{}, {static_cast<ValType>(b)}};
+        }
+        if (static_cast<uint64_t>(t) >= m.types.size()) r.error("block type index out of range");
+        return {m.types[t].params, m.types[t].results};
+    }
+
+    uint32_t memoryImmediate(const MemAccess& access) {
+        if (!m.memory) r.error("memory access without memory");
+        const uint32_t align = r.u32();
+        if (align > access.maxAlign) r.error("alignment larger than natural");
+        return r.u32();
+    }
+
+    void requireMemory() {
+        if (!m.memory) r.error("memory instruction without memory");
+    }
+
+    ValType localType(uint32_t index) {
+        if (index >= locals.size()) r.error("local index out of range");
+        return locals[index];
+    }
+
+    void call(const FuncType& type) {
+        popAll(type.params);
+        pushAll(type.results);
+    }
+
+    void step() {
+        const uint8_t opcode = r.u8();
+        using V = ValType;
+        switch (opcode) {
+        case 0x00: // unreachable
+            emit(op::kUnreachable);
+            setUnreachable();
+            break;
+        case 0x01: // nop
+            break;
+        case 0x02: // block
+        case 0x03: { // loop
+            auto [params, results] = blockType();
+            popAll(params);
+            pushCtrl(opcode, std::move(params), std::move(results));
+            break;
+        }
+        case 0x04: { // if
+            auto [params, results] = blockType();
+            pop(V::I32);
+            popAll(params);
+            emit(op::kJz);
+            const size_t fix = code.size();
+            emit(0);
+            pushCtrl(opcode, std::move(params), std::move(results));
+            ctrls.back().elseFixup = fix;
+            break;
+        }
+        case 0x05: { // else
+            Ctrl& c = ctrls.back();
+            if (c.opcode != 0x04) r.error("else without if");
+            checkEnd(c);
+            emit(op::kJmp);
+            c.fixups.push_back(code.size());
+            emit(0);
+            code[c.elseFixup] = pc();
+            c.elseFixup = SIZE_MAX;
+            c.opcode = 0x05;
+            c.unreachable = false;
+            pushAll(c.params);
+            break;
+        }
+        case 0x0b: { // end
+            Ctrl c = std::move(ctrls.back());
+            checkEnd(c);
+            if (c.elseFixup != SIZE_MAX) {
+                if (c.params != c.results) r.error("if without else must not change the stack type");
+                code[c.elseFixup] = pc();
+            }
+            for (size_t at : c.fixups) code[at] = pc();
+            ctrls.pop_back();
+            if (ctrls.empty()) {
+                emit(op::kReturn);
+                emit(static_cast<uint32_t>(c.results.size()));
+            } else {
+                pushAll(c.results);
+            }
+            break;
+        }
+        case 0x0c: { // br
+            const uint32_t depth = r.u32();
+            popAll(labelTypes(label(depth)));
+            pushAll(labelTypes(label(depth))); // on the stack when the branch runs
+            emitBranch(depth, false);
+            setUnreachable();
+            break;
+        }
+        case 0x0d: { // br_if
+            const uint32_t depth = r.u32();
+            pop(V::I32);
+            const std::vector<ValType> types = labelTypes(label(depth));
+            popAll(types);
+            pushAll(types);
+            emitBranch(depth, true);
+            break;
+        }
+        case 0x0e: { // br_table
+            const uint32_t n = r.u32();
+            if (n > 1000000) r.error("br_table too large");
+            std::vector<uint32_t> depths(n + 1);
+            for (uint32_t& d : depths) d = r.u32();
+            pop(V::I32);
+            const size_t arity = labelTypes(label(depths.back())).size();
+            emit(op::kBrTable);
+            emit(n);
+            for (uint32_t d : depths) {
+                Ctrl& c = label(d);
+                const std::vector<ValType> types = labelTypes(c);
+                if (types.size() != arity) r.error("br_table labels differ in arity");
+                popAll(types);
+                pushAll(types);
+                emitTarget(c);
+                emit(static_cast<uint32_t>(locals.size() + c.height));
+                emit(static_cast<uint32_t>(arity));
+            }
+            setUnreachable();
+            break;
+        }
+        case 0x0f: { // return
+            const std::vector<ValType>& results = ctrls.front().results;
+            popAll(results);
+            emit(op::kReturn);
+            emit(static_cast<uint32_t>(results.size()));
+            setUnreachable();
+            break;
+        }
+        case 0x10: { // call
+            const uint32_t index = r.u32();
+            if (index >= m.imports.size() + m.functions.size()) r.error("function index out of range");
+            call(m.funcType(index));
+            if (index < m.imports.size()) {
+                emit(op::kCallHost);
+                emit(index);
+            } else {
+                emit(op::kCall);
+                emit(static_cast<uint32_t>(index - m.imports.size()));
+            }
+            break;
+        }
+        case 0x11: { // call_indirect
+            const uint32_t typeIndex = r.u32();
+            if (r.u32() != 0 || !m.table) r.error("call_indirect needs table 0");
+            if (typeIndex >= m.types.size()) r.error("type index out of range");
+            pop(V::I32);
+            call(m.types[typeIndex]);
+            emit(op::kCallIndirect);
+            emit(typeIndex);
+            break;
+        }
+        case 0x1a: // drop
+            pop();
+            emit(op::kDrop);
+            break;
+        case 0x1b: { // select
+            pop(V::I32);
+            Operand a = pop();
+            Operand b = pop();
+            if (a && b && *a != *b) r.error("select operands differ in type");
+            push(a ? a : b);
+            emit(op::kSelect);
+            break;
+        }
+        case 0x1c: { // select t
+            if (r.u32() != 1) r.error("typed select takes one type");
+            const ValType t = r.valType();
+            pop(V::I32);
+            pop(t);
+            pop(t);
+            push(t);
+            emit(op::kSelect);
+            break;
+        }
+        case 0x20: case 0x21: case 0x22: { // local.get/set/tee
+            const uint32_t index = r.u32();
+            const ValType t = localType(index);
+            if (opcode == 0x20) {
+                push(t);
+            } else {
+                pop(t);
+                if (opcode == 0x22) push(t);
+            }
+            emit(opcode);
+            emit(index);
+            break;
+        }
+        case 0x23: case 0x24: { // global.get/set
+            const uint32_t index = r.u32();
+            if (index >= m.globals.size()) r.error("global index out of range");
+            const Global& g = m.globals[index];
+            if (opcode == 0x23) {
+                push(g.type);
+            } else {
+                if (!g.isMutable) r.error("global.set of immutable global");
+                pop(g.type);
+            }
+            emit(opcode);
+            emit(index);
+            break;
+        }
+        case 0x3f: case 0x40: // memory.size / memory.grow
+            requireMemory();
+            if (r.u8() != 0) r.error("memory index must be 0");
+            if (opcode == 0x40) pop(V::I32);
+            push(V::I32);
+            emit(opcode);
+            break;
+        case 0x41:
+            push(V::I32);
+            emit(opcode);
+            emit(static_cast<uint32_t>(r.s32()));
+            break;
+        case 0x42: {
+            push(V::I64);
+            const uint64_t v = static_cast<uint64_t>(r.s64());
+            emit(opcode);
+            emit(static_cast<uint32_t>(v));
+            emit(static_cast<uint32_t>(v >> 32));
+            break;
+        }
+        case 0x43:
+            push(V::F32);
+            emit(opcode);
+            emit(r.fixed32());
+            break;
+        case 0x44: {
+            push(V::F64);
+            const uint64_t v = r.fixed64();
+            emit(opcode);
+            emit(static_cast<uint32_t>(v));
+            emit(static_cast<uint32_t>(v >> 32));
+            break;
+        }
+        case 0xfc:
+            prefixed();
+            break;
+        default:
+            if (auto access = memAccess(opcode)) {
+                const uint32_t offset = memoryImmediate(*access);
+                if (access->store) {
+                    pop(access->type);
+                    pop(V::I32);
+                } else {
+                    pop(V::I32);
+                    push(access->type);
+                }
+                emit(opcode);
+                emit(offset);
+            } else if (auto sig = numericSig(opcode)) {
+                numeric(*sig, opcode);
+            } else {
+                r.error("unsupported opcode 0x" + hex(opcode));
+            }
+        }
+    }
+
+    void numeric(const NumericSig& sig, uint32_t opcode) {
+        if (sig.in2) pop(*sig.in2);
+        pop(sig.in1);
+        push(sig.out);
+        emit(opcode);
+    }
+
+    void prefixed() {
+        const uint32_t sub = r.u32();
+        using V = ValType;
+        if (sub <= 7) {
+            numeric(*numericSig(op::kPrefixFC + sub), op::kPrefixFC + sub);
+            return;
+        }
+        switch (sub) {
+        case 8: { // memory.init
+            const uint32_t segment = r.u32();
+            if (r.u8() != 0) r.error("memory index must be 0");
+            requireMemory();
+            if (!dataCount || segment >= *dataCount) r.error("data segment index out of range");
+            pop(V::I32);
+            pop(V::I32);
+            pop(V::I32);
+            emit(op::kMemoryInit);
+            emit(segment);
+            break;
+        }
+        case 9: { // data.drop
+            const uint32_t segment = r.u32();
+            if (!dataCount || segment >= *dataCount) r.error("data segment index out of range");
+            emit(op::kDataDrop);
+            emit(segment);
+            break;
+        }
+        case 10: // memory.copy
+        case 11: // memory.fill
+            if (r.u8() != 0 || (sub == 10 && r.u8() != 0)) r.error("memory index must be 0");
+            requireMemory();
+            pop(V::I32);
+            pop(V::I32);
+            pop(V::I32);
+            emit(op::kPrefixFC + sub);
+            break;
+        default:
+            r.error("unsupported opcode 0xfc " + std::to_string(sub));
+        }
+    }
+
+    static std::string hex(unsigned v) {
+        static const char digits[] = "0123456789abcdef";
+        return {digits[(v >> 4) & 0xf], digits[v & 0xf]};
+    }
+
+    const Module& m;
+    std::optional<uint32_t> dataCount;
+    Reader& r;
+    Function& f;
+    std::vector<uint32_t>& code;
+    std::vector<ValType> locals;
+    std::vector<Operand> vals;
+    std::vector<Ctrl> ctrls;
+};
+
+} // namespace
+
+std::optional<uint32_t> Module::findExport(std::string_view name, ExternKind kind) const {
+    for (const Export& e : exports)
+        if (e.kind == kind && e.name == name) return e.index;
+    return std::nullopt;
+}
+
+Module decode(std::span<const uint8_t> bytes) {
+    Reader r(bytes.data(), bytes.data() + bytes.size(), bytes.data());
+    static const uint8_t header[8] = {0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00};
+    if (bytes.size() < 8 || std::memcmp(r.take(8), header, 8) != 0) fail("not a wasm 1.0 module", 0);
+
+    Module m;
+    std::vector<uint32_t> funcTypes; // from the function section
+    std::optional<uint32_t> dataCount;
+    uint8_t lastId = 0;
+    bool sawCode = false;
+
+    auto checkType = [&](Reader& s, uint32_t index) {
+        if (index >= m.types.size()) s.error("type index out of range");
+        return index;
+    };
+    auto checkFunc = [&](Reader& s, uint32_t index) {
+        if (index >= m.imports.size() + funcTypes.size()) s.error("function index out of range");
+        return index;
+    };
+
+    while (!r.done()) {
+        const uint8_t id = r.u8();
+        const uint32_t size = r.u32();
+        Reader s = r.sub(size);
+        if (id == 0) continue; // custom section
+        // the data count section (12) sits between imports/exports and code
+        const uint8_t order = id == 12 ? 10 : id >= 10 ? id + 1 : id;
+        if (order <= lastId) s.error("section out of order or repeated");
+        lastId = order;
+
+        switch (id) {
+        case 1: { // type
+            for (uint32_t n = s.u32(); n > 0; --n) {
+                if (s.u8() != 0x60) s.error("expected function type");
+                FuncType t;
+                for (uint32_t k = s.u32(); k > 0; --k) t.params.push_back(s.valType());
+                for (uint32_t k = s.u32(); k > 0; --k) t.results.push_back(s.valType());
+                m.types.push_back(std::move(t));
+            }
+            break;
+        }
+        case 2: { // import
+            for (uint32_t n = s.u32(); n > 0; --n) {
+                Import imp;
+                imp.module = s.name();
+                imp.name = s.name();
+                if (s.u8() != 0) s.error("only function imports are supported");
+                imp.typeIndex = checkType(s, s.u32());
+                m.imports.push_back(std::move(imp));
+            }
+            break;
+        }
+        case 3: // function
+            for (uint32_t n = s.u32(); n > 0; --n) funcTypes.push_back(checkType(s, s.u32()));
+            break;
+        case 4: { // table
+            const uint32_t n = s.u32();
+            if (n > 1) s.error("at most one table");
+            if (n == 1) {
+                if (s.u8() != 0x70) s.error("only funcref tables are supported");
+                m.table = readLimits(s);
+            }
+            break;
+        }
+        case 5: { // memory
+            const uint32_t n = s.u32();
+            if (n > 1) s.error("at most one memory");
+            if (n == 1) {
+                m.memory = readLimits(s);
+                if (m.memory->min > 65536 || (m.memory->max && *m.memory->max > 65536)) s.error("memory too large");
+            }
+            break;
+        }
+        case 6: { // global
+            for (uint32_t n = s.u32(); n > 0; --n) {
+                Global g;
+                g.type = s.valType();
+                const uint8_t mut = s.u8();
+                if (mut > 1) s.error("bad global mutability");
+                g.isMutable = mut == 1;
+                g.init = readConstExpr(s, m, g.type);
+                m.globals.push_back(g);
+            }
+            break;
+        }
+        case 7: { // export
+            for (uint32_t n = s.u32(); n > 0; --n) {
+                Export e;
+                e.name = s.name();
+                const uint8_t kind = s.u8();
+                e.index = s.u32();
+                e.kind = static_cast<ExternKind>(kind);
+                const bool ok = (kind == 0 && e.index < m.imports.size() + funcTypes.size()) ||
+                                (kind == 1 && m.table && e.index == 0) || (kind == 2 && m.memory && e.index == 0) ||
+                                (kind == 3 && e.index < m.globals.size());
+                if (!ok) s.error("bad export " + e.name);
+                for (const Export& other : m.exports)
+                    if (other.name == e.name) s.error("duplicate export " + e.name);
+                m.exports.push_back(std::move(e));
+            }
+            break;
+        }
+        case 8: { // start
+            m.start = checkFunc(s, s.u32());
+            break;
+        }
+        case 9: { // element
+            for (uint32_t n = s.u32(); n > 0; --n) {
+                if (s.u32() != 0) s.error("only active funcref element segments are supported");
+                if (!m.table) s.error("element segment without table");
+                ElemSegment seg;
+                seg.offset = static_cast<uint32_t>(readConstExpr(s, m, ValType::I32));
+                for (uint32_t k = s.u32(); k > 0; --k) seg.funcs.push_back(checkFunc(s, s.u32()));
+                m.elements.push_back(std::move(seg));
+            }
+            break;
+        }
+        case 10: { // code
+            const uint32_t n = s.u32();
+            if (n != funcTypes.size()) s.error("function and code section sizes differ");
+            m.functions.resize(n);
+            for (uint32_t i = 0; i < n; ++i) m.functions[i].typeIndex = funcTypes[i];
+            for (uint32_t i = 0; i < n; ++i) {
+                Reader body = s.sub(s.u32());
+                BodyCompiler(m, dataCount, body, m.functions[i]).compile();
+            }
+            sawCode = true;
+            break;
+        }
+        case 11: { // data
+            const uint32_t n = s.u32();
+            if (dataCount && n != *dataCount) s.error("data count mismatch");
+            for (uint32_t k = 0; k < n; ++k) {
+                const uint32_t flag = s.u32();
+                DataSegment seg;
+                seg.active = flag != 1;
+                if (flag == 2 && s.u32() != 0) s.error("memory index must be 0");
+                if (flag > 2) s.error("bad data segment flag");
+                if (seg.active) {
+                    if (!m.memory) s.error("data segment without memory");
+                    seg.offset = static_cast<uint32_t>(readConstExpr(s, m, ValType::I32));
+                }
+                const uint32_t len = s.u32();
+                const uint8_t* p = s.take(len);
+                seg.bytes.assign(p, p + len);
+                m.data.push_back(std::move(seg));
+            }
+            break;
+        }
+        case 12: // data count
+            dataCount = s.u32();
+            break;
+        default:
+            s.error("unknown section " + std::to_string(id));
+        }
+        if (!s.done()) s.error("section size mismatch");
+    }
+
+    if (!sawCode && !funcTypes.empty()) fail("function section without code section", bytes.size());
+    if (m.start) {
+        const FuncType& t = m.funcType(*m.start);
+        if (!t.params.empty() || !t.results.empty()) fail("start function must take and return nothing", 0);
+    }
+    return m;
+}
+
+} // namespace wasm
@@ -0,0 +1,557 @@
+#include "wasm.h"
+#include "wasm_ops.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+// Values live on one uint64_t stack; a frame is its locals (params first)
+// followed by its operands, and a call's arguments become the callee's first
+// locals in place. Memory is little-endian, as on every host this targets.
+
+namespace wasm {
+
+namespace {
+
+float f32(uint64_t v) { return std::bit_cast<float>(static_cast<uint32_t>(v)); }
+double f64(uint64_t v) { return std::bit_cast<double>(v); }
+uint64_t bits(float f) { return std::bit_cast<uint32_t>(f); }
+uint64_t bits(double d) { return std::bit_cast<uint64_t>(d); }
+
+template <typename F>
+F wasmMin(F a, F b) {
+    if (std::isnan(a) || std::isnan(b)) return a + b;
+    if (a == 0 && b == 0) return std::signbit(a) ? a : b;
+    return a < b ? a : b;
+}
+
+template <typename F>
+F wasmMax(F a, F b) {
+    if (std::isnan(a) || std::isnan(b)) return a + b;
+    if (a == 0 && b == 0) return std::signbit(a) ? b : a;
+    return a > b ? a : b;
+}
+
+// the range of I as [lo, hi) in F; both bounds are powers of two, so exact
+template <typename I, typename F>
+std::pair<F, F> intRange() {
+    const F hi = std::ldexp(F(1), std::numeric_limits<I>::digits);
+    return {std::is_signed_v<I> ? -hi : F(0), hi};
+}
+
+template <typename I, typename F>
+I truncChecked(F x) {
+    if (std::isnan(x)) throw Trap("invalid conversion to integer");
+    const F t = std::trunc(x);
+    const auto [lo, hi] = intRange<I, F>();
+    if (!(t >= lo && t < hi)) throw Trap("integer overflow");
+    return static_cast<I>(t);
+}
+
+template <typename I, typename F>
+I truncSaturating(F x) {
+    if (std::isnan(x)) return 0;
+    const F t = std::trunc(x);
+    const auto [lo, hi] = intRange<I, F>();
+    if (t < lo) return std::numeric_limits<I>::min();
+    if (t >= hi) return std::numeric_limits<I>::max();
+    return static_cast<I>(t);
+}
+
+template <typename T>
+T divSigned(T a, T b) {
+    if (b == 0) throw Trap("integer divide by zero");
+    if (a == std::numeric_limits<T>::min() && b == -1) throw Trap("integer overflow");
+    return a / b;
+}
+
+template <typename T>
+T remSigned(T a, T b) {
+    if (b == 0) throw Trap("integer divide by zero");
+    return b == -1 ? 0 : a % b;
+}
+
+template <typename T>
+T divUnsigned(T a, T b) {
+    if (b == 0) throw Trap("integer divide by zero");
+    return a / b;
+}
+
+template <typename T>
+T remUnsigned(T a, T b) {
+    if (b == 0) throw Trap("integer divide by zero");
+    return a % b;
+}
+
+[[noreturn]] void outOfBounds() { throw Trap("out of bounds memory access"); }
+
+} // namespace
+
+Instance::Instance(const Module& module, const Imports& imports) : mod(module) {
+    for (const Import& imp : mod.imports) {
+        auto it = imports.find({imp.module, imp.name});
+        if (it == imports.end()) throw Trap("unknown import " + imp.module + "." + imp.name);
+        if (!(it->second.type == mod.types[imp.typeIndex]))
+            throw Trap("import " + imp.module + "." + imp.name + " has the wrong type");
+        hosts.push_back(&it->second);
+    }
+
+    if (mod.memory) mem.resize(size_t{mod.memory->min} * kPageSize);
+    for (const Global& g : mod.globals) globals.push_back(g.init);
+
+    if (mod.table) table.resize(mod.table->min);
+    for (const ElemSegment& seg : mod.elements) {
+        if (uint64_t{seg.offset} + seg.funcs.size() > table.size()) throw Trap("out of bounds table access");
+        std::copy(seg.funcs.begin(), seg.funcs.end(), table.begin() + seg.offset);
+    }
+
+    // active segments are dropped once copied in
+    droppedData.resize(mod.data.size());
+    for (size_t i = 0; i < mod.data.size(); ++i) {
+        const DataSegment& seg = mod.data[i];
+        if (!seg.active) continue;
+        if (uint64_t{seg.offset} + seg.bytes.size() > mem.size()) outOfBounds();
+        std::copy(seg.bytes.begin(), seg.bytes.end(), mem.begin() + seg.offset);
+        droppedData[i] = true;
+    }
+
+    stack.resize(kStackSlots);
+    frames.reserve(kMaxCallDepth);
+    if (mod.start) call(*mod.start, {});
+}
+
+std::vector<uint64_t> Instance::invoke(std::string_view exportName, std::span<const uint64_t> args) {
+    const auto index = mod.findExport(exportName, ExternKind::Func);
+    if (!index) throw Trap("no exported function " + std::string(exportName));
+    return call(*index, args);
+}
+
+std::vector<uint64_t> Instance::call(uint32_t funcIndex, std::span<const uint64_t> args) {
+    if (!frames.empty()) throw Trap("host functions cannot call back into the instance");
+    const FuncType& type = mod.funcType(funcIndex);
+    if (args.size() != type.params.size()) throw Trap("wrong number of arguments");
+
+    std::copy(args.begin(), args.end(), stack.begin());
+    try {
+        if (funcIndex < mod.imports.size())
+            callHost(funcIndex, stack.data());
+        else
+            execute(static_cast<uint32_t>(funcIndex - mod.imports.size()), stack.data());
+    } catch (...) {
+        frames.clear();
+        throw;
+    }
+    return {stack.begin(), stack.begin() + static_cast<ptrdiff_t>(type.results.size())};
+}
+
+void Instance::callHost(uint32_t importIndex, uint64_t* sp) {
+    const FuncType& type = mod.types[mod.imports[importIndex].typeIndex];
+    // the results overwrite the arguments, so hand the host a copy
+    const std::vector<uint64_t> args(sp, sp + type.params.size());
+    hosts[importIndex]->fn(*this, args, std::span<uint64_t>(sp, type.results.size()));
+}
+
+int64_t Instance::growMemory(uint32_t pages) {
+    const uint64_t old = mem.size() / kPageSize;
+    const uint64_t max = mod.memory->max.value_or(65536);
+    if (old + pages > max) return -1;
+    try {
+        mem.resize((old + pages) * kPageSize);
+    } catch (const std::bad_alloc&) {
+        return -1;
+    }
+    return static_cast<int64_t>(old);
+}
+
+void Instance::execute(uint32_t funcIndex, uint64_t* args) {
+    const size_t entryDepth = frames.size();
+    uint64_t* const stackEnd = stack.data() + stack.size();
+    uint8_t* memBase = mem.data();
+    uint64_t memSize = mem.size();
+
+    const Function* f = &mod.functions[funcIndex];
+    const uint32_t* code = f->code.data();
+    const uint32_t* pc = code;
+    uint64_t* fp = args;
+    uint64_t* sp;
+
+    // pushes a frame for f whose arguments start at fp
+    auto enter = [&](const uint32_t* ret) {
+        if (frames.size() == kMaxCallDepth || stackEnd - fp < static_cast<ptrdiff_t>(f->numLocals + f->maxStack))
+            throw Trap("call stack exhausted");
+        const size_t params = mod.types[f->typeIndex].params.size();
+        std::fill(fp + params, fp + f->numLocals, 0);
+        frames.push_back(Frame{ret, fp, f});
+        code = f->code.data();
+        pc = code;
+        sp = fp + f->numLocals;
+    };
+    auto branch = [&](const uint32_t* imm) {
+        const uint32_t arity = imm[2];
+        uint64_t* dst = fp + imm[1];
+        std::memmove(dst, sp - arity, arity * sizeof(uint64_t));
+        sp = dst + arity;
+        pc = code + imm[0];
+    };
+    auto address = [&](uint64_t base, size_t size) {
+        const uint64_t ea = static_cast<uint32_t>(base) + uint64_t{*pc++};
+        if (ea + size > memSize) outOfBounds();
+        return memBase + ea;
+    };
+
+    enter(nullptr);
+
+#define I32_UN(expr) { const uint32_t a = static_cast<uint32_t>(sp[-1]); sp[-1] = static_cast<uint32_t>(expr); } break
+#define I64_UN(expr) { const uint64_t a = sp[-1]; sp[-1] = static_cast<uint64_t>(expr); } break
+#define I32_BIN(expr) { const uint32_t b = static_cast<uint32_t>(*--sp), a = static_cast<uint32_t>(sp[-1]); sp[-1] = static_cast<uint32_t>(expr); } break
+#define I64_BIN(expr) { const uint64_t b = *--sp, a = sp[-1]; sp[-1] = static_cast<uint64_t>(expr); } break
+#define S32(x) static_cast<int32_t>(x)
+#define S64(x) static_cast<int64_t>(x)
+#define F32_UN(expr) { const float a = f32(sp[-1]); sp[-1] = bits(static_cast<float>(expr)); } break
+#define F64_UN(expr) { const double a = f64(sp[-1]); sp[-1] = bits(static_cast<double>(expr)); } break
+#define F32_BIN(expr) { const float b = f32(*--sp), a = f32(sp[-1]); sp[-1] = bits(static_cast<float>(expr)); } break
+#define F64_BIN(expr) { const double b = f64(*--sp), a = f64(sp[-1]); sp[-1] = bits(static_cast<double>(expr)); } break
+#define F32_CMP(expr) { const float b = f32(*--sp), a = f32(sp[-1]); sp[-1] = (expr); } break
+#define F64_CMP(expr) { const double b = f64(*--sp), a = f64(sp[-1]); sp[-1] = (expr); } break
+// R is uint32_t for i32/f32 results, uint64_t for i64/f64: converting a
+// signed T sign-extends, an unsigned one zero-extends
+#define LOAD(T, R) { T v; std::memcpy(&v, address(sp[-1], sizeof(T)), sizeof(T)); sp[-1] = static_cast<R>(v); } break
+#define STORE(T) { const T v = static_cast<T>(sp[-1]); std::memcpy(address(sp[-2], sizeof(T)), &v, sizeof(T)); sp -= 2; } break
+
+    for (;;) {
+        switch (*pc++) {
+        case op::kUnreachable: throw Trap("unreachable executed");
+
+        case op::kJmp: pc = code + *pc; break;
+        case op::kBr: branch(pc); break;
+        case op::kBrIf:
+            if (static_cast<uint32_t>(*--sp)) branch(pc);
+            else pc += 3;
+            break;
+        case op::kJnz:
+            if (static_cast<uint32_t>(*--sp)) pc = code + *pc;
+            else ++pc;
+            break;
+        case op::kJz:
+            if (!static_cast<uint32_t>(*--sp)) pc = code + *pc;
+            else ++pc;
+            break;
+        case op::kBrTable: {
+            const uint32_t n = *pc;
+            const uint32_t i = std::min(static_cast<uint32_t>(*--sp), n);
+            branch(pc + 1 + 3 * i);
+            break;
+        }
+        case op::kReturn: {
+            const uint32_t arity = *pc;
+            const Frame done = frames.back();
+            frames.pop_back();
+            std::memmove(done.fp, sp - arity, arity * sizeof(uint64_t));
+            if (frames.size() == entryDepth) return;
+            sp = done.fp + arity;
+            fp = frames.back().fp;
+            f = frames.back().func;
+            code = f->code.data();
+            pc = done.ret;
+            break;
+        }
+        case op::kCall: {
+            const uint32_t index = *pc;
+            f = &mod.functions[index];
+            fp = sp - mod.types[f->typeIndex].params.size();
+            enter(pc + 1);
+            break;
+        }
+        case op::kCallIndirect: {
+            const FuncType& type = mod.types[*pc];
+            const uint32_t i = static_cast<uint32_t>(*--sp);
+            if (i >= table.size()) throw Trap("undefined element");
+            if (!table[i]) throw Trap("uninitialized element");
+            const uint32_t target = *table[i];
+            if (!(mod.funcType(target) == type)) throw Trap("indirect call type mismatch");
+            uint64_t* args = sp - type.params.size();
+            if (target < mod.imports.size()) {
+                callHost(target, args);
+                sp = args + type.results.size();
+                memBase = mem.data();
+                memSize = mem.size();
+                ++pc;
+            } else {
+                f = &mod.functions[target - mod.imports.size()];
+                fp = args;
+                enter(pc + 1);
+            }
+            break;
+        }
+        case op::kCallHost: {
+            const uint32_t index = *pc++;
+            const FuncType& type = mod.types[mod.imports[index].typeIndex];
+            uint64_t* args = sp - type.params.size();
+            callHost(index, args);
+            sp = args + type.results.size();
+            memBase = mem.data(); // the host may have grown memory
+            memSize = mem.size();
+            break;
+        }
+
+        case op::kDrop: --sp; break;
+        case op::kSelect: {
+            const uint32_t c = static_cast<uint32_t>(*--sp);
+            const uint64_t b = *--sp;
+            if (!c) sp[-1] = b;
+            break;
+        }
+
+        case op::kLocalGet: *sp++ = fp[*pc++]; break;
+        case op::kLocalSet: fp[*pc++] = *--sp; break;
+        case op::kLocalTee: fp[*pc++] = sp[-1]; break;
+        case op::kGlobalGet: *sp++ = globals[*pc++]; break;
+        case op::kGlobalSet: globals[*pc++] = *--sp; break;
+
+        case 0x28: LOAD(uint32_t, uint32_t);
+        case 0x29: LOAD(uint64_t, uint64_t);
+        case 0x2a: LOAD(uint32_t, uint32_t);
+        case 0x2b: LOAD(uint64_t, uint64_t);
+        case 0x2c: LOAD(int8_t, uint32_t);
+        case 0x2d: LOAD(uint8_t, uint32_t);
+        case 0x2e: LOAD(int16_t, uint32_t);
+        case 0x2f: LOAD(uint16_t, uint32_t);
+        case 0x30: LOAD(int8_t, uint64_t);
+        case 0x31: LOAD(uint8_t, uint64_t);
+        case 0x32: LOAD(int16_t, uint64_t);
+        case 0x33: LOAD(uint16_t, uint64_t);
+        case 0x34: LOAD(int32_t, uint64_t);
+        case 0x35: LOAD(uint32_t, uint64_t);
+        case 0x36: STORE(uint32_t);
+        case 0x37: STORE(uint64_t);
+        case 0x38: STORE(uint32_t);
+        case 0x39: STORE(uint64_t);
+        case 0x3a: STORE(uint8_t);
+        case 0x3b: STORE(uint16_t);
+        case 0x3c: STORE(uint8_t);
+        case 0x3d: STORE(uint16_t);
+        case 0x3e: STORE(uint32_t);
+
+        case op::kMemorySize: *sp++ = memSize / kPageSize; break;
+        case op::kMemoryGrow:
+            sp[-1] = static_cast<uint32_t>(growMemory(static_cast<uint32_t>(sp[-1])));
+            memBase = mem.data();
+            memSize = mem.size();
+            break;
+
+        case op::kI32Const: *sp++ = *pc++; break;
+        case op::kF32Const: *sp++ = *pc++; break;
+        case op::kI64Const:
+        case op::kF64Const:
+            *sp++ = pc[0] | uint64_t{pc[1]} << 32;
+            pc += 2;
+            break;
+
+        case 0x45: I32_UN(a == 0);
+        case 0x46: I32_BIN(a == b);
+        case 0x47: I32_BIN(a != b);
+        case 0x48: I32_BIN(S32(a) < S32(b));
+        case 0x49: I32_BIN(a < b);
+        case 0x4a: I32_BIN(S32(a) > S32(b));
+        case 0x4b: I32_BIN(a > b);
+        case 0x4c: I32_BIN(S32(a) <= S32(b));
+        case 0x4d: I32_BIN(a <= b);
+        case 0x4e: I32_BIN(S32(a) >= S32(b));
+        case 0x4f: I32_BIN(a >= b);
+
+        case 0x50: I64_UN(a == 0);
+        case 0x51: I64_BIN(a == b);
+        case 0x52: I64_BIN(a != b);
+        case 0x53: I64_BIN(S64(a) < S64(b));
+        case 0x54: I64_BIN(a < b);
+        case 0x55: I64_BIN(S64(a) > S64(b));
+        case 0x56: I64_BIN(a > b);
+        case 0x57: I64_BIN(S64(a) <= S64(b));
+        case 0x58: I64_BIN(a <= b);
+        case 0x59: I64_BIN(S64(a) >= S64(b));
+        case 0x5a: I64_BIN(a >= b);
+
+        case 0x5b: F32_CMP(a == b);
+        case 0x5c: F32_CMP(a != b);
+        case 0x5d: F32_CMP(a < b);
+        case 0x5e: F32_CMP(a > b);
+        case 0x5f: F32_CMP(a <= b);
+        case 0x60: F32_CMP(a >= b);
+        case 0x61: F64_CMP(a == b);
+        case 0x62: F64_CMP(a != b);
+        case 0x63: F64_CMP(a < b);
+        case 0x64: F64_CMP(a > b);
+        case 0x65: F64_CMP(a <= b);
+        case 0x66: F64_CMP(a >= b);
+
+        case 0x67: I32_UN(std::countl_zero(a));
+        case 0x68: I32_UN(std::countr_zero(a));
+        case 0x69: I32_UN(std::popcount(a));
+        case 0x6a: I32_BIN(a + b);
+        case 0x6b: I32_BIN(a - b);
+        case 0x6c: I32_BIN(a * b);
+        case 0x6d: I32_BIN(divSigned(S32(a), S32(b)));
+        case 0x6e: I32_BIN(divUnsigned(a, b));
+        case 0x6f: I32_BIN(remSigned(S32(a), S32(b)));
+        case 0x70: I32_BIN(remUnsigned(a, b));
+        case 0x71: I32_BIN(a & b);
+        case 0x72: I32_BIN(a | b);
+        case 0x73: I32_BIN(a ^ b);
+        case 0x74: I32_BIN(a << (b & 31));
+        case 0x75: I32_BIN(S32(a) >> (b & 31));
+        case 0x76: I32_BIN(a >> (b & 31));
+        case 0x77: I32_BIN(std::rotl(a, static_cast<int>(b & 31)));
+        case 0x78: I32_BIN(std::rotr(a, static_cast<int>(b & 31)));
+
+        case 0x79: I64_UN(std::countl_zero(a));
+        case 0x7a: I64_UN(std::countr_zero(a));
+        case 0x7b: I64_UN(std::popcount(a));
+        case 0x7c: I64_BIN(a + b);
+        case 0x7d: I64_BIN(a - b);
+        case 0x7e: I64_BIN(a * b);
+        case 0x7f: I64_BIN(divSigned(S64(a), S64(b)));
+        case 0x80: I64_BIN(divUnsigned(a, b));
+        case 0x81: I64_BIN(remSigned(S64(a), S64(b)));
+        case 0x82: I64_BIN(remUnsigned(a, b));
+        case 0x83: I64_BIN(a & b);
+        case 0x84: I64_BIN(a | b);
+        case 0x85: I64_BIN(a ^ b);
+        case 0x86: I64_BIN(a << (b & 63));
+        case 0x87: I64_BIN(S64(a) >> (b & 63));
+        case 0x88: I64_BIN(a >> (b & 63));
+        case 0x89: I64_BIN(std::rotl(a, static_cast<int>(b & 63)));
+        case 0x8a: I64_BIN(std::rotr(a, static_cast<int>(b & 63)));
+
+        // abs, neg and copysign only touch the sign bit, NaN payloads included
+        case 0x8b: sp[-1] &= 0x7fffffffu; break;
+        case 0x8c: sp[-1] ^= 0x80000000u; break;
+        case 0x8d: F32_UN(std::ceil(a));
+        case 0x8e: F32_UN(std::floor(a));
+        case 0x8f: F32_UN(std::trunc(a));
+        case 0x90: F32_UN(std::nearbyint(a));
+        case 0x91: F32_UN(std::sqrt(a));
+        case 0x92: F32_BIN(a + b);
+        case 0x93: F32_BIN(a - b);
+        case 0x94: F32_BIN(a * b);
+        case 0x95: F32_BIN(a / b);
+        case 0x96: F32_BIN(wasmMin(a, b));
+        case 0x97: F32_BIN(wasmMax(a, b));
+        case 0x98: {
+            const uint64_t b = *--sp;
+            sp[-1] = (sp[-1] & 0x7fffffffu) | (b & 0x80000000u);
+            break;
+        }
+
+        case 0x99: sp[-1] &= ~(uint64_t{1} << 63); break;
+        case 0x9a: sp[-1] ^= uint64_t{1} << 63; break;
+        case 0x9b: F64_UN(std::ceil(a));
+        case 0x9c: F64_UN(std::floor(a));
+        case 0x9d: F64_UN(std::trunc(a));
+        case 0x9e: F64_UN(std::nearbyint(a));
+        case 0x9f: F64_UN(std::sqrt(a));
+        case 0xa0: F64_BIN(a + b);
+        case 0xa1: F64_BIN(a - b);
+        case 0xa2: F64_BIN(a * b);
+        case 0xa3: F64_BIN(a / b);
+        case 0xa4: F64_BIN(wasmMin(a, b));
+        case 0xa5: F64_BIN(wasmMax(a, b));
+        case 0xa6: {
+            const uint64_t b = *--sp;
+            const uint64_t sign = uint64_t{1} << 63;
+            sp[-1] = (sp[-1] & ~sign) | (b & sign);
+            break;
+        }
+
+        case 0xa7: sp[-1] = static_cast<uint32_t>(sp[-1]); break;
+        case 0xa8: sp[-1] = static_cast<uint32_t>(truncChecked<int32_t>(f32(sp[-1]))); break;
+        case 0xa9: sp[-1] = truncChecked<uint32_t>(f32(sp[-1])); break;
+        case 0xaa: sp[-1] = static_cast<uint32_t>(truncChecked<int32_t>(f64(sp[-1]))); break;
+        case 0xab: sp[-1] = truncChecked<uint32_t>(f64(sp[-1])); break;
+        case 0xac: I64_UN(S64(S32(a)));
+        case 0xad: I64_UN(static_cast<uint32_t>(a));
+        case 0xae: sp[-1] = static_cast<uint64_t>(truncChecked<int64_t>(f32(sp[-1]))); break;
+        case 0xaf: sp[-1] = truncChecked<uint64_t>(f32(sp[-1])); break;
+        case 0xb0: sp[-1] = static_cast<uint64_t>(truncChecked<int64_t>(f64(sp[-1]))); break;
+        case 0xb1: sp[-1] = truncChecked<uint64_t>(f64(sp[-1])); break;
+        case 0xb2: sp[-1] = bits(static_cast<float>(S32(sp[-1]))); break;
+        case 0xb3: sp[-1] = bits(static_cast<float>(static_cast<uint32_t>(sp[-1]))); break;
+        case 0xb4: sp[-1] = bits(static_cast<float>(S64(sp[-1]))); break;
+        case 0xb5: sp[-1] = bits(static_cast<float>(sp[-1])); break;
+        case 0xb6: sp[-1] = bits(static_cast<float>(f64(sp[-1]))); break;
+        case 0xb7: sp[-1] = bits(static_cast<double>(S32(sp[-1]))); break;
+        case 0xb8: sp[-1] = bits(static_cast<double>(static_cast<uint32_t>(sp[-1]))); break;
+        case 0xb9: sp[-1] = bits(static_cast<double>(S64(sp[-1]))); break;
+        case 0xba: sp[-1] = bits(static_cast<double>(sp[-1])); break;
+        case 0xbb: sp[-1] = bits(static_cast<double>(f32(sp[-1]))); break;
+        case 0xbc: // reinterpretations: the bits are already in place
+        case 0xbd:
+        case 0xbe:
+        case 0xbf: break;
+        case 0xc0: I32_UN(static_cast<int8_t>(a));
+        case 0xc1: I32_UN(static_cast<int16_t>(a));
+        case 0xc2: I64_UN(static_cast<int8_t>(a));
+        case 0xc3: I64_UN(static_cast<int16_t>(a));
+        case 0xc4: I64_UN(static_cast<int32_t>(a));
+
+        case op::kPrefixFC + 0: sp[-1] = static_cast<uint32_t>(truncSaturating<int32_t>(f32(sp[-1]))); break;
+        case op::kPrefixFC + 1: sp[-1] = truncSaturating<uint32_t>(f32(sp[-1])); break;
+        case op::kPrefixFC + 2: sp[-1] = static_cast<uint32_t>(truncSaturating<int32_t>(f64(sp[-1]))); break;
+        case op::kPrefixFC + 3: sp[-1] = truncSaturating<uint32_t>(f64(sp[-1])); break;
+        case op::kPrefixFC + 4: sp[-1] = static_cast<uint64_t>(truncSaturating<int64_t>(f32(sp[-1]))); break;
+        case op::kPrefixFC + 5: sp[-1] = truncSaturating<uint64_t>(f32(sp[-1])); break;
+        case op::kPrefixFC + 6: sp[-1] = static_cast<uint64_t>(truncSaturating<int64_t>(f64(sp[-1]))); break;
+        case op::kPrefixFC + 7: sp[-1] = truncSaturating<uint64_t>(f64(sp[-1])); break;
+
+        case op::kMemoryInit: {
+            const uint32_t segment = *pc++;
+            const uint64_t n = static_cast<uint32_t>(sp[-1]), src = static_cast<uint32_t>(sp[-2]),
+                           dst = static_cast<uint32_t>(sp[-3]);
+            sp -= 3;
+            const size_t available = droppedData[segment] ? 0 : mod.data[segment].bytes.size();
+            if (src + n > available || dst + n > memSize) outOfBounds();
+            if (n) std::memcpy(memBase + dst, mod.data[segment].bytes.data() + src, n);
+            break;
+        }
+        case op::kDataDrop: droppedData[*pc++] = true; break;
+        case op::kMemoryCopy: {
+            const uint64_t n = static_cast<uint32_t>(sp[-1]), src = static_cast<uint32_t>(sp[-2]),
+                           dst = static_cast<uint32_t>(sp[-3]);
+            sp -= 3;
+            if (src + n > memSize || dst + n > memSize) outOfBounds();
+            std::memmove(memBase + dst, memBase + src, n);
+            break;
+        }
+        case op::kMemoryFill: {
+            const uint64_t n = static_cast<uint32_t>(sp[-1]), dst = static_cast<uint32_t>(sp[-3]);
+            const uint8_t value = static_cast<uint8_t>(sp[-2]);
+            sp -= 3;
+            if (dst + n > memSize) outOfBounds();
+            std::memset(memBase + dst, value, n);
+            break;
+        }
+
+        default: throw Trap("bad internal opcode " + std::to_string(pc[-1]));
+        }
+    }
+
+#undef I32_UN
+#undef I64_UN
+#undef I32_BIN
+#undef I64_BIN
+#undef S32
+#undef S64
+#undef F32_UN
+#undef F64_UN
+#undef F32_BIN
+#undef F64_BIN
+#undef F32_CMP
+#undef F64_CMP
+#undef LOAD
+#undef STORE
+}
+
+} // namespace wasm
@@ -0,0 +1,62 @@
+#pragma once
+
+// Internal bytecode shared by wasm_decode.cpp (which emits it) and
+// wasm_exec.cpp (which runs it). Every op is one uint32_t, followed by its
+// immediates.
+//
+// Numeric, variable, memory and parametric instructions keep their wasm
+// opcode; 0xFC-prefixed ones become 0x100 + subopcode. Structured control
+// flow is lowered to jumps with absolute targets:
+//
+//   kJmp     target
+//   kBr      target height arity    keep the top `arity` values, cut the
+//                                   stack to fp + height, then jump
+//   kBrIf    target height arity    the same, if the popped i32 is nonzero
+//   kJnz     target                 kBrIf with nothing to move
+//   kJz      target                 `if`: jump to else/end when zero
+//   kBrTable n, then n + 1 (target height arity) entries, default last
+//   kReturn  arity
+//   kCall    index into Module::functions
+//   kCallHost  import index
+//
+// Other immediates: local/global index, memory offset (alignment dropped),
+// i32/f32 const as one word, i64/f64 const as low then high word,
+// call_indirect type index, memory.init/data.drop segment index.
+
+#include <cstdint>
+
+namespace wasm::op {
+
+constexpr uint32_t kUnreachable = 0x00;
+constexpr uint32_t kCallIndirect = 0x11;
+constexpr uint32_t kDrop = 0x1a;
+constexpr uint32_t kSelect = 0x1b;
+constexpr uint32_t kLocalGet = 0x20;
+constexpr uint32_t kLocalSet = 0x21;
+constexpr uint32_t kLocalTee = 0x22;
+constexpr uint32_t kGlobalGet = 0x23;
+constexpr uint32_t kGlobalSet = 0x24;
+constexpr uint32_t kMemorySize = 0x3f;
+constexpr uint32_t kMemoryGrow = 0x40;
+constexpr uint32_t kI32Const = 0x41;
+constexpr uint32_t kI64Const = 0x42;
+constexpr uint32_t kF32Const = 0x43;
+constexpr uint32_t kF64Const = 0x44;
+
+constexpr uint32_t kPrefixFC = 0x100;
+constexpr uint32_t kMemoryInit = kPrefixFC + 8;
+constexpr uint32_t kDataDrop = kPrefixFC + 9;
+constexpr uint32_t kMemoryCopy = kPrefixFC + 10;
+constexpr uint32_t kMemoryFill = kPrefixFC + 11;
+
+constexpr uint32_t kJmp = 0x200;
+constexpr uint32_t kBr = 0x201;
+constexpr uint32_t kBrIf = 0x202;
+constexpr uint32_t kJnz = 0x203;
+constexpr uint32_t kJz = 0x204;
+constexpr uint32_t kBrTable = 0x205;
+constexpr uint32_t kReturn = 0x206;
+constexpr uint32_t kCall = 0x207;
+constexpr uint32_t kCallHost = 0x208;
+
+} // namespace wasm::op
@@ -0,0 +1,47 @@
+// Runs a WASI command module: decodes it, links the WASI shim and calls
+// _start. With no file it runs the built-in hello world.
+//
+//   g++ -std=c++20 -O2 wasm_decode.cpp wasm_exec.cpp wasi.cpp wasm_run.cpp -o wasm_run
+//   ./wasm_run [module.wasm [args...]]
+
+#include "wasi.h"
+#include "wasm.h"
+#include "wasm_samples.h"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+int main(int argc, char** argv) {
+    std::vector<uint8_t> bytes;
+    wasm::WasiOptions options;
+    if (argc > 1) {
+        std::ifstream in(argv[1], std::ios::binary);
+        if (!in) {
+            std::cerr << "cannot open " << argv[1] << "\n";
+            return 1;
+        }
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        options.args.assign(argv + 1, argv + argc);
+    } else {
+        bytes = wasm::samples::hello();
+        options.args = {"hello"};
+    }
+
+    try {
+        const wasm::Module module = wasm::decode(bytes);
+        wasm::Imports imports;
+        wasm::addWasi(imports, options);
+        wasm::Instance instance(module, imports);
+        instance.invoke("_start");
+    } catch (const wasm::Exit& e) {
+        return e.code;
+    } catch (const wasm::DecodeError& e) {
+        std::cerr << "invalid module: " << e.what() << "\n";
+        return 1;
+    } catch (const wasm::Trap& e) {
+        std::cerr << "trap: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+// Sample modules for wasm_run and wasm_bench, assembled in code so they
+// need no wat2wasm. Each builder's comment gives the equivalent text form.
+
+#include "wasm.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace wasm::samples {
+
+using Bytes = std::vector<uint8_t>;
+
+inline void uleb(Bytes& out, uint64_t v) {
+    do {
+        const uint8_t byte = v & 0x7f;
+        v >>= 7;
+        out.push_back(byte | (v ? 0x80 : 0));
+    } while (v);
+}
+
+// Collects sections and writes them in the order the binary format wants.
+// Function bodies are raw instruction bytes ending in 0x0b.
+class ModuleBuilder {
+public:
+    uint32_t type(const std::vector<ValType>& params, const std::vector<ValType>& results) {
+        types.push_back(0x60);
+        valTypes(types, params);
+        valTypes(types, results);
+        return typeCount++;
+    }
+
+    // imports come before any func()
+    uint32_t importFunc(std::string_view module, std::string_view field, uint32_t typeIndex) {
+        name(imports, module);
+        name(imports, field);
+        imports.push_back(0x00);
+        uleb(imports, typeIndex);
+        return importCount++;
+    }
+
+    uint32_t func(uint32_t typeIndex, const std::vector<std::pair<uint32_t, ValType>>& locals, const Bytes& body) {
+        uleb(funcs, typeIndex);
+        Bytes entry;
+        uleb(entry, locals.size());
+        for (auto [count, t] : locals) {
+            uleb(entry, count);
+            entry.push_back(static_cast<uint8_t>(t));
+        }
+        entry.insert(entry.end(), body.begin(), body.end());
+        uleb(code, entry.size());
+        code.insert(code.end(), entry.begin(), entry.end());
+        return importCount + funcCount++;
+    }
+
+    void memory(uint32_t minPages) { memoryPages = minPages; }
+
+    void exportFunc(std::string_view field, uint32_t funcIndex) { exportEntry(field, 0x00, funcIndex); }
+    void exportMemory(std::string_view field) { exportEntry(field, 0x02, 0); }
+
+    void data(uint32_t offset, std::string_view bytes) {
+        datas.push_back(0x00);
+        datas.push_back(0x41); // i32.const offset
+        sleb32(datas, static_cast<int32_t>(offset));
+        datas.push_back(0x0b);
+        name(datas, bytes);
+        ++dataCount;
+    }
+
+    Bytes build() const {
+        Bytes out = {0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00};
+        section(out, 1, typeCount, types);
+        section(out, 2, importCount, imports);
+        section(out, 3, funcCount, funcs);
+        if (memoryPages) {
+            Bytes mem = {0x00};
+            uleb(mem, *memoryPages);
+            section(out, 5, 1, mem);
+        }
+        section(out, 7, exportCount, exports);
+        section(out, 10, funcCount, code);
+        section(out, 11, dataCount, datas);
+        return out;
+    }
+
+private:
+    static void valTypes(Bytes& out, const std::vector<ValType>& ts) {
+        uleb(out, ts.size());
+        for (ValType t : ts) out.push_back(static_cast<uint8_t>(t));
+    }
+
+    static void name(Bytes& out, std::string_view s) {
+        uleb(out, s.size());
+        out.insert(out.end(), s.begin(), s.end());
+    }
+
+    static void sleb32(Bytes& out, int32_t v) {
+        for (;;) {
+            const uint8_t byte = v & 0x7f;
+            v >>= 7;
+            if ((v == 0 && !(byte & 0x40)) || (v == -1 && (byte & 0x40))) {
+                out.push_back(byte);
+                return;
+            }
+            out.push_back(byte | 0x80);
+        }
+    }
+
+    static void section(Bytes& out, uint8_t id, uint32_t count, const Bytes& entries) {
+        if (count == 0) return;
+        Bytes body;
+        uleb(body, count);
+        body.insert(body.end(), entries.begin(), entries.end());
+        out.push_back(id);
+        uleb(out, body.size());
+        out.insert(out.end(), body.begin(), body.end());
+    }
+
+    void exportEntry(std::string_view field, uint8_t kind, uint32_t index) {
+        name(exports, field);
+        exports.push_back(kind);
+        uleb(exports, index);
+        ++exportCount;
+    }
+
+    Bytes types, imports, funcs, exports, code, datas;
+    uint32_t typeCount = 0, importCount = 0, funcCount = 0, exportCount = 0, dataCount = 0;
+    std::optional<uint32_t> memoryPages;
+};
+
+constexpr ValType I32 = ValType::I32;
+constexpr ValType I64 = ValType::I64;
+
+// (import "wasi_snapshot_preview1" "fd_write" (func $fd_write (param i32 i32 i32 i32) (result i32)))
+// (memory (export "memory") 1)
+// (data (i32.const 16) "Hello world from wasm\n")
+// (func (export "_start")
+//   (i32.store (i32.const 0) (i32.const 16))   ;; iov.base
+//   (i32.store (i32.const 4) (i32.const 22))   ;; iov.len
+//   (drop (call $fd_write (i32.const 1) (i32.const 0) (i32.const 1) (i32.const 8))))
+inline Bytes hello() {
+    ModuleBuilder b;
+    const uint32_t fdWrite = b.importFunc("wasi_snapshot_preview1", "fd_write", b.type({I32, I32, I32, I32}, {I32}));
+    const uint32_t start = b.func(b.type({}, {}), {},
+                                  {
+                                      0x41, 0,  0x41, 16, 0x36, 2, 0, // i32.store (0) 16
+                                      0x41, 4,  0x41, 22, 0x36, 2, 0, // i32.store (4) 22
+                                      0x41, 1,  0x41, 0,  0x41, 1, 0x41, 8, 0x10, static_cast<uint8_t>(fdWrite),
+                                      0x1a, 0x0b,
+                                  });
+    b.memory(1);
+    b.exportMemory("memory");
+    b.exportFunc("_start", start);
+    b.data(16, "Hello world from wasm\n");
+    return b.build();
+}
+
+// (func $fib (export "fib") (param $n i32) (result i32)
+//   (if (result i32) (i32.lt_u (local.get $n) (i32.const 2))
+//     (then (local.get $n))
+//     (else (i32.add (call $fib (i32.sub (local.get $n) (i32.const 1)))
+//                    (call $fib (i32.sub (local.get $n) (i32.const 2)))))))
+inline Bytes fib() {
+    ModuleBuilder b;
+    const uint32_t f = b.func(b.type({I32}, {I32}), {},
+                              {
+                                  0x20, 0, 0x41, 2, 0x49,       // n < 2
+                                  0x04, 0x7f,                   // if (result i32)
+                                  0x20, 0,                      //   n
+                                  0x05,                         // else
+                                  0x20, 0, 0x41, 1, 0x6b, 0x10, 0, //   fib(n - 1)
+                                  0x20, 0, 0x41, 2, 0x6b, 0x10, 0, //   fib(n - 2)
+                                  0x6a,                         //   +
+                                  0x0b, 0x0b,
+                              });
+    b.exportFunc("fib", f);
+    return b.build();
+}
+
+// (func (export "sum") (param $n i64) (result i64) (local $i i64) (local $s i64)
+//   (block (loop
+//     (br_if 1 (i64.ge_s (local.get $i) (local.get $n)))
+//     (local.set $s (i64.add (local.get $s) (local.get $i)))
+//     (local.set $i (i64.add (local.get $i) (i64.const 1)))
+//     (br 0)))
+//   (local.get $s))
+inline Bytes loopSum() {
+    ModuleBuilder b;
+    const uint32_t f = b.func(b.type({I64}, {I64}), {{2, I64}},
+                              {
+                                  0x02, 0x40, 0x03, 0x40,                         // block loop
+                                  0x20, 1, 0x20, 0, 0x59, 0x0d, 1,                // br_if 1 (i >= n)
+                                  0x20, 2, 0x20, 1, 0x7c, 0x21, 2,                // s += i
+                                  0x20, 1, 0x42, 1, 0x7c, 0x21, 1,                // ++i
+                                  0x0c, 0, 0x0b, 0x0b,                            // br 0 end end
+                                  0x20, 2, 0x0b,
+                              });
+    b.exportFunc("sum", f);
+    return b.build();
+}
+
+// number of primes below n, with one flag byte per number at address 0
+// (func (export "sieve") (param $n i32) (result i32) (local $i i32) (local $j i32) (local $count i32)
+//   (memory.fill (i32.const 0) (i32.const 0) (local.get $n))
+//   (local.set $i (i32.const 2))
+//   (block (loop
+//     (br_if 1 (i32.ge_u (local.get $i) (local.get $n)))
+//     (if (i32.eqz (i32.load8_u (local.get $i))) (then
+//       (local.set $count (i32.add (local.get $count) (i32.const 1)))
+//       (local.set $j (i32.add (local.get $i) (local.get $i)))
+//       (block (loop
+//         (br_if 1 (i32.ge_u (local.get $j) (local.get $n)))
+//         (i32.store8 (local.get $j) (i32.const 1))
+//         (local.set $j (i32.add (local.get $j) (local.get $i)))
+//         (br 0)))))
+//     (local.set $i (i32.add (local.get $i) (i32.const 1)))
+//     (br 0)))
+//   (local.get $count))
+inline Bytes sieve() {
+    ModuleBuilder b;
+    const uint32_t f = b.func(b.type({I32}, {I32}), {{3, I32}},
+                              {
+                                  0x41, 0, 0x41, 0, 0x20, 0, 0xfc, 11, 0,    // memory.fill 0 0 n
+                                  0x41, 2, 0x21, 1,                          // i = 2
+                                  0x02, 0x40, 0x03, 0x40,                    // block loop
+                                  0x20, 1, 0x20, 0, 0x4f, 0x0d, 1,           //   br_if 1 (i >= n)
+                                  0x20, 1, 0x2d, 0, 0, 0x45,                 //   !flags[i]
+                                  0x04, 0x40,                                //   if
+                                  0x20, 3, 0x41, 1, 0x6a, 0x21, 3,           //     ++count
+                                  0x20, 1, 0x20, 1, 0x6a, 0x21, 2,           //     j = i + i
+                                  0x02, 0x40, 0x03, 0x40,                    //     block loop
+                                  0x20, 2, 0x20, 0, 0x4f, 0x0d, 1,           //       br_if 1 (j >= n)
+                                  0x20, 2, 0x41, 1, 0x3a, 0, 0,              //       flags[j] = 1
+                                  0x20, 2, 0x20, 1, 0x6a, 0x21, 2,           //       j += i
+                                  0x0c, 0, 0x0b, 0x0b,                       //     br 0 end end
+                                  0x0b,                                      //   end if
+                                  0x20, 1, 0x41, 1, 0x6a, 0x21, 1,           //   ++i
+                                  0x0c, 0, 0x0b, 0x0b,                       // br 0 end end
+                                  0x20, 3, 0x0b,
+                              });
+    b.memory(16);
+    b.exportFunc("sieve", f);
+    return b.build();
+}
+
+} // namespace wasm::samples
@@ -1,19 +1,59 @@
-#include<stdio.h>
-#include<iostream>
-#include<string>
+// UVa 482 - Permutation Arrays
+//
+// Each case is a line of indices and a line of as many numbers; number
+// i goes to position index[i]. The numbers are printed exactly as given,
+// so they stay text and are never parsed. Cases are separated by blank
+// lines, in the input and the output.
+//
+// I/O goes through fastio.h (FastReader/FastWriter) instead of
+// cin/getchar/endl; for a judge, paste the header in place of the include.
+//
+//   g++ -std=c++20 -O2 -I../../learningprojs/ioexamples U482.cpp -o U482 && ./U482 < input.txt
 
-using namespace std;
+#include "fastio.h"
 
-int main() {
-   // x is original array
-   // x' is permuted array
-    int N, v;
-    float k;
-    cin >> N;
-    cout << N << endl;
-    while (N--) {
-        getchar();
-        cout << k << endl;
+#include <algorithm>
+#include <charconv>
+#include <string_view>
+#include <vector>
+
+int main()
+{
+    FastReader in;
+    FastWriter out;
+    int cases = 0;
+    in >> cases;
+    std::string_view line;
+    in.readLine(line); // rest of the count's line
+
+    std::vector<size_t> index;
+    std::vector<std::string_view> placed;
+    for (int c = 0; c < cases; ++c) {
+        while (in.readLine(line) && line.find_first_not_of(" \t") == std::string_view::npos) {
+        }
+        index.clear();
+        for (const char* p = line.data(); p != line.data() + line.size();) {
+            size_t i;
+            const auto [next, ec] = std::from_chars(p, line.data() + line.size(), i);
+            if (ec == std::errc()) index.push_back(i);
+            p = ec == std::errc() ? next : p + 1;
+        }
+
+        // the numbers' line stays valid until the next readLine
+        in.readLine(line);
+        placed.assign(index.size(), {});
+        size_t k = 0;
+        for (size_t pos = 0; k < index.size();) {
+            const size_t start = line.find_first_not_of(" \t", pos);
+            if (start == std::string_view::npos) break;
+            const size_t end = std::min(line.find_first_of(" \t", start), line.size());
+            if (index[k] >= 1 && index[k] <= placed.size()) placed[index[k] - 1] = line.substr(start, end - start);
+            ++k;
+            pos = end;
+        }
+
+        if (c > 0) out << '\n';
+        for (std::string_view number : placed) out << number << '\n';
     }
     return 0;
-}
\ No newline at end of file
+}